@@ -27,5 +27,21 @@ int main(int argc, char **argv) {
     g.compile_to_header("pipeline_c.h", args, "pipeline_c");
     g.compile_to_object("pipeline_native.o", args, "pipeline_native");
     g.compile_to_c("pipeline_c.cpp", args, "pipeline_c");
+
+    // A vectorized pipeline, for comparing the speed of the vector
+    // code in the C output to the native code.
+    Func blur_x("blur_x"), blur_y("blur_y");
+    Var xi, yi;
+    blur_x(x, y) = (cast<uint32_t>(input(x, y)) + input(x+1, y) + input(x+2, y))/3;
+    Expr avg = (blur_x(x, y) + blur_x(x, y+1) + blur_x(x, y+2))/3;
+    blur_y(x, y) = cast<uint16_t>(select(avg > 60000, 65535 - avg/2, max(avg, 100)));
+
+    blur_y.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8);
+    blur_x.compute_at(blur_y, x).vectorize(x, 8);
+
+    blur_y.compile_to_header("pipeline_vectorized_native.h", args, "pipeline_vectorized_native");
+    blur_y.compile_to_header("pipeline_vectorized_c.h", args, "pipeline_vectorized_c");
+    blur_y.compile_to_object("pipeline_vectorized_native.o", args, "pipeline_vectorized_native");
+    blur_y.compile_to_c("pipeline_vectorized_c.cpp", args, "pipeline_vectorized_c");
     return 0;
 }
@@ -2,9 +2,12 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "benchmark.h"
 #include "halide_image.h"
 #include "pipeline_c.h"
 #include "pipeline_native.h"
+#include "pipeline_vectorized_c.h"
+#include "pipeline_vectorized_native.h"
 
 using namespace Halide::Tools;
 
@@ -62,6 +65,28 @@ int main(int argc, char **argv) {
         }
     }
 
+    Image<uint16_t> blur_native(1024, 320);
+    Image<uint16_t> blur_c(1024, 320);
+
+    double native_time = benchmark(10, 10, [&]() { pipeline_vectorized_native(in, blur_native); });
+    double c_time = benchmark(10, 10, [&]() { pipeline_vectorized_c(in, blur_c); });
+
+    for (int y = 0; y < blur_native.height(); y++) {
+        for (int x = 0; x < blur_native.width(); x++) {
+            if (blur_native(x, y) != blur_c(x, y)) {
+                printf("blur_native(%d, %d) = %d, but blur_c(%d, %d) = %d\n",
+                       x, y, blur_native(x, y),
+                       x, y, blur_c(x, y));
+                return -1;
+            }
+        }
+    }
+
+    double pixels = blur_native.width() * blur_native.height();
+    printf("Vectorized pipeline: native %f ms (%f MPix/s), C %f ms (%f MPix/s)\n",
+           native_time * 1e3, pixels / native_time * 1e-6,
+           c_time * 1e3, pixels / c_time * 1e-6);
+
     printf("Success!\n");
     return 0;
 }
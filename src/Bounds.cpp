@@ -88,10 +88,32 @@ public:
     const FuncValueBounds &func_bounds;
 
     Bounds(const Scope<Interval> *s, const FuncValueBounds &fb) :
-        func_bounds(fb) {
+        func_bounds(fb), cache(1) {
         scope.set_containing_scope(s);
     }
+
+    // Compute the bounds of a subexpression, reusing the answer if we
+    // already have it. Exprs are DAGs, and without this, shared
+    // subexpressions get revisited once per path to them, which is
+    // exponential in the depth of the sharing. It also means the
+    // bounds of shared subexpressions come out shared too, so later
+    // CSE finds them. There's one cache per let that's in scope,
+    // because the bounds of anything in a let body may depend on the
+    // bounds of the let. The Expr in the cache keeps the key alive.
+    void bounds_of(Expr e) {
+        map<const IRNode *, pair<Expr, Interval> >::iterator iter = cache.back().find(e.ptr);
+        if (iter != cache.back().end()) {
+            min = iter->second.second.min;
+            max = iter->second.second.max;
+            return;
+        }
+        e.accept(this);
+        // Lets inside e push and pop caches, which may move them.
+        cache.back()[e.ptr] = make_pair(e, Interval(min, max));
+    }
+
 private:
+    vector<map<const IRNode *, pair<Expr, Interval> > > cache;
 
     // Compute the intrinsic bounds of a function.
     void bounds_of_func(Function f, int value_index) {
@@ -139,7 +161,7 @@ private:
 
     void visit(const Cast *op) {
 
-        op->value.accept(this);
+        bounds_of(op->value);
         Expr min_a = min, max_a = max;
 
         if (min_a.same_as(op->value) && max_a.same_as(op->value)) {
@@ -219,9 +241,9 @@ private:
     }
 
     void visit(const Add *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
 
         if (min_a.same_as(op->a) && max_a.same_as(op->a) &&
@@ -261,9 +283,9 @@ private:
     }
 
     void visit(const Sub *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
 
         if (min_a.same_as(op->a) && max_a.same_as(op->a) &&
@@ -312,13 +334,13 @@ private:
     }
 
     void visit(const Mul *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
         if (!min_a.defined() || !max_a.defined()) {
             min = Expr(); max = Expr(); return;
         }
 
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
         if (!min_b.defined() || !max_b.defined()) {
             min = Expr(); max = Expr(); return;
@@ -399,9 +421,9 @@ private:
     }
 
     void visit(const Div *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
         if (!min_b.defined() || !max_b.defined()) {
             min = Expr(); max = Expr(); return;
@@ -463,10 +485,10 @@ private:
     }
 
     void visit(const Mod *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
 
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
         if (!min_b.defined() || !max_b.defined()) {
             min = Expr(); max = Expr(); return;
@@ -504,9 +526,9 @@ private:
     }
 
     void visit(const Min *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
 
         debug(3) << "Bounds of " << Expr(op) << "\n";
@@ -541,9 +563,9 @@ private:
 
 
     void visit(const Max *op) {
-        op->a.accept(this);
+        bounds_of(op->a);
         Expr min_a = min, max_a = max;
-        op->b.accept(this);
+        bounds_of(op->b);
         Expr min_b = min, max_b = max;
 
         debug(3) << "Bounds of " << Expr(op) << "\n";
@@ -622,13 +644,13 @@ private:
     }
 
     void visit(const Select *op) {
-        op->true_value.accept(this);
+        bounds_of(op->true_value);
         Expr min_a = min, max_a = max;
         if (!min_a.defined() || !max_a.defined()) {
             min = Expr(); max = Expr(); return;
         }
 
-        op->false_value.accept(this);
+        bounds_of(op->false_value);
         Expr min_b = min, max_b = max;
         if (!min_b.defined() || !max_b.defined()) {
             min = Expr(); max = Expr(); return;
@@ -648,7 +670,7 @@ private:
     }
 
     void visit(const Load *op) {
-        op->index.accept(this);
+        bounds_of(op->index);
         if (min.defined() && min.same_as(max)) {
             // If the index is const we can return the load of that index
             min = max = Load::make(op->type, op->name, min, op->image, op->param);
@@ -675,7 +697,7 @@ private:
         std::vector<Expr> new_args(op->args.size());
         bool const_args = true;
         for (size_t i = 0; i < op->args.size() && const_args; i++) {
-            op->args[i].accept(this);
+            bounds_of(op->args[i]);
             if (min.defined() && min.same_as(max)) {
                 new_args[i] = min;
             } else {
@@ -713,20 +735,20 @@ private:
             }
         } else if (op->call_type == Call::Intrinsic && op->name == Call::likely) {
             assert(op->args.size() == 1);
-            op->args[0].accept(this);
+            bounds_of(op->args[0]);
         } else if (op->call_type == Call::Intrinsic && op->name == Call::return_second) {
             assert(op->args.size() == 2);
-            op->args[1].accept(this);
+            bounds_of(op->args[1]);
         } else if (op->call_type == Call::Intrinsic && op->name == Call::if_then_else) {
             assert(op->args.size() == 3);
             // Probably more conservative than necessary
             Expr equivalent_select = Select::make(op->args[0], op->args[1], op->args[2]);
-            equivalent_select.accept(this);
+            bounds_of(equivalent_select);
         } else if (op->call_type == Call::Intrinsic &&
                    (op->name == Call::shift_left || op->name == Call::shift_right || op->name == Call::bitwise_and)) {
             Expr simplified = simplify(op);
             if (!simplified.same_as(op)) {
-                simplified.accept(this);
+                bounds_of(simplified);
             } else {
                 // Just use the bounds of the type
                 bounds_of_type(op->type);
@@ -762,11 +784,11 @@ private:
             max = Call::make(Int(32), Call::extract_buffer_max, op->args, Call::Intrinsic);
         } else if (op->call_type == Call::Intrinsic && op->name == Call::memoize_expr) {
             internal_assert(op->args.size() >= 1);
-            op->args[0].accept(this);
+            bounds_of(op->args[0]);
         } else if (op->call_type == Call::Intrinsic && op->name == Call::trace_expr) {
             // trace_expr returns argument 4
             internal_assert(op->args.size() >= 5);
-            op->args[4].accept(this);
+            bounds_of(op->args[4]);
         } else if (op->func.has_pure_definition()) {
             bounds_of_func(op->func, op->value_index);
         } else {
@@ -776,7 +798,7 @@ private:
     }
 
     void visit(const Let *op) {
-        op->value.accept(this);
+        bounds_of(op->value);
         Expr min_val = min, max_val = max;
 
         // We'll either substitute the values in directly, or pass
@@ -805,7 +827,9 @@ private:
         }
 
         scope.push(op->name, Interval(min_var, max_var));
-        op->body.accept(this);
+        cache.push_back(map<const IRNode *, pair<Expr, Interval> >());
+        bounds_of(op->body);
+        cache.pop_back();
         scope.pop(op->name);
 
         if (min.defined()) {
@@ -867,7 +891,7 @@ private:
 Interval bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const FuncValueBounds &fb) {
     //debug(3) << "computing bounds_of_expr_in_scope " << expr << "\n";
     Bounds b(&scope, fb);
-    expr.accept(&b);
+    b.bounds_of(expr);
     //debug(3) << "bounds_of_expr_in_scope " << expr << " = " << simplify(b.min) << ", " << simplify(b.max) << "\n";
     return Interval(b.min, b.max);
 }
@@ -1084,6 +1108,32 @@ private:
     Scope<Interval> scope;
     const FuncValueBounds &func_bounds;
 
+    // The bounds of the exprs we've seen in the current scope, so
+    // that the bounds of an expression that's used more than once
+    // (e.g. a loop min) are only computed once. This is emptied
+    // whenever the scope changes.
+    map<const IRNode *, pair<Expr, Interval> > bounds_cache;
+
+    Interval bounds_of(Expr e) {
+        map<const IRNode *, pair<Expr, Interval> >::iterator iter = bounds_cache.find(e.ptr);
+        if (iter != bounds_cache.end()) {
+            return iter->second.second;
+        }
+        Interval i = bounds_of_expr_in_scope(e, scope, func_bounds);
+        bounds_cache[e.ptr] = make_pair(e, i);
+        return i;
+    }
+
+    void push_var(const string &name, Interval i) {
+        scope.push(name, i);
+        bounds_cache.clear();
+    }
+
+    void pop_var(const string &name) {
+        scope.pop(name);
+        bounds_cache.clear();
+    }
+
     using IRGraphVisitor::visit;
 
     void visit(const Call *op) {
@@ -1121,7 +1171,7 @@ private:
         b.used = const_true();
         for (size_t i = 0; i < op->args.size(); i++) {
             op->args[i].accept(this);
-            b[i] = bounds_of_expr_in_scope(op->args[i], scope, func_bounds);
+            b[i] = bounds_of(op->args[i]);
         }
         merge_boxes(boxes[op->name], b);
     }
@@ -1156,23 +1206,23 @@ private:
         if (consider_calls) {
             op->value.accept(this);
         }
-        Interval value_bounds = bounds_of_expr_in_scope(op->value, scope, func_bounds);
+        Interval value_bounds = bounds_of(op->value);
         value_bounds.min = simplify(value_bounds.min);
         value_bounds.max = simplify(value_bounds.max);
 
         if (is_small_enough_to_substitute(value_bounds.min) &&
             is_small_enough_to_substitute(value_bounds.max)) {
-            scope.push(op->name, value_bounds);
+            push_var(op->name, value_bounds);
             op->body.accept(this);
-            scope.pop(op->name);
+            pop_var(op->name);
         } else {
             string max_name = unique_name('t');
             string min_name = unique_name('t');
 
-            scope.push(op->name, Interval(Variable::make(op->value.type(), min_name),
+            push_var(op->name, Interval(Variable::make(op->value.type(), min_name),
                                           Variable::make(op->value.type(), max_name)));
             op->body.accept(this);
-            scope.pop(op->name);
+            pop_var(op->name);
 
             for (pair<const string, Box> &i : boxes) {
                 Box &box = i.second;
@@ -1198,11 +1248,82 @@ private:
         visit_let(op);
     }
 
+    // If a condition bounds a variable in scope (e.g. the guard on
+    // the tail of a loop split with TailStrategy::GuardWithIf), push
+    // a tighter interval for that variable. Records the names pushed
+    // so that the caller can pop them again.
+    void push_bounds_from_condition(Expr cond, vector<string> &pushed) {
+        if (const Call *c = cond.as<Call>()) {
+            if (c->call_type == Call::Intrinsic && c->name == Call::likely) {
+                push_bounds_from_condition(c->args[0], pushed);
+            }
+            return;
+        } else if (const And *a = cond.as<And>()) {
+            push_bounds_from_condition(a->a, pushed);
+            push_bounds_from_condition(a->b, pushed);
+            return;
+        }
+
+        // Canonicalize to a < b or a <= b
+        Expr a, b;
+        bool strict = false;
+        if (const LT *lt = cond.as<LT>()) {
+            a = lt->a;
+            b = lt->b;
+            strict = true;
+        } else if (const LE *le = cond.as<LE>()) {
+            a = le->a;
+            b = le->b;
+        } else if (const GT *gt = cond.as<GT>()) {
+            a = gt->b;
+            b = gt->a;
+            strict = true;
+        } else if (const GE *ge = cond.as<GE>()) {
+            a = ge->b;
+            b = ge->a;
+        } else {
+            return;
+        }
+
+        if (a.type() != Int(32)) {
+            return;
+        }
+
+        const Variable *var_a = a.as<Variable>();
+        const Variable *var_b = b.as<Variable>();
+        if (var_a && scope.contains(var_a->name) && !expr_uses_var(b, var_a->name)) {
+            // An upper bound on var_a
+            Interval in = scope.get(var_a->name);
+            Expr bound = bounds_of(b).max;
+            if (!bound.defined()) return;
+            if (strict) bound -= 1;
+            in.max = in.max.defined() ? min(in.max, bound) : bound;
+            push_var(var_a->name, in);
+            pushed.push_back(var_a->name);
+        } else if (var_b && scope.contains(var_b->name) && !expr_uses_var(a, var_b->name)) {
+            // A lower bound on var_b
+            Interval in = scope.get(var_b->name);
+            Expr bound = bounds_of(a).min;
+            if (!bound.defined()) return;
+            if (strict) bound += 1;
+            in.min = in.min.defined() ? max(in.min, bound) : bound;
+            push_var(var_b->name, in);
+            pushed.push_back(var_b->name);
+        }
+    }
+
     void visit(const IfThenElse *op) {
         op->condition.accept(this);
 
         if (expr_uses_vars(op->condition, scope)) {
+            // Tighten the bounds of any variables constrained by the
+            // condition while visiting the then case.
+            vector<string> pushed;
+            push_bounds_from_condition(op->condition, pushed);
             op->then_case.accept(this);
+            for (const string &name : pushed) {
+                pop_var(name);
+            }
             if (op->else_case.defined()) {
                 op->else_case.accept(this);
             }
@@ -1268,20 +1389,20 @@ private:
         if (scope.contains(op->name + ".loop_min")) {
             min_val = scope.get(op->name + ".loop_min").min;
         } else {
-            min_val = bounds_of_expr_in_scope(op->min, scope, func_bounds).min;
+            min_val = bounds_of(op->min).min;
         }
 
         if (scope.contains(op->name + ".loop_max")) {
             max_val = scope.get(op->name + ".loop_max").max;
         } else {
-            max_val = bounds_of_expr_in_scope(op->extent, scope, func_bounds).max;
-            max_val += bounds_of_expr_in_scope(op->min, scope, func_bounds).max;
+            max_val = bounds_of(op->extent).max;
+            max_val += bounds_of(op->min).max;
             max_val -= 1;
         }
 
-        scope.push(op->name, Interval(min_val, max_val));
+        push_var(op->name, Interval(min_val, max_val));
         op->body.accept(this);
-        scope.pop(op->name);
+        pop_var(op->name);
     }
 
     void visit(const Provide *op) {
@@ -1289,7 +1410,7 @@ private:
             if (op->name == func || func.empty()) {
                 Box b(op->args.size());
                 for (size_t i = 0; i < op->args.size(); i++) {
-                    b[i] = bounds_of_expr_in_scope(op->args[i], scope, func_bounds);
+                    b[i] = bounds_of(op->args[i]);
                 }
                 merge_boxes(boxes[op->name], b);
             }
@@ -1509,6 +1630,19 @@ void bounds_test() {
     check(scope, cast<uint16_t>(u8_1) + cast<uint16_t>(u8_2),
           cast<uint16_t>(0), cast<uint16_t>(255*2));
 
+    // Each level of this uses the previous one twice, so it would
+    // take 2^64 steps to bound without reusing the bounds of shared
+    // subexpressions.
+    {
+        Expr e = x;
+        for (int i = 0; i < 64; i++) {
+            e = e + e;
+        }
+        FuncValueBounds fb;
+        Interval result = bounds_of_expr_in_scope(e, scope, fb);
+        internal_assert(result.min.defined() && result.max.defined());
+    }
+
     vector<Expr> input_site_1 = {2*x};
     vector<Expr> input_site_2 = {2*x+1};
     vector<Expr> output_site = {x+1};
@@ -46,6 +46,40 @@ bool depends_on_bounds_inference(Expr e) {
     return d.result;
 }
 
+/** Compute the max of the region of some dimension of a stage that
+ * its loop nest actually computes, given the region required. Splits
+ * using TailStrategy::RoundUp (the default for pure vars of update
+ * definitions) compute up to the next multiple of the split factor,
+ * which may in turn require more of the stage's inputs. Returns max
+ * unchanged if there's no rounding. */
+Expr max_computed(const vector<Split> &splits, const string &var, Expr min, Expr max, bool is_update) {
+    for (const Split &split : splits) {
+        if (split.old_var != var) continue;
+        if (split.is_rename()) {
+            return max_computed(splits, split.outer, min, max, is_update);
+        } else if (split.is_split() &&
+                   (split.tail == TailStrategy::RoundUp ||
+                    (split.tail == TailStrategy::Auto && is_update && !split.exact))) {
+            Expr outer_max = (max - min + split.factor) / split.factor - 1;
+            outer_max = max_computed(splits, split.outer, 0, outer_max, is_update);
+            return min + outer_max * split.factor + (split.factor - 1);
+        } else {
+            return max;
+        }
+    }
+    return max;
+}
+
+Expr max_computed(const Schedule &sched, const string &var, Expr min, Expr max, bool is_update) {
+    Expr result = max_computed(sched.splits(), var, min, max, is_update);
+    for (const Specialization &s : sched.specializations()) {
+        Expr m = max_computed(Schedule(s.schedule), var, min, max, is_update);
+        if (m.same_as(max)) continue;
+        result = result.same_as(max) ? m : Max::make(result, m);
+    }
+    return result;
+}
+
 
 /** Compute the bounds of the value of some variable defined by an
  * inner let stmt or for loop. E.g. for the stmt:
@@ -407,11 +441,15 @@ public:
         // A scope giving the bounds for variables used by this stage
         void populate_scope(Scope<Interval> &result) {
 
+            const Schedule &sched = stage == 0 ? func.schedule() : func.updates()[stage - 1].schedule;
             for (size_t d = 0; d < func.args().size(); d++) {
                 string arg = name + ".s" + std::to_string(stage) + "." + func.args()[d];
-                result.push(func.args()[d],
-                            Interval(Variable::make(Int(32), arg + ".min"),
-                                     Variable::make(Int(32), arg + ".max")));
+                Expr min = Variable::make(Int(32), arg + ".min");
+                Expr max = Variable::make(Int(32), arg + ".max");
+                // The loop nest may compute more than the region
+                // required if it rounds up the extent.
+                max = max_computed(sched, func.args()[d], min, max, stage > 0);
+                result.push(func.args()[d], Interval(min, max));
             }
             if (stage > 0) {
                 const UpdateDefinition &r = func.updates()[stage - 1];
@@ -675,14 +713,29 @@ public:
             }
         }
 
+        // A function computed with the one we're producing shares
+        // this loop, so we're also producing some of it.
+        int fused = -1;
+        if (producing >= 0 && stages[producing].stage == 0) {
+            for (size_t i = 0; i < stages.size(); i++) {
+                if (stages[i].func.schedule().compute_with_level().func == f.name()) {
+                    fused = i;
+                    break;
+                }
+            }
+        }
+
         in_stages.push(stage_name, 0);
 
         // Figure out how much of it we're producing
-        Box box;
+        Box box, fused_box;
         if (!no_pipelines && producing >= 0) {
             Scope<Interval> empty_scope;
             box = box_provided(body, stages[producing].name, empty_scope, func_bounds);
             internal_assert((int)box.size() == f.dimensions());
+            if (fused >= 0) {
+                fused_box = box_provided(body, stages[fused].name, empty_scope, func_bounds);
+            }
         }
 
         // Recurse.
@@ -744,6 +797,17 @@ public:
                 }
             }
 
+            // And for the function computed with it.
+            if (fused >= 0 && !inner_productions.empty()) {
+                const Stage &s = stages[fused];
+                for (size_t i = 0; i < fused_box.size(); i++) {
+                    if (!fused_box[i].min.defined() || !fused_box[i].max.defined()) continue;
+                    string var = s.name + ".s0." + s.func.args()[i];
+                    body = LetStmt::make(var + ".max", fused_box[i].max, body);
+                    body = LetStmt::make(var + ".min", fused_box[i].min, body);
+                }
+            }
+
             // And the current bounds on its reduction variables.
             if (producing >= 0 && stages[producing].stage > 0) {
                 const Stage &s = stages[producing];
@@ -154,204 +154,171 @@ CodeGen_ARM::CodeGen_ARM(Target target) : CodeGen_Posix(target) {
             tsmax = simplify(cast(ws, t.max()));
         }
 
-        Pattern p("", "", intrin_width, Expr(), Pattern::NarrowArgs);
+        string intrin32, intrin64;
+        auto add_cast = [&](Expr pattern) {
+            casts.add(Pattern(target.bits == 32 ? intrin32 : intrin64,
+                              intrin_width, pattern, Pattern::NarrowArgs));
+        };
 
         // Rounding-up averaging
         if (t.is_int()) {
-            p.intrin32 = "llvm.arm.neon.vrhadds" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.srhadd" + t_str;
+            intrin32 = "llvm.arm.neon.vrhadds" + t_str;
+            intrin64 = "llvm.aarch64.neon.srhadd" + t_str;
         } else {
-            p.intrin32 = "llvm.arm.neon.vrhaddu" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.urhadd" + t_str;
+            intrin32 = "llvm.arm.neon.vrhaddu" + t_str;
+            intrin64 = "llvm.aarch64.neon.urhadd" + t_str;
         }
 
-        p.pattern = cast(t, (w_vector + w_vector + 1)/2);
-        casts.push_back(p);
-        p.pattern = cast(t, (w_vector + (w_vector + 1))/2);
-        casts.push_back(p);
-        p.pattern = cast(t, ((w_vector + 1) + w_vector)/2);
-        casts.push_back(p);
+        add_cast(cast(t, (w_vector + w_vector + 1)/2));
+        add_cast(cast(t, (w_vector + (w_vector + 1))/2));
+        add_cast(cast(t, ((w_vector + 1) + w_vector)/2));
 
         // Rounding down averaging
         if (t.is_int()) {
-            p.intrin32 = "llvm.arm.neon.vhadds" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.shadd" + t_str;
+            intrin32 = "llvm.arm.neon.vhadds" + t_str;
+            intrin64 = "llvm.aarch64.neon.shadd" + t_str;
         } else {
-            p.intrin32 = "llvm.arm.neon.vhaddu" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.uhadd" + t_str;
+            intrin32 = "llvm.arm.neon.vhaddu" + t_str;
+            intrin64 = "llvm.aarch64.neon.uhadd" + t_str;
         }
-        p.pattern = cast(t, (w_vector + w_vector)/2);
-        casts.push_back(p);
+        add_cast(cast(t, (w_vector + w_vector)/2));
 
         // Halving subtract
         if (t.is_int()) {
-            p.intrin32 = "llvm.arm.neon.vhsubs" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.shsub" + t_str;
+            intrin32 = "llvm.arm.neon.vhsubs" + t_str;
+            intrin64 = "llvm.aarch64.neon.shsub" + t_str;
         } else {
-            p.intrin32 = "llvm.arm.neon.vhsubu" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.uhsub" + t_str;
+            intrin32 = "llvm.arm.neon.vhsubu" + t_str;
+            intrin64 = "llvm.aarch64.neon.uhsub" + t_str;
         }
-        p.pattern = cast(t, (w_vector - w_vector)/2);
-        casts.push_back(p);
+        add_cast(cast(t, (w_vector - w_vector)/2));
 
         // Saturating add
         if (t.is_int()) {
-            p.intrin32 = "llvm.arm.neon.vqadds" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.sqadd" + t_str;
+            intrin32 = "llvm.arm.neon.vqadds" + t_str;
+            intrin64 = "llvm.aarch64.neon.sqadd" + t_str;
         } else {
-            p.intrin32 = "llvm.arm.neon.vqaddu" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.uqadd" + t_str;
+            intrin32 = "llvm.arm.neon.vqaddu" + t_str;
+            intrin64 = "llvm.aarch64.neon.uqadd" + t_str;
         }
-        p.pattern = cast(t, clamp(w_vector + w_vector, tmin, tmax));
-        casts.push_back(p);
+        add_cast(cast(t, clamp(w_vector + w_vector, tmin, tmax)));
 
         // In the unsigned case, the saturation below is unnecessary
         if (t.is_uint()) {
-            p.pattern = cast(t, min(w_vector + w_vector, tmax));
-            casts.push_back(p);
+            add_cast(cast(t, min(w_vector + w_vector, tmax)));
         }
 
         // Saturating subtract
         // N.B. Saturating subtracts always widen to a signed type
         if (t.is_int()) {
-            p.intrin32 = "llvm.arm.neon.vqsubs" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.sqsub" + t_str;
+            intrin32 = "llvm.arm.neon.vqsubs" + t_str;
+            intrin64 = "llvm.aarch64.neon.sqsub" + t_str;
         } else {
-            p.intrin32 = "llvm.arm.neon.vqsubu" + t_str;
-            p.intrin64 = "llvm.aarch64.neon.uqsub" + t_str;
+            intrin32 = "llvm.arm.neon.vqsubu" + t_str;
+            intrin64 = "llvm.aarch64.neon.uqsub" + t_str;
         }
-        p.pattern = cast(t, clamp(ws_vector - ws_vector, tsmin, tsmax));
-        casts.push_back(p);
+        add_cast(cast(t, clamp(ws_vector - ws_vector, tsmin, tsmax)));
 
         // In the unsigned case, we may detect that the top of the clamp is unnecessary
         if (t.is_uint()) {
-            p.pattern = cast(t, max(ws_vector - ws_vector, 0));
-            casts.push_back(p);
+            add_cast(cast(t, max(ws_vector - ws_vector, 0)));
         }
     }
 
-    casts.push_back(Pattern("vqshiftns.v8i8",  "sqshrn.v8i8",  8, _i8q(wild_i16x_/wild_i16x_),  Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftns.v4i16", "sqshrn.v4i16", 4, _i16q(wild_i32x_/wild_i32x_), Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftns.v2i32", "sqshrn.v2i32", 2, _i32q(wild_i64x_/wild_i64x_), Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftnu.v8i8",  "uqshrn.v8i8",  8, _u8q(wild_u16x_/wild_u16x_),  Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftnu.v4i16", "uqshrn.v4i16", 4, _u16q(wild_u32x_/wild_u32x_), Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftnu.v2i32", "uqshrn.v2i32", 2, _u32q(wild_u64x_/wild_u64x_), Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftnsu.v8i8",  "sqshrun.v8i8",  8, _u8q(wild_i16x_/wild_i16x_),  Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftnsu.v4i16", "sqshrun.v4i16", 4, _u16q(wild_i32x_/wild_i32x_), Pattern::RightShift));
-    casts.push_back(Pattern("vqshiftnsu.v2i32", "sqshrun.v2i32", 2, _u32q(wild_i64x_/wild_i64x_), Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftns.v8i8",  "sqshrn.v8i8",  8, _i8q(wild_i16x_/wild_i16x_),  Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftns.v4i16", "sqshrn.v4i16", 4, _i16q(wild_i32x_/wild_i32x_), Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftns.v2i32", "sqshrn.v2i32", 2, _i32q(wild_i64x_/wild_i64x_), Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftnu.v8i8",  "uqshrn.v8i8",  8, _u8q(wild_u16x_/wild_u16x_),  Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftnu.v4i16", "uqshrn.v4i16", 4, _u16q(wild_u32x_/wild_u32x_), Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftnu.v2i32", "uqshrn.v2i32", 2, _u32q(wild_u64x_/wild_u64x_), Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftnsu.v8i8",  "sqshrun.v8i8",  8, _u8q(wild_i16x_/wild_i16x_),  Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftnsu.v4i16", "sqshrun.v4i16", 4, _u16q(wild_i32x_/wild_i32x_), Pattern::RightShift));
+    casts.add(arm_pattern("vqshiftnsu.v2i32", "sqshrun.v2i32", 2, _u32q(wild_i64x_/wild_i64x_), Pattern::RightShift));
 
     // Where a 64-bit and 128-bit version exist, we use the 64-bit
     // version only when the args are 64-bits wide.
-    casts.push_back(Pattern("vqshifts.v8i8",  "sqshl.v8i8",  8, _i8q(_i16(wild_i8x8)*wild_i16x8), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshifts.v4i16", "sqshl.v4i16", 4, _i16q(_i32(wild_i16x4)*wild_i32x4), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshifts.v2i32", "sqshl.v2i32", 2, _i32q(_i64(wild_i32x2)*wild_i64x2), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftu.v8i8",  "uqshl.v8i8",  8, _u8q(_u16(wild_u8x8)*wild_u16x8), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftu.v4i16", "uqshl.v4i16", 4, _u16q(_u32(wild_u16x4)*wild_u32x4), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftu.v2i32", "uqshl.v2i32", 2, _u32q(_u64(wild_u32x2)*wild_u64x2), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftsu.v8i8",  "sqshlu.v8i8",  8, _u8q(_i16(wild_i8x8)*wild_i16x8), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftsu.v4i16", "sqshlu.v4i16", 4, _u16q(_i32(wild_i16x4)*wild_i32x4), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftsu.v2i32", "sqshlu.v2i32", 2, _u32q(_i64(wild_i32x2)*wild_i64x2), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshifts.v8i8",  "sqshl.v8i8",  8, _i8q(_i16(wild_i8x8)*wild_i16x8), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshifts.v4i16", "sqshl.v4i16", 4, _i16q(_i32(wild_i16x4)*wild_i32x4), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshifts.v2i32", "sqshl.v2i32", 2, _i32q(_i64(wild_i32x2)*wild_i64x2), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftu.v8i8",  "uqshl.v8i8",  8, _u8q(_u16(wild_u8x8)*wild_u16x8), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftu.v4i16", "uqshl.v4i16", 4, _u16q(_u32(wild_u16x4)*wild_u32x4), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftu.v2i32", "uqshl.v2i32", 2, _u32q(_u64(wild_u32x2)*wild_u64x2), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftsu.v8i8",  "sqshlu.v8i8",  8, _u8q(_i16(wild_i8x8)*wild_i16x8), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftsu.v4i16", "sqshlu.v4i16", 4, _u16q(_i32(wild_i16x4)*wild_i32x4), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftsu.v2i32", "sqshlu.v2i32", 2, _u32q(_i64(wild_i32x2)*wild_i64x2), Pattern::LeftShift));
 
     // We use the 128-bit version for all other vector widths.
-    casts.push_back(Pattern("vqshifts.v16i8", "sqshl.v16i8", 16, _i8q(_i16(wild_i8x_)*wild_i16x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshifts.v8i16", "sqshl.v8i16",  8, _i16q(_i32(wild_i16x_)*wild_i32x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshifts.v4i32", "sqshl.v4i32",  4, _i32q(_i64(wild_i32x_)*wild_i64x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftu.v16i8", "uqshl.v16i8",  16, _u8q(_u16(wild_u8x_)*wild_u16x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftu.v8i16", "uqshl.v8i16",  8, _u16q(_u32(wild_u16x_)*wild_u32x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftu.v4i32", "uqshl.v4i32",  4, _u32q(_u64(wild_u32x_)*wild_u64x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftsu.v16i8", "sqshlu.v16i8", 16, _u8q(_i16(wild_i8x_)*wild_i16x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftsu.v8i16", "sqshlu.v8i16", 8, _u16q(_i32(wild_i16x_)*wild_i32x_), Pattern::LeftShift));
-    casts.push_back(Pattern("vqshiftsu.v4i32", "sqshlu.v4i32", 4, _u32q(_i64(wild_i32x_)*wild_i64x_), Pattern::LeftShift));
-
-    casts.push_back(Pattern("vqmovns.v8i8",  "sqxtn.v8i8",    8,  _i8q(wild_i16x_)));
-    casts.push_back(Pattern("vqmovns.v4i16", "sqxtn.v4i16",   4, _i16q(wild_i32x_)));
-    casts.push_back(Pattern("vqmovns.v2i32", "sqxtn.v2i32",   2, _i32q(wild_i64x_)));
-    casts.push_back(Pattern("vqmovnu.v8i8",  "uqxtn.v8i8",    8,  _u8q(wild_u16x_)));
-    casts.push_back(Pattern("vqmovnu.v4i16", "uqxtn.v4i16",   4, _u16q(wild_u32x_)));
-    casts.push_back(Pattern("vqmovnu.v2i32", "uqxtn.v2i32",   2, _u32q(wild_u64x_)));
-    casts.push_back(Pattern("vqmovnsu.v8i8",  "sqxtun.v8i8",  8,  _u8q(wild_i16x_)));
-    casts.push_back(Pattern("vqmovnsu.v4i16", "sqxtun.v4i16", 4, _u16q(wild_i32x_)));
-    casts.push_back(Pattern("vqmovnsu.v2i32", "sqxtun.v2i32", 2, _u32q(wild_i64x_)));
+    casts.add(arm_pattern("vqshifts.v16i8", "sqshl.v16i8", 16, _i8q(_i16(wild_i8x_)*wild_i16x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshifts.v8i16", "sqshl.v8i16",  8, _i16q(_i32(wild_i16x_)*wild_i32x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshifts.v4i32", "sqshl.v4i32",  4, _i32q(_i64(wild_i32x_)*wild_i64x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftu.v16i8", "uqshl.v16i8",  16, _u8q(_u16(wild_u8x_)*wild_u16x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftu.v8i16", "uqshl.v8i16",  8, _u16q(_u32(wild_u16x_)*wild_u32x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftu.v4i32", "uqshl.v4i32",  4, _u32q(_u64(wild_u32x_)*wild_u64x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftsu.v16i8", "sqshlu.v16i8", 16, _u8q(_i16(wild_i8x_)*wild_i16x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftsu.v8i16", "sqshlu.v8i16", 8, _u16q(_i32(wild_i16x_)*wild_i32x_), Pattern::LeftShift));
+    casts.add(arm_pattern("vqshiftsu.v4i32", "sqshlu.v4i32", 4, _u32q(_i64(wild_i32x_)*wild_i64x_), Pattern::LeftShift));
+
+    casts.add(arm_pattern("vqmovns.v8i8",  "sqxtn.v8i8",    8,  _i8q(wild_i16x_)));
+    casts.add(arm_pattern("vqmovns.v4i16", "sqxtn.v4i16",   4, _i16q(wild_i32x_)));
+    casts.add(arm_pattern("vqmovns.v2i32", "sqxtn.v2i32",   2, _i32q(wild_i64x_)));
+    casts.add(arm_pattern("vqmovnu.v8i8",  "uqxtn.v8i8",    8,  _u8q(wild_u16x_)));
+    casts.add(arm_pattern("vqmovnu.v4i16", "uqxtn.v4i16",   4, _u16q(wild_u32x_)));
+    casts.add(arm_pattern("vqmovnu.v2i32", "uqxtn.v2i32",   2, _u32q(wild_u64x_)));
+    casts.add(arm_pattern("vqmovnsu.v8i8",  "sqxtun.v8i8",  8,  _u8q(wild_i16x_)));
+    casts.add(arm_pattern("vqmovnsu.v4i16", "sqxtun.v4i16", 4, _u16q(wild_i32x_)));
+    casts.add(arm_pattern("vqmovnsu.v2i32", "sqxtun.v2i32", 2, _u32q(wild_i64x_)));
 
     // Overflow for int32 is not defined by Halide, so for those we can take
     // advantage of special add-and-halve instructions.
     //
     // 64-bit averaging round-down
-    averagings.push_back(Pattern("vhadds.v2i32", "shadd.v2i32", 2, (wild_i32x2 + wild_i32x2)));
+    averagings.add(arm_pattern("vhadds.v2i32", "shadd.v2i32", 2, (wild_i32x2 + wild_i32x2)));
 
     // 128-bit
-    averagings.push_back(Pattern("vhadds.v4i32", "shadd.v4i32", 4, (wild_i32x_ + wild_i32x_)));
+    averagings.add(arm_pattern("vhadds.v4i32", "shadd.v4i32", 4, (wild_i32x_ + wild_i32x_)));
 
     // 64-bit halving subtract
-    averagings.push_back(Pattern("vhsubs.v2i32", "shsub.v2i32", 2, (wild_i32x2 - wild_i32x2)));
+    averagings.add(arm_pattern("vhsubs.v2i32", "shsub.v2i32", 2, (wild_i32x2 - wild_i32x2)));
 
     // 128-bit
-    averagings.push_back(Pattern("vhsubs.v4i32", "shsub.v4i32", 4, (wild_i32x_ - wild_i32x_)));
+    averagings.add(arm_pattern("vhsubs.v4i32", "shsub.v4i32", 4, (wild_i32x_ - wild_i32x_)));
 
     // 64-bit saturating negation
-    negations.push_back(Pattern("vqneg.v8i8",  "sqneg.v8i8", 8, -max(wild_i8x8, -127)));
-    negations.push_back(Pattern("vqneg.v4i16", "sqneg.v4i16", 4, -max(wild_i16x4, -32767)));
-    negations.push_back(Pattern("vqneg.v2i32", "sqneg.v2i32", 2, -max(wild_i32x2, -(0x7fffffff))));
+    negations.add(arm_pattern("vqneg.v8i8",  "sqneg.v8i8", 8, -max(wild_i8x8, -127)));
+    negations.add(arm_pattern("vqneg.v4i16", "sqneg.v4i16", 4, -max(wild_i16x4, -32767)));
+    negations.add(arm_pattern("vqneg.v2i32", "sqneg.v2i32", 2, -max(wild_i32x2, -(0x7fffffff))));
 
     // 128-bit
-    negations.push_back(Pattern("vqneg.v16i8", "sqneg.v16i8", 16, -max(wild_i8x_, -127)));
-    negations.push_back(Pattern("vqneg.v8i16", "sqneg.v8i16", 8,  -max(wild_i16x_, -32767)));
-    negations.push_back(Pattern("vqneg.v4i32", "sqneg.v4i32", 4,  -max(wild_i32x_, -(0x7fffffff))));
+    negations.add(arm_pattern("vqneg.v16i8", "sqneg.v16i8", 16, -max(wild_i8x_, -127)));
+    negations.add(arm_pattern("vqneg.v8i16", "sqneg.v8i16", 8,  -max(wild_i16x_, -32767)));
+    negations.add(arm_pattern("vqneg.v4i32", "sqneg.v4i32", 4,  -max(wild_i32x_, -(0x7fffffff))));
 }
 
-Value *CodeGen_ARM::call_pattern(const Pattern &p, Type t, const vector<Expr> &args) {
+CodeGen_LLVM::Pattern CodeGen_ARM::arm_pattern(const string &i32, const string &i64, int w, Expr p,
+                                               Pattern::PatternType t) const {
     if (target.bits == 32) {
-        return call_intrin(t, p.intrin_width, p.intrin32, args);
+        return Pattern("llvm.arm.neon." + i32, w, p, t);
     } else {
-        return call_intrin(t, p.intrin_width, p.intrin64, args);
+        return Pattern("llvm.aarch64.neon." + i64, w, p, t);
     }
 }
 
-Value *CodeGen_ARM::call_pattern(const Pattern &p, llvm::Type *t, const vector<llvm::Value *> &args) {
-    if (target.bits == 32) {
-        return call_intrin(t, p.intrin_width, p.intrin32, args);
-    } else {
-        return call_intrin(t, p.intrin_width, p.intrin64, args);
-    }
-}
-
-namespace {
-
-// Try to losslessly narrow an integer expression to the target type
-Expr try_narrow(Expr a, Type target) {
-    internal_assert(a.type().width == target.width);
-    if (const Cast *c = a.as<Cast>()) {
-        Type old_type = c->value.type();
-        if (old_type == target) {
-            return c->value;
-        } else if (target.can_represent(old_type)) {
-            return cast(target, c->value);
-        } else if (c->type.can_represent(target)) {
-            // We lose nothing by stripping off the cast and pressing onwards.
-            return try_narrow(c->value, target);
-        } else {
-            return Expr();
-        }
-    }
-
-    if (const Broadcast *b = a.as<Broadcast>()) {
-        Expr n = try_narrow(b->value, target.element_of());
-        if (n.defined()) {
-            return Broadcast::make(n, b->width);
-        } else {
-            return Expr();
-        }
+Value *CodeGen_ARM::call_shift_pattern(const Pattern &p, Type result_type,
+                                       Expr arg, int shift_amount) {
+    if (p.type == Pattern::LeftShift) {
+        return CodeGen_Posix::call_shift_pattern(p, result_type, arg, shift_amount);
     }
 
-    if (const IntImm *i = a.as<IntImm>()) {
-        if (i->value <= target.imax() &&
-            i->value >= target.imin()) {
-            return cast(target, a);
-        }
+    Value *shift = NULL;
+    if (target.bits == 32) {
+        // The arm32 llvm backend wants right shifts to come in as negative values.
+        shift = ConstantInt::get(llvm_type_of(arg.type()), -shift_amount);
+    } else {
+        // The arm64 llvm backend wants i32 constants for right shifts.
+        shift = ConstantInt::get(i32, shift_amount);
     }
-
-    return Expr();
-}
+    return call_intrin(llvm_type_of(result_type), p.intrin_width, p.intrin,
+                       {codegen(arg), shift});
 }
 
 void CodeGen_ARM::visit(const Cast *op) {
@@ -362,63 +329,11 @@ void CodeGen_ARM::visit(const Cast *op) {
 
     Type t = op->type;
 
-    vector<Expr> matches;
-
-    for (size_t i = 0; i < casts.size() ; i++) {
-        const Pattern &pattern = casts[i];
-        //debug(4) << "Trying pattern: " << patterns[i].intrin << " " << patterns[i].pattern << "\n";
-        if (expr_match(pattern.pattern, op, matches)) {
-
-            //debug(4) << "Match!\n";
-            if (pattern.type == Pattern::Simple) {
-                value = call_pattern(pattern, t, matches);
-                return;
-            } else if (pattern.type == Pattern::NarrowArgs) {
-                // Try to narrow all of the args.
-                bool all_narrow = true;
-                for (size_t i = 0; i < matches.size(); i++) {
-                    internal_assert(matches[i].type().bits == t.bits * 2);
-                    internal_assert(matches[i].type().width == t.width);
-                    // debug(4) << "Attemping to narrow " << matches[i] << " to " << t << "\n";
-                    matches[i] = try_narrow(matches[i], t);
-                    if (!matches[i].defined()) {
-                        // debug(4) << "failed\n";
-                        all_narrow = false;
-                    } else {
-                        // debug(4) << "success: " << matches[i] << "\n";
-                        internal_assert(matches[i].type() == t);
-                    }
-                }
-
-                if (all_narrow) {
-                    value = call_pattern(pattern, t, matches);
-                    return;
-                }
-            } else { // must be a shift
-                Expr constant = matches[1];
-                int shift_amount;
-                bool power_of_two = is_const_power_of_two_integer(constant, &shift_amount);
-                if (power_of_two && shift_amount < matches[0].type().bits) {
-                    if (target.bits == 32 && pattern.type == Pattern::RightShift) {
-                        // The arm32 llvm backend wants right shifts to come in as negative values.
-                        shift_amount = -shift_amount;
-                    }
-                    Value *shift = NULL;
-                    // The arm64 llvm backend wants i32 constants for right shifts.
-                    if (target.bits == 64 && pattern.type == Pattern::RightShift) {
-                        shift = ConstantInt::get(i32, shift_amount);
-                    } else {
-                        shift = ConstantInt::get(llvm_type_of(matches[0].type()), shift_amount);
-                    }
-                    value = call_pattern(pattern, llvm_type_of(t),
-                                         {codegen(matches[0]), shift});
-                    return;
-                }
-            }
-        }
+    if (Value *v = codegen_pattern(casts, op)) {
+        value = v;
+        return;
     }
 
-
     // Catch extract-high-half-of-signed integer pattern and convert
     // it to extract-high-half-of-unsigned-integer. llvm peephole
     // optimization recognizes logical shift right but not arithemtic
@@ -488,30 +403,6 @@ void CodeGen_ARM::visit(const Mul *op) {
         return;
     }
 
-    vector<Expr> matches;
-
-    int shift_amount = 0;
-    bool power_of_two = is_const_power_of_two_integer(op->b, &shift_amount);
-    if (power_of_two) {
-        for (size_t i = 0; i < left_shifts.size(); i++) {
-            const Pattern &pattern = left_shifts[i];
-            internal_assert(pattern.type == Pattern::LeftShift);
-            if (expr_match(pattern.pattern, op, matches)) {
-                llvm::Type *t_arg = llvm_type_of(matches[0].type());
-                llvm::Type *t_result = llvm_type_of(op->type);
-                Value *shift = NULL;
-                if (target.bits == 32) {
-                    shift = ConstantInt::get(t_arg, shift_amount);
-                } else {
-                    shift = ConstantInt::get(i32, shift_amount);
-                }
-                value = call_pattern(pattern, t_result,
-                                     {codegen(matches[0]), shift});
-                return;
-            }
-        }
-    }
-
     CodeGen_Posix::visit(op);
 }
 
@@ -521,14 +412,10 @@ void CodeGen_ARM::visit(const Div *op) {
         return;
     }
 
-    if (op->type.is_vector() && is_two(op->b) &&
-        (op->a.as<Add>() || op->a.as<Sub>())) {
-        vector<Expr> matches;
-        for (size_t i = 0; i < averagings.size(); i++) {
-            if (expr_match(averagings[i].pattern, op->a, matches)) {
-                value = call_pattern(averagings[i], op->type, matches);
-                return;
-            }
+    if (op->type.is_vector() && is_two(op->b)) {
+        if (Value *v = codegen_pattern(averagings, op->a)) {
+            value = v;
+            return;
         }
     }
 
@@ -688,13 +575,9 @@ void CodeGen_ARM::visit(const Sub *op) {
         return;
     }
 
-    vector<Expr> matches;
-    for (size_t i = 0; i < negations.size(); i++) {
-        if (op->type.is_vector() &&
-            expr_match(negations[i].pattern, op, matches)) {
-            value = call_pattern(negations[i], op->type, matches);
-            return;
-        }
+    if (Value *v = codegen_pattern(negations, op)) {
+        value = v;
+        return;
     }
 
     // llvm will generate floating point negate instructions if we ask for (-0.0f)-x
@@ -868,7 +751,8 @@ void CodeGen_ARM::visit(const Max *op) {
 }
 
 void CodeGen_ARM::visit(const Store *op) {
-    if (neon_intrinsics_disabled()) {
+    // Predicated accesses are masked by the generic code.
+    if (neon_intrinsics_disabled() || vector_predicate) {
         CodeGen_Posix::visit(op);
         return;
     }
@@ -1036,7 +920,8 @@ void CodeGen_ARM::visit(const Store *op) {
 }
 
 void CodeGen_ARM::visit(const Load *op) {
-    if (neon_intrinsics_disabled()) {
+    // Predicated accesses are masked by the generic code.
+    if (neon_intrinsics_disabled() || vector_predicate) {
         CodeGen_Posix::visit(op);
         return;
     }
@@ -1197,14 +1082,14 @@ void CodeGen_ARM::visit(const Call *op) {
             if (sub) {
                 Expr a = sub->a, b = sub->b;
                 Type narrow = UInt(a.type().bits/2, a.type().width);
-                Expr na = try_narrow(a, narrow);
-                Expr nb = try_narrow(b, narrow);
+                Expr na = lossless_cast(narrow, a);
+                Expr nb = lossless_cast(narrow, b);
 
                 // Also try an unsigned narrowing
                 if (!na.defined() || !nb.defined()) {
                     narrow = Int(narrow.bits, narrow.width);
-                    na = try_narrow(a, narrow);
-                    nb = try_narrow(b, narrow);
+                    na = lossless_cast(narrow, a);
+                    nb = lossless_cast(narrow, b);
                 }
 
                 if (na.defined() && nb.defined()) {
@@ -35,31 +35,17 @@ protected:
     // @}
 
     /** Various patterns to peephole match against */
-    struct Pattern {
-        std::string intrin32; ///< Name of the intrinsic for 32-bit arm
-        std::string intrin64; ///< Name of the intrinsic for 64-bit arm
-        int intrin_width;     ///< The native vector width of the intrinsic
-        Expr pattern;         ///< The pattern to match against
-        enum PatternType {Simple = 0, ///< Just match the pattern
-                          LeftShift,  ///< Match the pattern if the RHS is a const power of two
-                          RightShift, ///< Match the pattern if the RHS is a const power of two
-                          NarrowArgs  ///< Match the pattern if the args can be losslessly narrowed
-        };
-        PatternType type;
-        Pattern() {}
-        Pattern(const std::string &i32, const std::string &i64, int w, Expr p, PatternType t = Simple) :
-            intrin32("llvm.arm.neon." + i32),
-            intrin64("llvm.aarch64.neon." + i64),
-            intrin_width(w), pattern(p), type(t) {}
-    };
-    std::vector<Pattern> casts, left_shifts, averagings, negations;
+    PatternTable casts, averagings, negations;
 
-    // Call an intrinsic as defined by a pattern. Dispatches to the
-    // 32- or 64-bit name depending on the target's bit width.
-    // @{
-    llvm::Value *call_pattern(const Pattern &p, Type t, const std::vector<Expr> &args);
-    llvm::Value *call_pattern(const Pattern &p, llvm::Type *t, const std::vector<llvm::Value *> &args);
-    // @}
+    /** Make a pattern for a neon intrinsic, using the 32- or 64-bit
+     * name depending on the target's bit width. */
+    Pattern arm_pattern(const std::string &i32, const std::string &i64, int w, Expr p,
+                        Pattern::PatternType t = Pattern::Simple) const;
+
+    /** Neon wants right shifts by negative constants on arm32, and by
+     * i32 constants on arm64. */
+    llvm::Value *call_shift_pattern(const Pattern &p, Type result_type,
+                                    Expr arg, int shift_amount);
 
     std::string mcpu() const;
     std::string mattrs() const;
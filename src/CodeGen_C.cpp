@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -9,6 +10,7 @@
 #include "Var.h"
 #include "Lerp.h"
 #include "Simplify.h"
+#include "IRMutator.h"
 
 namespace Halide {
 namespace Internal {
@@ -19,6 +21,7 @@ using std::string;
 using std::vector;
 using std::ostringstream;
 using std::map;
+using std::pair;
 
 namespace {
 const string buffer_t_definition =
@@ -201,9 +204,85 @@ const string globals =
     " b->stride[3] = stride3;\n"
     " return true;\n"
     "}\n";
+
+// Vectors are gcc/clang vector extensions, wrapped in a struct that
+// gives them Halide's semantics for the things the extensions do
+// differently (comparisons, selects, division) or don't do at all
+// (loads, stores, shuffles, conversions). The extensions need a power
+// of two lanes, so the extra lanes of other widths are unused. The
+// loops are over a constant number of lanes, so compilers turn them
+// into vector code too.
+const string vector_preamble =
+    "template<int Lanes> struct CppVectorMask;\n"
+    "template<typename T, int Lanes, typename Native>\n"
+    "struct CppVector {\n"
+    " typedef typename CppVectorMask<Lanes>::type Mask;\n"
+    " Native native;\n"
+    "\n"
+    " static CppVector empty() {CppVector r; memset(&r, 0, sizeof(r)); return r;}\n"
+    " static CppVector from_native(const Native &n) {CppVector r; r.native = n; return r;}\n"
+    " static CppVector broadcast(T v) {CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = v; return r;}\n"
+    " static CppVector ramp(T base, T stride) {CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = base + stride * i; return r;}\n"
+    " template<typename... Args> static CppVector make(Args... args) {\n"
+    "  T lanes[] = {(T)args...};\n"
+    "  CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = lanes[i]; return r;\n"
+    " }\n"
+    " template<typename Other> static CppVector convert(const Other &o) {CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = (T)o.native[i]; return r;}\n"
+    " static CppVector select(const Mask &c, const CppVector &a, const CppVector &b) {\n"
+    "  CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = c.native[i] ? a.native[i] : b.native[i]; return r;\n"
+    " }\n"
+    " static CppVector load(const void *base, int32_t offset) {CppVector r = empty(); memcpy(&r.native, (const T *)base + offset, sizeof(T) * Lanes); return r;}\n"
+    " template<typename Index> static CppVector gather(const void *base, const Index &offset) {\n"
+    "  CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = ((const T *)base)[offset.native[i]]; return r;\n"
+    " }\n"
+    " void store(void *base, int32_t offset) const {memcpy((T *)base + offset, &native, sizeof(T) * Lanes);}\n"
+    " template<typename Index> void scatter(void *base, const Index &offset) const {\n"
+    "  for (int i = 0; i < Lanes; i++) ((T *)base)[offset.native[i]] = native[i];\n"
+    " }\n"
+    " T operator[](int i) const {return native[i];}\n"
+    "\n"
+    " CppVector operator+(const CppVector &b) const {return from_native(native + b.native);}\n"
+    " CppVector operator-(const CppVector &b) const {return from_native(native - b.native);}\n"
+    " CppVector operator*(const CppVector &b) const {return from_native(native * b.native);}\n"
+    " CppVector operator&(const CppVector &b) const {return from_native(native & b.native);}\n"
+    " CppVector operator|(const CppVector &b) const {return from_native(native | b.native);}\n"
+    " CppVector operator^(const CppVector &b) const {return from_native(native ^ b.native);}\n"
+    " CppVector operator<<(const CppVector &b) const {return from_native(native << b.native);}\n"
+    " CppVector operator>>(const CppVector &b) const {return from_native(native >> b.native);}\n"
+    " CppVector operator&&(const CppVector &b) const {return from_native(native & b.native);}\n"
+    " CppVector operator||(const CppVector &b) const {return from_native(native | b.native);}\n"
+    " CppVector operator-() const {return from_native(-native);}\n"
+    " CppVector operator~() const {return from_native(~native);}\n"
+    " CppVector operator!() const {CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = !native[i]; return r;}\n"
+    " // Division by the unused lanes would trap.\n"
+    " CppVector operator/(const CppVector &b) const {CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] / b.native[i]; return r;}\n"
+    " CppVector operator%(const CppVector &b) const {CppVector r = empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] % b.native[i]; return r;}\n"
+    " Mask operator<(const CppVector &b) const {Mask r = Mask::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] < b.native[i]; return r;}\n"
+    " Mask operator<=(const CppVector &b) const {Mask r = Mask::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] <= b.native[i]; return r;}\n"
+    " Mask operator>(const CppVector &b) const {Mask r = Mask::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] > b.native[i]; return r;}\n"
+    " Mask operator>=(const CppVector &b) const {Mask r = Mask::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] >= b.native[i]; return r;}\n"
+    " Mask operator==(const CppVector &b) const {Mask r = Mask::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] == b.native[i]; return r;}\n"
+    " Mask operator!=(const CppVector &b) const {Mask r = Mask::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = native[i] != b.native[i]; return r;}\n"
+    "};\n"
+    "template<typename T, int Lanes, typename Native>\n"
+    "CppVector<T, Lanes, Native> max(const CppVector<T, Lanes, Native> &a, const CppVector<T, Lanes, Native> &b) {\n"
+    " CppVector<T, Lanes, Native> r = a; for (int i = 0; i < Lanes; i++) r.native[i] = max<T>(a.native[i], b.native[i]); return r;\n"
+    "}\n"
+    "template<typename T, int Lanes, typename Native>\n"
+    "CppVector<T, Lanes, Native> min(const CppVector<T, Lanes, Native> &a, const CppVector<T, Lanes, Native> &b) {\n"
+    " CppVector<T, Lanes, Native> r = a; for (int i = 0; i < Lanes; i++) r.native[i] = min<T>(a.native[i], b.native[i]); return r;\n"
+    "}\n"
+    "template<typename T, int Lanes, typename Native>\n"
+    "CppVector<T, Lanes, Native> sdiv(const CppVector<T, Lanes, Native> &a, const CppVector<T, Lanes, Native> &b) {\n"
+    " CppVector<T, Lanes, Native> r = CppVector<T, Lanes, Native>::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = sdiv<T>(a.native[i], b.native[i]); return r;\n"
+    "}\n"
+    "template<typename T, int Lanes, typename Native>\n"
+    "CppVector<T, Lanes, Native> smod(const CppVector<T, Lanes, Native> &a, const CppVector<T, Lanes, Native> &b) {\n"
+    " CppVector<T, Lanes, Native> r = CppVector<T, Lanes, Native>::empty(); for (int i = 0; i < Lanes; i++) r.native[i] = smod<T>(a.native[i], b.native[i]); return r;\n"
+    "}\n";
 }
 
-CodeGen_C::CodeGen_C(ostream &s, bool is_header, const std::string &guard) : IRPrinter(s), id("$$ BAD ID $$"), is_header(is_header) {
+CodeGen_C::CodeGen_C(ostream &s, bool is_header, const std::string &guard) : IRPrinter(s), id("$$ BAD ID $$"), is_header(is_header), use_cpp_vectors(false) {
     if (is_header) {
         // If it's a header, emit an include guard.
         stream << "#ifndef HALIDE_" << print_name(guard) << '\n'
@@ -250,7 +329,21 @@ CodeGen_C::~CodeGen_C() {
 namespace {
 string type_to_c_type(Type type) {
     ostringstream oss;
-    user_assert(type.width == 1) << "Can't use vector types when compiling to C (yet)\n";
+    if (type.is_vector()) {
+        // Vector types are named like int32x8_t. See add_vector_typedefs.
+        type_to_c_type(type.element_of());
+        user_assert(!type.is_handle()) << "Can't use vectors of handles when compiling to C: " << type << "\n";
+        if (type.is_float()) {
+            oss << "float";
+        } else if (type.is_uint()) {
+            oss << "uint";
+        } else {
+            oss << "int";
+        }
+        oss << type.bits << "x" << type.width << "_t";
+        return oss.str();
+    }
+
     if (type.is_float()) {
         if (type.bits == 32) {
             oss << "float";
@@ -311,6 +404,93 @@ string CodeGen_C::print_name(const string &name) {
 }
 
 namespace {
+class FindVectorTypes : public IRGraphVisitor {
+public:
+    vector<Type> types;
+
+    using IRGraphVisitor::include;
+    void include(const Expr &e) {
+        Type t = e.type();
+        if (t.is_vector() && std::find(types.begin(), types.end(), t) == types.end()) {
+            types.push_back(t);
+        }
+        IRGraphVisitor::include(e);
+    }
+};
+
+// Rewrite the vector operations that the vector types in the C output
+// don't have into ones that they do. This is done to the whole
+// function before printing it, rather than in the visitors, because
+// the GPU backends print these differently.
+class LowerVectorOpsForC : public IRMutator {
+    using IRMutator::visit;
+
+    void visit(const Call *op) {
+        IRMutator::visit(op);
+        op = expr.as<Call>();
+        if (!op || op->type.is_scalar()) return;
+
+        if (op->call_type == Call::Extern) {
+            // There are no vector versions of extern functions, so
+            // call the scalar version on each lane. Bind the vector
+            // args first, so that they're only evaluated once.
+            vector<pair<string, Expr>> lets;
+            vector<Expr> args = op->args;
+            for (size_t i = 0; i < args.size(); i++) {
+                if (args[i].type().is_vector() && !args[i].as<Variable>()) {
+                    string name = unique_name('t');
+                    lets.push_back(std::make_pair(name, args[i]));
+                    args[i] = Variable::make(args[i].type(), name);
+                }
+            }
+            vector<Expr> lanes;
+            for (int j = 0; j < op->type.width; j++) {
+                vector<Expr> lane_args;
+                for (size_t i = 0; i < args.size(); i++) {
+                    if (args[i].type().is_vector()) {
+                        lane_args.push_back(Call::make(args[i].type().element_of(), Call::shuffle_vector,
+                                                       {args[i], j}, Call::Intrinsic));
+                    } else {
+                        lane_args.push_back(args[i]);
+                    }
+                }
+                lanes.push_back(Call::make(op->type.element_of(), op->name, lane_args, Call::Extern));
+            }
+            expr = Call::make(op->type, Call::interleave_vectors, lanes, Call::Intrinsic);
+            for (size_t i = lets.size(); i > 0; i--) {
+                expr = Let::make(lets[i-1].first, lets[i-1].second, expr);
+            }
+        } else if (op->name == Call::abs) {
+            internal_assert(op->args.size() == 1);
+            Expr a = op->args[0];
+            Expr zero = make_zero(a.type());
+            expr = cast(op->type, select(a > zero, a, zero - a));
+        } else if (op->name == Call::absd) {
+            internal_assert(op->args.size() == 2);
+            Expr a = op->args[0], b = op->args[1];
+            expr = cast(op->type, select(a < b, b - a, a - b));
+        }
+    }
+
+    void visit(const Div *op) {
+        IRMutator::visit(op);
+        op = expr.as<Div>();
+        int bits;
+        if (op && op->type.is_vector() && is_const_power_of_two_integer(op->b, &bits)) {
+            expr = Call::make(op->type, Call::shift_right, {op->a, make_const(op->type, bits)}, Call::Intrinsic);
+        }
+    }
+
+    void visit(const Mod *op) {
+        IRMutator::visit(op);
+        op = expr.as<Mod>();
+        int bits;
+        if (op && op->type.is_vector() && is_const_power_of_two_integer(op->b, &bits)) {
+            expr = Call::make(op->type, Call::bitwise_and, {op->a, make_const(op->type, (1 << bits) - 1)}, Call::Intrinsic);
+        }
+    }
+};
+
 class ExternCallPrototypes : public IRGraphVisitor {
     ostream &stream;
     std::set<string> &emitted;
@@ -396,11 +576,16 @@ void CodeGen_C::compile(const LoweredFunc &f) {
         have_user_context |= (args[i].name == "__user_context");
     }
 
-    // Emit prototypes for any extern calls used.
+    Stmt body = f.body;
     if (!is_header) {
+        use_cpp_vectors = true;
+        body = LowerVectorOpsForC().mutate(body);
+        add_vector_typedefs(body);
+
+        // Emit prototypes for any extern calls used.
         stream << "\n";
         ExternCallPrototypes e(stream, emitted);
-        f.body.accept(&e);
+        body.accept(&e);
         stream << "\n";
     }
 
@@ -438,7 +623,7 @@ void CodeGen_C::compile(const LoweredFunc &f) {
             }
         }
         // Emit the body
-        print(f.body);
+        print(body);
 
         // Return success.
         do_indent();
@@ -465,6 +650,57 @@ void CodeGen_C::compile(const LoweredFunc &f) {
     }
 }
 
+void CodeGen_C::add_vector_typedefs(Stmt s) {
+    FindVectorTypes finder;
+    s.accept(&finder);
+
+    // The masks that comparisons of each width return go first,
+    // because the other vector types of that width refer to them.
+    vector<Type> types;
+    for (size_t i = 0; i < finder.types.size(); i++) {
+        Type mask = Bool(finder.types[i].width);
+        if (std::find(types.begin(), types.end(), mask) == types.end()) {
+            types.push_back(mask);
+        }
+    }
+    for (size_t i = 0; i < finder.types.size(); i++) {
+        if (std::find(types.begin(), types.end(), finder.types[i]) == types.end()) {
+            types.push_back(finder.types[i]);
+        }
+    }
+
+    bool first = emitted_vector_types.empty();
+    ostringstream typedefs;
+    for (size_t i = 0; i < types.size(); i++) {
+        Type t = types[i];
+        string name = type_to_c_type(t);
+        if (emitted_vector_types.count(name)) continue;
+        emitted_vector_types.insert(name);
+
+        // The vector extensions only allow a power of two lanes, and
+        // bools are stored as bytes.
+        int lanes = 1;
+        while (lanes < t.width) lanes *= 2;
+        string elem = t.is_bool() ? "uint8_t" : type_to_c_type(t.element_of());
+        string native = name.substr(0, name.size() - 2) + "_native_t";
+        typedefs << "typedef " << elem << " " << native
+                 << " __attribute__((vector_size(" << lanes * t.bytes() << ")));\n"
+                 << "typedef CppVector<" << elem << ", " << t.width << ", " << native << "> " << name << ";\n";
+        if (t.is_bool()) {
+            typedefs << "template<> struct CppVectorMask<" << t.width << "> {typedef " << name << " type;};\n";
+        }
+    }
+
+    if (typedefs.str().empty()) return;
+
+    // This is inside the extern "C" block, and templates need C++ linkage.
+    stream << "extern \"C++\" {\n";
+    if (first) {
+        stream << vector_preamble;
+    }
+    stream << typedefs.str() << "}\n";
+}
+
 void CodeGen_C::compile(const Buffer &buffer) {
     // Don't define buffers in headers.
     if (is_header) {
@@ -628,7 +864,32 @@ void CodeGen_C::visit(const Variable *op) {
 }
 
 void CodeGen_C::visit(const Cast *op) {
-    print_assignment(op->type, "(" + print_type(op->type) + ")(" + print_expr(op->value) + ")");
+    if (use_cpp_vectors && op->type.is_vector() && op->type.is_bool()) {
+        print_expr(op->value != make_zero(op->value.type()));
+    } else if (use_cpp_vectors && op->type.is_vector()) {
+        print_assignment(op->type, print_type(op->type) + "::convert(" + print_expr(op->value) + ")");
+    } else {
+        print_assignment(op->type, "(" + print_type(op->type) + ")(" + print_expr(op->value) + ")");
+    }
+}
+
+void CodeGen_C::visit(const Ramp *op) {
+    if (!use_cpp_vectors) {
+        IRPrinter::visit(op);
+        return;
+    }
+    string base = print_expr(op->base);
+    string stride = print_expr(op->stride);
+    print_assignment(op->type, print_type(op->type) + "::ramp(" + base + ", " + stride + ")");
+}
+
+void CodeGen_C::visit(const Broadcast *op) {
+    if (!use_cpp_vectors) {
+        IRPrinter::visit(op);
+        return;
+    }
+    string value = print_expr(op->value);
+    print_assignment(op->type, print_type(op->type) + "::broadcast(" + value + ")");
 }
 
 void CodeGen_C::visit_binop(Type t, Expr a, Expr b, const char * op) {
@@ -859,6 +1120,58 @@ void CodeGen_C::visit(const Call *op) {
             Expr b = op->args[1];
             Expr e = select(a < b, b - a, a - b);
             rhs << print_expr(e);
+        } else if (use_cpp_vectors && op->name == Call::shuffle_vector) {
+            internal_assert((int)op->args.size() == 1 + op->type.width);
+            Expr vec = op->args[0];
+            string v = print_expr(vec);
+            vector<string> lanes;
+            for (int i = 0; i < op->type.width; i++) {
+                const IntImm *idx = op->args[i+1].as<IntImm>();
+                internal_assert(idx && idx->value >= 0 && idx->value <= vec.type().width);
+                // An index one past the end is an undefined lane.
+                int lane = idx->value < vec.type().width ? idx->value : 0;
+                lanes.push_back(vec.type().is_vector() ? v + "[" + std::to_string(lane) + "]" : v);
+            }
+            if (op->type.is_scalar()) {
+                rhs << lanes[0];
+            } else {
+                rhs << print_type(op->type) << "::make(";
+                for (size_t i = 0; i < lanes.size(); i++) {
+                    if (i > 0) rhs << ", ";
+                    rhs << lanes[i];
+                }
+                rhs << ")";
+            }
+        } else if (use_cpp_vectors && op->name == Call::interleave_vectors) {
+            internal_assert(!op->args.empty());
+            vector<string> vecs;
+            int max_width = 0;
+            for (size_t i = 0; i < op->args.size(); i++) {
+                vecs.push_back(print_expr(op->args[i]));
+                max_width = std::max(max_width, op->args[i].type().width);
+            }
+            // Take the lanes from each vector in turn. Vectors that
+            // are shorter than the others run out first.
+            vector<string> lanes;
+            for (int j = 0; j < max_width; j++) {
+                for (size_t i = 0; i < op->args.size(); i++) {
+                    Type t = op->args[i].type();
+                    if (j < t.width) {
+                        lanes.push_back(t.is_vector() ? vecs[i] + "[" + std::to_string(j) + "]" : vecs[i]);
+                    }
+                }
+            }
+            internal_assert((int)lanes.size() == op->type.width);
+            if (op->args.size() == 1) {
+                rhs << vecs[0];
+            } else {
+                rhs << print_type(op->type) << "::make(";
+                for (size_t i = 0; i < lanes.size(); i++) {
+                    if (i > 0) rhs << ", ";
+                    rhs << lanes[i];
+                }
+                rhs << ")";
+            }
         } else if (op->name == Call::null_handle) {
             rhs << "NULL";
         } else if (op->name == Call::address_of) {
@@ -967,6 +1280,13 @@ void CodeGen_C::visit(const Call *op) {
             internal_assert(op->args.size() == 1);
             string arg = print_expr(op->args[0]);
             rhs << "(" << arg << " > 0 ? " << arg << " : -" << arg << ")";
+        } else if (op->name == Call::nontemporal) {
+            // The C backend has no way to express a streaming store.
+            internal_assert(op->args.size() == 1);
+            rhs << print_expr(op->args[0]);
+        } else if (op->name == Call::store_fence) {
+            internal_assert(op->args.empty());
+            rhs << "0";
         } else if (op->name == Call::memoize_expr) {
             internal_assert(op->args.size() >= 1);
             string arg = print_expr(op->args[0]);
@@ -1091,6 +1411,21 @@ void CodeGen_C::visit(const Call *op) {
 void CodeGen_C::visit(const Load *op) {
 
     Type t = op->type;
+    if (use_cpp_vectors && t.is_vector()) {
+        // Dense loads are a memcpy, and the rest are a gather.
+        const Ramp *ramp = op->index.as<Ramp>();
+        string rhs;
+        if (ramp && is_one(ramp->stride)) {
+            string base = print_expr(ramp->base);
+            rhs = print_type(t) + "::load(" + print_name(op->name) + ", " + base + ")";
+        } else {
+            string index = print_expr(op->index);
+            rhs = print_type(t) + "::gather(" + print_name(op->name) + ", " + index + ")";
+        }
+        print_assignment(t, rhs);
+        return;
+    }
+
     bool type_cast_needed =
         !allocations.contains(op->name) ||
         allocations.get(op->name).type != t;
@@ -1116,6 +1451,22 @@ void CodeGen_C::visit(const Store *op) {
 
     Type t = op->value.type();
 
+    if (use_cpp_vectors && t.is_vector()) {
+        const Ramp *ramp = op->index.as<Ramp>();
+        string id_value = print_expr(op->value);
+        if (ramp && is_one(ramp->stride)) {
+            string id_base = print_expr(ramp->base);
+            do_indent();
+            stream << id_value << ".store(" << print_name(op->name) << ", " << id_base << ");\n";
+        } else {
+            string id_index = print_expr(op->index);
+            do_indent();
+            stream << id_value << ".scatter(" << print_name(op->name) << ", " << id_index << ");\n";
+        }
+        cache.clear();
+        return;
+    }
+
     bool type_cast_needed =
         t.is_handle() ||
         !allocations.contains(op->name) ||
@@ -1155,6 +1506,11 @@ void CodeGen_C::visit(const Select *op) {
     string true_val = print_expr(op->true_value);
     string false_val = print_expr(op->false_value);
     string cond = print_expr(op->condition);
+    if (use_cpp_vectors && op->condition.type().is_vector()) {
+        rhs << print_type(op->type) << "::select(" << cond << ", " << true_val << ", " << false_val << ")";
+        print_assignment(op->type, rhs.str());
+        return;
+    }
     rhs << "(" << print_type(op->type) << ")"
         << "(" << cond
         << " ? " << true_val
@@ -1363,6 +1719,10 @@ void CodeGen_C::visit(const Realize *op) {
 }
 
 void CodeGen_C::visit(const IfThenElse *op) {
+    user_assert(op->condition.type().is_scalar())
+        << "Can't generate C code for an if statement with a vector condition. "
+        << "This is probably caused by vectorizing a loop split with "
+        << "TailStrategy::GuardWithIf.\n";
     string cond_id = print_expr(op->condition);
 
     do_indent();
@@ -1516,6 +1876,49 @@ void CodeGen_C::test() {
 
     }
 
+    // Check that vectors become the vector types.
+    Expr v = Load::make(Int(32, 4), "buf", Ramp::make(beta, 1, 4), Buffer(), Parameter());
+    v = Select::make(v > Broadcast::make(3, 4), v / Broadcast::make(2, 4), Cast::make(Int(32, 4), Broadcast::make(alpha, 4)));
+    s = Store::make("buf", v, Ramp::make(beta * 4, 2, 4));
+
+    Module vec_m("", get_host_target());
+    vec_m.append(LoweredFunc("test2", args, s, LoweredFunc::External));
+
+    ostringstream vec_source;
+    {
+        CodeGen_C cg(vec_source, false);
+        cg.compile(vec_m);
+    }
+    src = vec_source.str();
+    // The names of the temporaries depend on what else has been
+    // compiled, so just check the parts without them.
+    const char *vector_lines[] = {
+        "typedef CppVector<uint8_t, 4, uint1x4_native_t> uint1x4_t;\n",
+        "typedef int32_t int32x4_native_t __attribute__((vector_size(16)));\n",
+        " = int32x4_t::load(_buf, _beta);\n",
+        " = float32x4_t::broadcast(_alpha);\n",
+        " = int32x4_t::convert(_",
+        " = int32x4_t::select(_",
+        ".scatter(_buf, _"
+    };
+    for (const char *line : vector_lines) {
+        internal_assert(src.find(line) != string::npos)
+            << "Vector source code:\n" << src
+            << "\nis missing: " << line;
+    }
+
+    // The GPU backends print kernels directly, in dialects with their
+    // own vector types, so those mustn't use the vector types above.
+    ostringstream dialect_source;
+    {
+        CodeGen_C cg(dialect_source, false);
+        cg.print(s);
+    }
+    src = dialect_source.str();
+    internal_assert(src.find("::select(") == string::npos &&
+                    src.find(".scatter(") == string::npos &&
+                    src.find(" ? ") != string::npos)
+        << "Vector source code printed outside of a C++ function:\n" << src;
 
     std::cout << "CodeGen_C test passed\n";
 }
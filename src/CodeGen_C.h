@@ -53,6 +53,19 @@ protected:
     /** Remember already emitted funcitons. */
     std::set<std::string> emitted;
 
+    /** Remember the vector types that already have typedefs. */
+    std::set<std::string> emitted_vector_types;
+
+    /** Whether vector expressions are printed using the CppVector
+     * types. This is only set while compiling C++ functions, so the
+     * GPU backends, which share these visitors but print kernels in
+     * dialects with their own vector types, are unaffected. */
+    bool use_cpp_vectors;
+
+    /** Emit typedefs for the vector types used in a statement that
+     * don't have them yet. */
+    void add_vector_typedefs(Stmt s);
+
     /** Emit an expression as an assignment, then return the id of the
      * resulting var */
     std::string print_expr(Expr);
@@ -105,6 +118,8 @@ protected:
     void visit(const StringImm *);
     void visit(const FloatImm *);
     void visit(const Cast *);
+    void visit(const Ramp *);
+    void visit(const Broadcast *);
     void visit(const Add *);
     void visit(const Sub *);
     void visit(const Mul *);
@@ -1,18 +1,22 @@
 #include <iostream>
 #include <limits>
+#include <set>
 #include <sstream>
 
 #include "IRPrinter.h"
 #include "CodeGen_LLVM.h"
 #include "IROperator.h"
+#include "IRMatch.h"
 #include "Debug.h"
 #include "Deinterleave.h"
 #include "Simplify.h"
 #include "JITModule.h"
 #include "CodeGen_Internal.h"
+#include "CompileStats.h"
 #include "Lerp.h"
 #include "Util.h"
 #include "LLVM_Runtime_Linker.h"
+#include "LLVM_Parallel_Optimizer.h"
 #include "MatlabWrapper.h"
 
 #include "CodeGen_X86.h"
@@ -133,6 +137,7 @@ CodeGen_LLVM::CodeGen_LLVM(Target t) :
     builder(NULL),
     value(NULL),
     very_likely_branch(NULL),
+    vector_predicate(NULL),
     target(t),
     void_t(NULL), i1(NULL), i8(NULL), i16(NULL), i32(NULL), i64(NULL),
     f16(NULL), f32(NULL), f64(NULL),
@@ -416,14 +421,25 @@ llvm::Module *CodeGen_LLVM::compile(const Module &input) {
     scalar_value_t_type = module->getTypeByName("struct.halide_scalar_value_t");
     internal_assert(scalar_value_t_type) << "Did not find halide_scalar_value_t in initial module";
 
+    // Remember what the runtime defines, to tell it apart from the
+    // functions we generate.
+    std::set<string> runtime_functions;
+    for (llvm::Module::iterator iter = module->begin(); iter != module->end(); iter++) {
+        if (!iter->isDeclaration()) {
+            runtime_functions.insert(iter->getName());
+        }
+    }
 
     // Generate the code for this module.
     debug(1) << "Generating llvm bitcode...\n";
-    for (size_t i = 0; i < input.buffers.size(); i++) {
-        compile_buffer(input.buffers[i]);
-    }
-    for (size_t i = 0; i < input.functions.size(); i++) {
-        compile_func(input.functions[i]);
+    {
+        CompilePhaseTimer timer("llvm_codegen");
+        for (size_t i = 0; i < input.buffers.size(); i++) {
+            compile_buffer(input.buffers[i]);
+        }
+        for (size_t i = 0; i < input.functions.size(); i++) {
+            compile_func(input.functions[i]);
+        }
     }
 
     debug(2) << module << "\n";
@@ -433,7 +449,13 @@ llvm::Module *CodeGen_LLVM::compile(const Module &input) {
     debug(2) << "Done generating llvm bitcode\n";
 
     // Optimize
-    CodeGen_LLVM::optimize_module();
+    vector<string> generated_functions;
+    for (llvm::Module::iterator iter = module->begin(); iter != module->end(); iter++) {
+        if (!iter->isDeclaration() && !runtime_functions.count(iter->getName())) {
+            generated_functions.push_back(iter->getName());
+        }
+    }
+    CodeGen_LLVM::optimize_module(generated_functions);
 
     // Disown the module and return it.
     llvm::Module *m = module;
@@ -862,9 +884,9 @@ llvm::Type *CodeGen_LLVM::llvm_type_of(Type t) {
     return Internal::llvm_type_of(context, t);
 }
 
-void CodeGen_LLVM::optimize_module() {
-    debug(3) << "Optimizing module\n";
+namespace {
 
+void optimize_llvm_module(llvm::Module *module) {
     #if LLVM_VERSION < 37
     FunctionPassManager function_pass_manager(module);
     PassManager module_pass_manager;
@@ -893,6 +915,24 @@ void CodeGen_LLVM::optimize_module() {
         function_pass_manager.run(*i);
     }
     function_pass_manager.doFinalization();
+}
+
+}
+
+void CodeGen_LLVM::optimize_module() {
+    optimize_module(vector<string>());
+}
+
+void CodeGen_LLVM::optimize_module(const vector<string> &generated_functions) {
+    debug(3) << "Optimizing module\n";
+    CompilePhaseTimer timer("llvm_optimization");
+
+    int threads = num_codegen_threads();
+    if (threads > 1) {
+        module = optimize_module_in_parallel(module, generated_functions, threads, optimize_llvm_module);
+    } else {
+        optimize_llvm_module(module);
+    }
 
     if (debug::debug_level >= 2) {
         module->dump();
@@ -1168,10 +1208,92 @@ void CodeGen_LLVM::visit(const StringImm *op) {
     value = create_string_constant(op->value);
 }
 
+namespace {
+
+// Convert the bits of a half-precision float to a single-precision
+// float using integer arithmetic.
+Expr float16_bits_to_float32(Expr bits) {
+    int w = bits.type().width;
+    Type u32 = UInt(32, w), f32 = Float(32, w);
+
+    Expr b = cast(u32, bits);
+    Expr sign = (b & make_const(u32, 0x8000)) << 16;
+    Expr exponent = (b >> 10) & make_const(u32, 0x1f);
+    Expr mantissa = b & make_const(u32, 0x3ff);
+
+    // Rebias the exponent of normal numbers. Infinities and nans
+    // get the maximum exponent.
+    Expr normal = ((exponent + 112) << 23) | (mantissa << 13);
+    Expr inf_or_nan = make_const(u32, 0x7f800000) | (mantissa << 13);
+    Expr magnitude = reinterpret(f32, select(exponent == 31, inf_or_nan, normal));
+
+    // Zeros and subnormals are an exact multiple of 2^-24.
+    magnitude = select(exponent == 0, cast(f32, mantissa) * (1.0f / (1 << 24)), magnitude);
+
+    return reinterpret(f32, reinterpret(u32, magnitude) | sign);
+}
+
+// Convert a single-precision float to the bits of a half-precision
+// float using integer arithmetic, rounding to nearest even.
+Expr float32_to_float16_bits(Expr f) {
+    int w = f.type().width;
+    Type u32 = UInt(32, w), f32 = Float(32, w);
+
+    Expr b = reinterpret(u32, f);
+    Expr sign = b & make_const(u32, 0x80000000);
+    b = b ^ sign;
+
+    // Values too large for a half become inf, and nans stay nans.
+    Expr inf_or_nan = select(b > make_const(u32, 0x7f800000),
+                             make_const(u32, 0x7e00),
+                             make_const(u32, 0x7c00));
+
+    // For results that are zero or subnormal, adding 0.5 aligns the
+    // mantissa bits we want at the bottom of the float, and rounds
+    // them correctly.
+    Expr denorm_magic = make_const(u32, 126 << 23);
+    Expr subnormal = reinterpret(u32, reinterpret(f32, b) + reinterpret(f32, denorm_magic)) - denorm_magic;
+
+    // For normal results, rebias the exponent and round to nearest
+    // even by adding just under half an ulp, plus one if the result
+    // is odd.
+    Expr odd = (b >> 13) & make_one(u32);
+    Expr normal = (b - make_const(u32, (112 << 23) - 0xfff) + odd) >> 13;
+
+    Expr result = select(b >= make_const(u32, 0x47800000), inf_or_nan,
+                         b < make_const(u32, 113 << 23), subnormal,
+                         normal);
+    return cast(UInt(16, w), result | (sign >> 16));
+}
+
+}
+
 void CodeGen_LLVM::visit(const Cast *op) {
     Halide::Type src = op->value.type();
     Halide::Type dst = op->type;
 
+    bool src_is_half = src.is_float() && src.bits == 16;
+    bool dst_is_half = dst.is_float() && dst.bits == 16;
+    if (src_is_half != dst_is_half) {
+        // LLVM lowers conversions to and from half precision to calls
+        // to functions that the runtime doesn't provide. Go via
+        // Float(32), and do the conversion with integer arithmetic
+        // unless a subclass knows of an instruction for it.
+        Type f32 = Float(32, src.width);
+        Expr e;
+        if (dst_is_half && src != f32) {
+            e = cast(dst, cast(f32, op->value));
+        } else if (dst_is_half) {
+            e = reinterpret(dst, float32_to_float16_bits(op->value));
+        } else if (dst != f32) {
+            e = cast(dst, cast(f32, op->value));
+        } else {
+            e = float16_bits_to_float32(reinterpret(UInt(16, src.width), op->value));
+        }
+        value = codegen(e);
+        return;
+    }
+
     value = codegen(op->value);
 
     llvm::Type *llvm_dst = llvm_type_of(dst);
@@ -1627,6 +1749,11 @@ void CodeGen_LLVM::visit(const Load *op) {
         return;
     }
 
+    if (vector_predicate && op->type.is_vector()) {
+        value = codegen_predicated_load(op);
+        return;
+    }
+
     // There are several cases. Different architectures may wish to override some.
     if (op->type.is_scalar()) {
         // Scalar loads
@@ -1831,8 +1958,71 @@ Expr unbroadcast(Expr e) {
     }
 }
 
+Value *CodeGen_LLVM::interleave_native_vectors(Type elem, const std::vector<Value *> &vecs) {
+    internal_assert(!vecs.empty() && (vecs.size() & (vecs.size() - 1)) == 0);
+    int lanes = vecs[0]->getType()->getVectorNumElements();
+    int native_lanes = std::max(2, native_vector_bits() / elem.bits);
+    int piece_lanes = std::min(lanes, native_lanes);
+    internal_assert(lanes % piece_lanes == 0 && piece_lanes % 2 == 0);
+
+    // The shuffles that interleave the low and high halves of two
+    // vectors.
+    vector<Constant *> lo(piece_lanes), hi(piece_lanes);
+    for (int i = 0; i < piece_lanes; i++) {
+        int idx = i/2 + ((i % 2 == 1) ? piece_lanes : 0);
+        lo[i] = ConstantInt::get(i32, idx);
+        hi[i] = ConstantInt::get(i32, idx + piece_lanes/2);
+    }
+    Constant *lo_indices = ConstantVector::get(lo);
+    Constant *hi_indices = ConstantVector::get(hi);
+
+    // Break each vector into native-width pieces.
+    vector<vector<Value *>> pieces(vecs.size());
+    for (size_t i = 0; i < vecs.size(); i++) {
+        for (int j = 0; j < lanes; j += piece_lanes) {
+            pieces[i].push_back(slice_vector(vecs[i], j, piece_lanes));
+        }
+    }
+
+    // Interleaving n vectors is the same as interleaving the n/2
+    // vectors made by interleaving each vector in the first half
+    // with the corresponding one in the second half.
+    while (pieces.size() > 1) {
+        size_t half = pieces.size() / 2;
+        vector<vector<Value *>> next(half);
+        for (size_t i = 0; i < half; i++) {
+            for (size_t j = 0; j < pieces[i].size(); j++) {
+                Value *a = pieces[i][j], *b = pieces[i + half][j];
+                next[i].push_back(builder->CreateShuffleVector(a, b, lo_indices));
+                next[i].push_back(builder->CreateShuffleVector(a, b, hi_indices));
+            }
+        }
+        pieces.swap(next);
+    }
+
+    return concat_vectors(pieces[0]);
+}
+
 Value *CodeGen_LLVM::interleave_vectors(Type type, const std::vector<Expr>& vecs) {
-    if(vecs.size() == 1) {
+    bool same_widths = true;
+    for (Expr v : vecs) {
+        same_widths = same_widths && v.type().width == vecs[0].type().width;
+    }
+    int width = vecs[0].type().width;
+    bool power_of_two = (vecs.size() & (vecs.size() - 1)) == 0;
+
+    if (vecs.size() > 2 && power_of_two && same_widths &&
+        width > 1 && (width & (width - 1)) == 0) {
+        // Transposes, and interleavings of 4 or 8 channels. Three
+        // channels would have to be padded to four and then have
+        // every fourth lane dropped, which is a shuffle that isn't a
+        // native unpack, so they use the general code below.
+        vector<Value *> values(vecs.size());
+        for (size_t i = 0; i < vecs.size(); i++) {
+            values[i] = codegen(vecs[i]);
+        }
+        return interleave_native_vectors(type.element_of(), values);
+    } else if(vecs.size() == 1) {
         return codegen(vecs[0]);
     } else if(vecs.size() == 2) {
         Expr a = vecs[0], b = vecs[1];
@@ -2410,6 +2600,20 @@ void CodeGen_LLVM::visit(const Call *op) {
             llvm::Value *args[2] = { codegen(op->args[0]), zero_is_not_undef };
             CallInst *call = builder->CreateCall(fn, args);
             value = call;
+        } else if (op->name == Call::vector_reduce_add ||
+                   op->name == Call::vector_reduce_mul ||
+                   op->name == Call::vector_reduce_min ||
+                   op->name == Call::vector_reduce_max) {
+            internal_assert(op->args.size() == 1);
+            value = codegen_vector_reduce(op->name, op->args[0]);
+        } else if (op->name == Call::nontemporal) {
+            // Only meaningful as the value of a Store.
+            internal_assert(op->args.size() == 1);
+            value = codegen(op->args[0]);
+        } else if (op->name == Call::store_fence) {
+            internal_assert(op->args.empty());
+            builder->CreateFence(Release);
+            value = ConstantInt::get(i32, 0);
         } else if (op->name == Call::return_second) {
             internal_assert(op->args.size() == 2);
             codegen(op->args[0]);
@@ -2582,6 +2786,11 @@ void CodeGen_LLVM::visit(const Call *op) {
                 f->setCallingConv(CallingConv::C);
             }
             register_destructor(f, codegen(arg), Always);
+        } else if (op->name == Call::make_float64) {
+            // A double constant that doesn't fit in a FloatImm.
+            value = get_constant<double>(f64, op);
+        } else if (op->name == Call::make_int64) {
+            value = get_constant<int64_t>(i64, op);
         } else {
             internal_error << "Unknown intrinsic: " << op->name << "\n";
         }
@@ -2599,6 +2808,44 @@ void CodeGen_LLVM::visit(const Call *op) {
         internal_assert(op->args.size() == 1);
         Expr e = Internal::halide_exp(op->args[0]);
         e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() &&
+               (op->name == "sin_f32" || op->name == "sin_f64")) {
+        // Scalar calls to the following use the system math library,
+        // but vector calls would get scalarized, so we use our own
+        // polynomial approximations instead.
+        internal_assert(op->args.size() == 1);
+        Expr e = Internal::halide_sin(op->args[0]);
+        e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() &&
+               (op->name == "cos_f32" || op->name == "cos_f64")) {
+        internal_assert(op->args.size() == 1);
+        Expr e = Internal::halide_cos(op->args[0]);
+        e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() &&
+               (op->name == "atan_f32" || op->name == "atan_f64")) {
+        internal_assert(op->args.size() == 1);
+        Expr e = Internal::halide_atan(op->args[0]);
+        e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() &&
+               (op->name == "atan2_f32" || op->name == "atan2_f64")) {
+        internal_assert(op->args.size() == 2);
+        Expr e = Internal::halide_atan2(op->args[0], op->args[1]);
+        e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() && op->name == "exp_f64") {
+        internal_assert(op->args.size() == 1);
+        Expr e = Internal::halide_exp(op->args[0]);
+        e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() && op->name == "log_f64") {
+        internal_assert(op->args.size() == 1);
+        Expr e = Internal::halide_log(op->args[0]);
+        e.accept(this);
+    } else if (op->call_type == Call::Extern && op->type.is_vector() && op->name == "pow_f64") {
+        internal_assert(op->args.size() == 2);
+        Expr x = op->args[0];
+        Expr y = op->args[1];
+        Expr e = Internal::halide_exp(Internal::halide_log(x) * y);
+        e = select(y == make_zero(y.type()), make_one(op->type), e);
+        e.accept(this);
     } else if (op->call_type == Call::Extern &&
                (op->name == "is_nan_f32" || op->name == "is_nan_f64")) {
         internal_assert(op->args.size() == 1);
@@ -3024,8 +3271,36 @@ void CodeGen_LLVM::visit(const Store *op) {
         return;
     }
 
+    if (vector_predicate && op->value.type().is_vector()) {
+        codegen_predicated_store(op);
+        return;
+    }
+
+    // Stores marked by Func::store_nontemporal. CSE may have wrapped
+    // the marker in lets, so move those out to find it.
+    bool nontemporal = false;
+    Expr marked = op->value;
+    std::vector<const Let *> lets;
+    while (const Let *let = marked.as<Let>()) {
+        lets.push_back(let);
+        marked = let->body;
+    }
+    if (const Call *c = marked.as<Call>()) {
+        if (c->name == Call::nontemporal && c->call_type == Call::Intrinsic) {
+            nontemporal = true;
+        }
+    }
+    if (nontemporal && !lets.empty()) {
+        Stmt s = Store::make(op->name, marked, op->index);
+        for (size_t i = lets.size(); i > 0; i--) {
+            s = LetStmt::make(lets[i-1]->name, lets[i-1]->value, s);
+        }
+        codegen(s);
+        return;
+    }
+
     Halide::Type value_type = op->value.type();
-    Value *val = codegen(op->value);
+    Value *val = codegen(nontemporal ? op->value.as<Call>()->args[0] : op->value);
     bool possibly_misaligned = (might_be_misaligned.find(op->name) != might_be_misaligned.end());
     // Scalar
     if (value_type.is_scalar()) {
@@ -3065,6 +3340,11 @@ void CodeGen_LLVM::visit(const Store *op) {
                 Value *vec_ptr = builder->CreatePointerCast(elt_ptr, slice_val->getType()->getPointerTo());
                 StoreInst *store = builder->CreateAlignedStore(slice_val, vec_ptr, alignment);
                 add_tbaa_metadata(store, op->name, slice_index);
+                // Streaming stores must be aligned to the vector size.
+                if (nontemporal && alignment >= slice_lanes * value_type.bytes()) {
+                    LLVMMDNodeArgumentType one[] = {value_as_metadata_type(ConstantInt::get(i32, 1))};
+                    store->setMetadata("nontemporal", MDNode::get(*context, one));
+                }
             }
         } else if (ramp) {
             Type ptr_type = value_type.element_of();
@@ -3110,6 +3390,95 @@ void CodeGen_LLVM::visit(const Store *op) {
 }
 
 
+Value *CodeGen_LLVM::codegen_predicated_load(const Load *op) {
+    int width = op->type.width;
+    internal_assert(vector_predicate &&
+                    (int)vector_predicate->getType()->getVectorNumElements() == width)
+        << "Vector predicate does not match the width of load from " << op->name << "\n";
+
+#if LLVM_VERSION >= 37
+    const Ramp *ramp = op->index.as<Ramp>();
+    if (ramp && is_one(ramp->stride)) {
+        // A dense load. Use a masked load.
+        Value *ptr = codegen_buffer_pointer(op->name, op->type.element_of(), ramp->base);
+        ptr = builder->CreatePointerCast(ptr, llvm_type_of(op->type)->getPointerTo());
+        Value *passthru = Constant::getNullValue(llvm_type_of(op->type));
+        Instruction *load = builder->CreateMaskedLoad(ptr, op->type.bytes(), vector_predicate, passthru);
+        add_tbaa_metadata(load, op->name, op->index);
+        return load;
+    }
+#endif
+
+    // Load each active lane separately. Inactive lanes are zero.
+    Value *index = codegen(op->index);
+    Value *result = Constant::getNullValue(llvm_type_of(op->type));
+    for (int i = 0; i < width; i++) {
+        Value *lane = ConstantInt::get(i32, i);
+        BasicBlock *before_bb = builder->GetInsertBlock();
+        BasicBlock *load_bb = BasicBlock::Create(*context, "predicated_load", function);
+        BasicBlock *after_bb = BasicBlock::Create(*context, "after_predicated_load", function);
+        Value *active = builder->CreateExtractElement(vector_predicate, lane);
+        builder->CreateCondBr(active, load_bb, after_bb);
+
+        builder->SetInsertPoint(load_bb);
+        Value *idx = builder->CreateExtractElement(index, lane);
+        Value *ptr = codegen_buffer_pointer(op->name, op->type.element_of(), idx);
+        LoadInst *val = builder->CreateLoad(ptr);
+        add_tbaa_metadata(val, op->name, op->index);
+        Value *loaded = builder->CreateInsertElement(result, val, lane);
+        builder->CreateBr(after_bb);
+
+        builder->SetInsertPoint(after_bb);
+        PHINode *phi = builder->CreatePHI(result->getType(), 2);
+        phi->addIncoming(result, before_bb);
+        phi->addIncoming(loaded, load_bb);
+        result = phi;
+    }
+    return result;
+}
+
+void CodeGen_LLVM::codegen_predicated_store(const Store *op) {
+    Halide::Type value_type = op->value.type();
+    int width = value_type.width;
+    internal_assert(vector_predicate &&
+                    (int)vector_predicate->getType()->getVectorNumElements() == width)
+        << "Vector predicate does not match the width of store to " << op->name << "\n";
+
+    Value *val = codegen(op->value);
+
+#if LLVM_VERSION >= 37
+    const Ramp *ramp = op->index.as<Ramp>();
+    if (ramp && is_one(ramp->stride)) {
+        // A dense store. Use a masked store.
+        Value *ptr = codegen_buffer_pointer(op->name, value_type.element_of(), ramp->base);
+        ptr = builder->CreatePointerCast(ptr, val->getType()->getPointerTo());
+        Instruction *store = builder->CreateMaskedStore(val, ptr, value_type.bytes(), vector_predicate);
+        add_tbaa_metadata(store, op->name, op->index);
+        return;
+    }
+#endif
+
+    // Store each active lane separately.
+    Value *index = codegen(op->index);
+    for (int i = 0; i < width; i++) {
+        Value *lane = ConstantInt::get(i32, i);
+        BasicBlock *store_bb = BasicBlock::Create(*context, "predicated_store", function);
+        BasicBlock *after_bb = BasicBlock::Create(*context, "after_predicated_store", function);
+        Value *active = builder->CreateExtractElement(vector_predicate, lane);
+        builder->CreateCondBr(active, store_bb, after_bb);
+
+        builder->SetInsertPoint(store_bb);
+        Value *idx = builder->CreateExtractElement(index, lane);
+        Value *v = builder->CreateExtractElement(val, lane);
+        Value *ptr = codegen_buffer_pointer(op->name, value_type.element_of(), idx);
+        StoreInst *store = builder->CreateStore(v, ptr);
+        add_tbaa_metadata(store, op->name, op->index);
+        builder->CreateBr(after_bb);
+
+        builder->SetInsertPoint(after_bb);
+    }
+}
+
 void CodeGen_LLVM::visit(const Block *op) {
     codegen(op->first);
     if (op->rest.defined()) codegen(op->rest);
@@ -3124,6 +3493,37 @@ void CodeGen_LLVM::visit(const Provide *op) {
 }
 
 void CodeGen_LLVM::visit(const IfThenElse *op) {
+    if (op->condition.type().is_vector()) {
+        // An if statement over a vector of conditions. Skip the body
+        // if no lanes are active, and otherwise generate it with its
+        // loads and stores masked by the condition.
+        internal_assert(!op->else_case.defined())
+            << "Can't generate an else case for an if statement with a vector condition\n";
+        int width = op->condition.type().width;
+        Value *cond = codegen(op->condition);
+        if (vector_predicate) {
+            cond = builder->CreateAnd(vector_predicate, cond);
+        }
+
+        llvm::Type *mask_t = IntegerType::get(*context, width);
+        Value *mask = builder->CreateBitCast(cond, mask_t);
+        Value *any_active = builder->CreateICmpNE(mask, ConstantInt::get(mask_t, 0));
+
+        BasicBlock *true_bb = BasicBlock::Create(*context, "predicated_bb", function);
+        BasicBlock *after_bb = BasicBlock::Create(*context, "after_predicated_bb", function);
+        builder->CreateCondBr(any_active, true_bb, after_bb);
+
+        builder->SetInsertPoint(true_bb);
+        Value *old_predicate = vector_predicate;
+        vector_predicate = cond;
+        codegen(op->then_case);
+        vector_predicate = old_predicate;
+        builder->CreateBr(after_bb);
+
+        builder->SetInsertPoint(after_bb);
+        return;
+    }
+
     BasicBlock *true_bb = BasicBlock::Create(*context, "true_bb", function);
     BasicBlock *false_bb = BasicBlock::Create(*context, "false_bb", function);
     BasicBlock *after_bb = BasicBlock::Create(*context, "after_bb", function);
@@ -3240,6 +3640,144 @@ Value *CodeGen_LLVM::call_intrin(llvm::Type *result_type, int intrin_vector_widt
     return call;
 }
 
+CodeGen_LLVM::PatternTable::Key CodeGen_LLVM::PatternTable::key_of(Expr e) {
+    Type t = e.type();
+    return Key(e.ptr->type_info(), ((int)t.code << 8) | t.bits);
+}
+
+void CodeGen_LLVM::PatternTable::add(const Pattern &p) {
+    internal_assert(p.pattern.defined() && p.intrin_width > 0);
+    patterns[key_of(p.pattern)].push_back(p);
+}
+
+const vector<CodeGen_LLVM::Pattern> *CodeGen_LLVM::PatternTable::candidates(Expr e) const {
+    std::map<Key, vector<Pattern>>::const_iterator iter = patterns.find(key_of(e));
+    if (iter == patterns.end()) {
+        return NULL;
+    }
+    return &(iter->second);
+}
+
+Value *CodeGen_LLVM::codegen_pattern(const PatternTable &table, Expr e) {
+    Type t = e.type();
+    if (!t.is_vector()) {
+        return NULL;
+    }
+
+    const vector<Pattern> *candidates = table.candidates(e);
+    if (!candidates) {
+        return NULL;
+    }
+
+    vector<Expr> matches;
+    for (const Pattern &p : *candidates) {
+        if (p.whole_vectors && t.width % p.intrin_width != 0) {
+            continue;
+        }
+
+        if (!expr_match(p.pattern, e, matches)) {
+            continue;
+        }
+
+        if (p.type == Pattern::Simple) {
+            return call_intrin(t, p.intrin_width, p.intrin, matches);
+        } else if (p.type == Pattern::NarrowArgs) {
+            // Try to narrow all of the args.
+            bool all_narrow = true;
+            for (size_t i = 0; i < matches.size(); i++) {
+                matches[i] = lossless_cast(t, matches[i]);
+                if (!matches[i].defined()) {
+                    all_narrow = false;
+                    break;
+                }
+            }
+            if (all_narrow) {
+                return call_intrin(t, p.intrin_width, p.intrin, matches);
+            }
+        } else {
+            // Must be a shift
+            internal_assert(matches.size() == 2);
+            int shift_amount;
+            bool power_of_two = is_const_power_of_two_integer(matches[1], &shift_amount);
+            if (power_of_two && shift_amount < matches[0].type().bits) {
+                return call_shift_pattern(p, t, matches[0], shift_amount);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+Value *CodeGen_LLVM::call_shift_pattern(const Pattern &p, Type result_type,
+                                        Expr arg, int shift_amount) {
+    Value *shift = ConstantInt::get(llvm_type_of(arg.type()), shift_amount);
+    return call_intrin(llvm_type_of(result_type), p.intrin_width, p.intrin,
+                       {codegen(arg), shift});
+}
+
+namespace {
+Expr combine_for_vector_reduce(const string &op, Expr a, Expr b) {
+    if (op == Call::vector_reduce_add) {
+        return Add::make(a, b);
+    } else if (op == Call::vector_reduce_mul) {
+        return Mul::make(a, b);
+    } else if (op == Call::vector_reduce_min) {
+        return Min::make(a, b);
+    } else {
+        internal_assert(op == Call::vector_reduce_max) << "Unknown vector reduction " << op << "\n";
+        return Max::make(a, b);
+    }
+}
+}
+
+Value *CodeGen_LLVM::codegen_vector_reduce(const string &op, Expr e) {
+    Type t = e.type();
+    Value *v = codegen(e);
+
+    // Combine the two halves until there is one lane left. When there
+    // are an odd number of lanes, the last one is set aside and
+    // folded in at the end.
+    string a_name = unique_name('a'), b_name = unique_name('b');
+    vector<Value *> leftovers;
+    int lanes = t.width;
+    while (lanes > 1) {
+        if (lanes & 1) {
+            leftovers.push_back(builder->CreateExtractElement(v, ConstantInt::get(i32, lanes - 1)));
+            lanes--;
+        }
+        int half = lanes / 2;
+        Value *a, *b;
+        if (half == 1) {
+            a = builder->CreateExtractElement(v, ConstantInt::get(i32, 0));
+            b = builder->CreateExtractElement(v, ConstantInt::get(i32, 1));
+        } else {
+            a = slice_vector(v, 0, half);
+            b = slice_vector(v, half, half);
+        }
+        Type half_type = t.vector_of(half);
+        sym_push(a_name, a);
+        sym_push(b_name, b);
+        v = codegen(combine_for_vector_reduce(op,
+                                              Variable::make(half_type, a_name),
+                                              Variable::make(half_type, b_name)));
+        sym_pop(a_name);
+        sym_pop(b_name);
+        lanes = half;
+    }
+
+    for (size_t i = 0; i < leftovers.size(); i++) {
+        sym_push(a_name, v);
+        sym_push(b_name, leftovers[i]);
+        v = codegen(combine_for_vector_reduce(op,
+                                              Variable::make(t.element_of(), a_name),
+                                              Variable::make(t.element_of(), b_name)));
+        sym_pop(a_name);
+        sym_pop(b_name);
+    }
+
+    return v;
+}
+
 Value *CodeGen_LLVM::slice_vector(Value *vec, int start, int size) {
     int vec_lanes = vec->getType()->getVectorNumElements();
 
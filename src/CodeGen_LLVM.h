@@ -113,6 +113,12 @@ protected:
     llvm::MDNode *very_likely_branch;
     //@}
 
+    /** The lanes for which vector loads and stores are currently
+     * active, or NULL if all lanes are. Set while generating the body
+     * of an if statement with a vector condition, e.g. the tail of a
+     * loop vectorized with TailStrategy::GuardWithIf. */
+    llvm::Value *vector_predicate;
+
     /** The target we're generating code for */
     Halide::Target target;
 
@@ -123,7 +129,14 @@ protected:
      * multiple related modules (e.g. multiple device kernels). */
     virtual void init_module();
 
-    /** Run all of llvm's optimization passes on the module. */
+    /** Run all of llvm's optimization passes on the module. If
+     * num_codegen_threads() is more than one, the given functions
+     * (the ones generated from Halide code, as opposed to the
+     * runtime) are optimized in parallel. */
+    void optimize_module(const std::vector<std::string> &generated_functions);
+
+    /** Run all of llvm's optimization passes on the whole module at
+     * once. Used by the device backends, whose modules are small. */
     void optimize_module();
 
     /** Add an entry to the symbol table, hiding previous entries with
@@ -280,6 +293,21 @@ protected:
      * different buffers */
     void add_tbaa_metadata(llvm::Instruction *inst, std::string buffer, Expr index);
 
+    /** Generate a vector load or store in which only the lanes in
+     * vector_predicate are active. Uses masked loads and stores for
+     * dense accesses where llvm supports them, and otherwise accesses
+     * each active lane separately. */
+    // @{
+    llvm::Value *codegen_predicated_load(const Load *op);
+    void codegen_predicated_store(const Store *op);
+    // @}
+
+    /** Combine the lanes of a vector using one of the
+     * vector_reduce intrinsics' operations. The default
+     * implementation repeatedly combines the two halves of the vector,
+     * which llvm can often turn into horizontal instructions. */
+    virtual llvm::Value *codegen_vector_reduce(const std::string &op, Expr e);
+
     using IRVisitor::visit;
 
     /** Generate code for various IR nodes. These can be overridden by
@@ -367,6 +395,16 @@ protected:
      * an arbitrary number of vectors.*/
     llvm::Value *interleave_vectors(Type, const std::vector<Expr> &);
 
+    /** Interleave a power-of-two number of llvm vectors of the same
+     * type. This is done with a network of two-input shuffles, each
+     * of which interleaves the low or high halves of a pair of
+     * native-width vectors. This is the shape of a matrix transpose,
+     * and each shuffle maps to a single unpack instruction on x86 or
+     * zip instruction on ARM. Other numbers of vectors, such as the
+     * three channels of RGB, don't fit this network, and are
+     * interleaved by interleave_vectors with wider shuffles. */
+    llvm::Value *interleave_native_vectors(Type elem, const std::vector<llvm::Value *> &);
+
     /** Generate a call to a vector intrinsic or runtime inlined
      * function. The arguments are sliced up into vectors of the width
      * given by 'intrin_vector_width', the intrinsic is called on each
@@ -382,6 +420,53 @@ protected:
                              const std::string &name, std::vector<llvm::Value *>);
     // @}
 
+    /** A peephole optimization that replaces some vector IR with a
+     * call to an intrinsic or runtime function. Where possible the
+     * wildcards in the pattern should have an unspecified number of
+     * lanes, so that the pattern matches vectors of any width. The
+     * intrinsic is then called on slices of intrin_width lanes. */
+    struct Pattern {
+        enum PatternType {Simple = 0, ///< Just match the pattern
+                          NarrowArgs, ///< Match the pattern if the args can be losslessly narrowed to the result type
+                          LeftShift,  ///< Match the pattern if the RHS is a const power of two
+                          RightShift  ///< Match the pattern if the RHS is a const power of two
+        };
+        std::string intrin;   ///< Name of the intrinsic or runtime function
+        int intrin_width;     ///< The native vector width of the intrinsic
+        Expr pattern;         ///< The pattern to match against
+        PatternType type;
+        bool whole_vectors;   ///< Only match vectors that are a multiple of intrin_width lanes
+        Pattern() : intrin_width(0), type(Simple), whole_vectors(false) {}
+        Pattern(const std::string &i, int w, Expr p, PatternType t = Simple, bool whole = false) :
+            intrin(i), intrin_width(w), pattern(p), type(t), whole_vectors(whole) {}
+    };
+
+    /** A set of patterns, indexed by the kind of node at the root of
+     * each pattern and its element type, so that only the patterns
+     * that could possibly match a given Expr are tried. Patterns
+     * with the same root are tried in the order they were added. */
+    class PatternTable {
+        typedef std::pair<const IRNodeType *, int> Key;
+        std::map<Key, std::vector<Pattern>> patterns;
+        static Key key_of(Expr e);
+    public:
+        void add(const Pattern &p);
+        const std::vector<Pattern> *candidates(Expr e) const;
+        bool empty() const {return patterns.empty();}
+    };
+
+    /** Try each pattern in the table that could match a vector
+     * Expr. Returns the generated code for the first one that
+     * matches, or NULL if none do. */
+    llvm::Value *codegen_pattern(const PatternTable &table, Expr e);
+
+    /** Call the intrinsic of a LeftShift or RightShift pattern that
+     * matched 'arg' shifted by the constant 'shift_amount'. The
+     * default passes the shift amount as a constant of the same type
+     * as the argument. */
+    virtual llvm::Value *call_shift_pattern(const Pattern &p, Type result_type,
+                                            Expr arg, int shift_amount);
+
     /** Take a slice of lanes out of an llvm vector. Pads with undefs
      * if you ask for more lanes than the vector has. */
     llvm::Value *slice_vector(llvm::Value *vec, int start, int extent);
@@ -20,19 +20,6 @@ using std::string;
 
 using namespace llvm;
 
-CodeGen_X86::CodeGen_X86(Target t) : CodeGen_Posix(t) {
-
-    #if !(WITH_X86)
-    user_error << "x86 not enabled for this build of Halide.\n";
-    #endif
-
-    user_assert(llvm_X86_enabled) << "llvm build not configured with X86 target enabled.\n";
-
-    #if !(WITH_NATIVE_CLIENT)
-    user_assert(t.os != Target::NaCl) << "llvm build not configured with native client enabled.\n";
-    #endif
-}
-
 Expr _i64(Expr e) {
     return cast(Int(64, e.type().width), e);
 }
@@ -73,50 +60,102 @@ Expr _f64(Expr e) {
 }
 
 
-namespace {
+CodeGen_X86::CodeGen_X86(Target t) : CodeGen_Posix(t) {
 
-// Attempt to cast an expression to a smaller type while provably not
-// losing information. If it can't be done, return an undefined Expr.
+    #if !(WITH_X86)
+    user_error << "x86 not enabled for this build of Halide.\n";
+    #endif
 
-Expr lossless_cast(Type t, Expr e) {
-    if (t == e.type()) {
-        return e;
-    } else if (t.can_represent(e.type())) {
-        return cast(t, e);
-    }
+    user_assert(llvm_X86_enabled) << "llvm build not configured with X86 target enabled.\n";
 
-    if (const Cast *c = e.as<Cast>()) {
-        if (t == c->value.type()) {
-            return c->value;
-        } else {
-            return lossless_cast(t, c->value);
-        }
-    }
+    #if !(WITH_NATIVE_CLIENT)
+    user_assert(t.os != Target::NaCl) << "llvm build not configured with native client enabled.\n";
+    #endif
 
-    if (const Broadcast *b = e.as<Broadcast>()) {
-        Expr v = lossless_cast(t.element_of(), b->value);
-        if (v.defined()) {
-            return Broadcast::make(v, b->width);
-        } else {
-            return Expr();
+    // Saturating arithmetic, high-half multiplies, and averaging are
+    // done on args that have been widened to avoid overflow. If the
+    // args can be narrowed back down we can use the sse2 and avx2
+    // instructions directly. The 256-bit versions go first, and only
+    // apply to whole 256-bit vectors.
+    struct {
+        const char *intrin;
+        int bits;
+        Expr pattern;
+    } wide_ops[] = {
+        {"padds.b", 8, _i8(clamp(wild_i16x_ + wild_i16x_, -128, 127))},
+        {"psubs.b", 8, _i8(clamp(wild_i16x_ - wild_i16x_, -128, 127))},
+        {"paddus.b", 8, _u8(min(wild_u16x_ + wild_u16x_, 255))},
+        {"psubus.b", 8, _u8(max(wild_i16x_ - wild_i16x_, 0))},
+        {"padds.w", 16, _i16(clamp(wild_i32x_ + wild_i32x_, -32768, 32767))},
+        {"psubs.w", 16, _i16(clamp(wild_i32x_ - wild_i32x_, -32768, 32767))},
+        {"paddus.w", 16, _u16(min(wild_u32x_ + wild_u32x_, 65535))},
+        {"psubus.w", 16, _u16(max(wild_i32x_ - wild_i32x_, 0))},
+        {"pmulh.w", 16, _i16((wild_i32x_ * wild_i32x_) / 65536)},
+        {"pmulhu.w", 16, _u16((wild_u32x_ * wild_u32x_) / 65536)},
+        {"pavg.b", 8, _u8(((wild_u16x_ + wild_u16x_) + 1) / 2)},
+        {"pavg.w", 16, _u16(((wild_u32x_ + wild_u32x_) + 1) / 2)}
+    };
+
+    for (size_t i = 0; i < sizeof(wide_ops)/sizeof(wide_ops[0]); i++) {
+        if (t.has_feature(Target::AVX2)) {
+            casts.add(Pattern(string("llvm.x86.avx2.") + wide_ops[i].intrin,
+                              256 / wide_ops[i].bits, wide_ops[i].pattern,
+                              Pattern::NarrowArgs, true));
         }
+        casts.add(Pattern(string("llvm.x86.sse2.") + wide_ops[i].intrin,
+                          128 / wide_ops[i].bits, wide_ops[i].pattern,
+                          Pattern::NarrowArgs));
     }
 
-    if (const IntImm *i = e.as<IntImm>()) {
-        int x = int_cast_constant(t, i->value);
-        if (x == i->value) {
-            return cast(t, e);
-        } else {
-            return Expr();
+    // Saturating narrowing, done by runtime functions that use the
+    // pack instructions.
+    casts.add(Pattern("packssdwx8", 8, _i16(clamp(wild_i32x_, -32768, 32767))));
+    casts.add(Pattern("packsswbx16", 16, _i8(clamp(wild_i16x_, -128, 127))));
+    casts.add(Pattern("packuswbx16", 16, _u8(clamp(wild_i16x_, 0, 255))));
+    if (t.has_feature(Target::SSE41)) {
+        casts.add(Pattern("packusdwx8", 8, _u16(clamp(wild_i32x_, 0, 65535))));
+
+        // LLVM doesn't correctly use pblendvb for u8 vectors that
+        // aren't width 16, so we peephole optimize them to
+        // runtime functions that use it. With AVX2, vectors that are
+        // a multiple of 32 lanes use the 256-bit form.
+        struct {
+            const char *intrin;
+            Expr pattern;
+        } blends[] = {
+            {"pblendvb_ult", select(wild_u8x_ < wild_u8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_ult", select(wild_u8x_ < wild_u8x_, wild_u8x_, wild_u8x_)},
+            {"pblendvb_slt", select(wild_i8x_ < wild_i8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_slt", select(wild_i8x_ < wild_i8x_, wild_u8x_, wild_u8x_)},
+            {"pblendvb_ule", select(wild_u8x_ <= wild_u8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_ule", select(wild_u8x_ <= wild_u8x_, wild_u8x_, wild_u8x_)},
+            {"pblendvb_sle", select(wild_i8x_ <= wild_i8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_sle", select(wild_i8x_ <= wild_i8x_, wild_u8x_, wild_u8x_)},
+            {"pblendvb_ne", select(wild_u8x_ != wild_u8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_ne", select(wild_u8x_ != wild_u8x_, wild_u8x_, wild_u8x_)},
+            {"pblendvb_ne", select(wild_i8x_ != wild_i8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_ne", select(wild_i8x_ != wild_i8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_eq", select(wild_u8x_ == wild_u8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_eq", select(wild_u8x_ == wild_u8x_, wild_u8x_, wild_u8x_)},
+            {"pblendvb_eq", select(wild_i8x_ == wild_i8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb_eq", select(wild_i8x_ == wild_i8x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb", select(wild_u1x_, wild_i8x_, wild_i8x_)},
+            {"pblendvb", select(wild_u1x_, wild_u8x_, wild_u8x_)}
+        };
+        for (size_t i = 0; i < sizeof(blends)/sizeof(blends[0]); i++) {
+            if (t.has_feature(Target::AVX2)) {
+                selects.add(Pattern(string(blends[i].intrin) + "_i8x32", 32, blends[i].pattern,
+                                    Pattern::Simple, true));
+            }
+            selects.add(Pattern(string(blends[i].intrin) + "_i8x16", 16, blends[i].pattern));
         }
     }
-
-    return Expr();
 }
 
+namespace {
+
 // i32(i16_a)*i32(i16_b) +/- i32(i16_c)*i32(i16_d) can be done by
-// interleaving a, c, and b, d, and then using pmaddwd. We
-// recognize it here, and implement it in the initial module.
+// interleaving a, c, and b, d, and then using pmaddwd.
 bool should_use_pmaddwd(Expr a, Expr b, vector<Expr> &result) {
     Type t = a.type();
     internal_assert(b.type() == t);
@@ -143,13 +182,73 @@ bool should_use_pmaddwd(Expr a, Expr b, vector<Expr> &result) {
     return true;
 }
 
+// i16(clamp(i32(u8_a)*i32(i8_b) + i32(u8_c)*i32(i8_d), -32768, 32767))
+// can be done by interleaving a, c, and b, d, and then using
+// pmaddubsw. Either factor of each product may be the unsigned one.
+bool should_use_pmaddubsw(const Cast *op, vector<Expr> &result) {
+    Expr wild = Variable::make(Int(32, -1), "*");
+    Expr pattern = _i16(clamp(wild * wild + wild * wild, -32768, 32767));
+
+    vector<Expr> matches;
+    if (!op->type.is_vector() || !expr_match(pattern, op, matches)) {
+        return false;
+    }
+
+    Type unsigned_narrow = UInt(8, op->type.width);
+    Type signed_narrow = Int(8, op->type.width);
+    vector<Expr> args(4);
+    for (int i = 0; i < 4; i += 2) {
+        args[i] = lossless_cast(unsigned_narrow, matches[i]);
+        args[i+1] = lossless_cast(signed_narrow, matches[i+1]);
+        if (!args[i].defined() || !args[i+1].defined()) {
+            args[i] = lossless_cast(unsigned_narrow, matches[i+1]);
+            args[i+1] = lossless_cast(signed_narrow, matches[i]);
+        }
+        if (!args[i].defined() || !args[i+1].defined()) {
+            return false;
+        }
+    }
+
+    result.swap(args);
+    return true;
+}
+
+}
+
+Value *CodeGen_X86::call_multiply_add_intrin(Type result_type, const string &sse_intrin, const string &avx2_intrin,
+                                             Expr a, Expr b, Expr c, Expr d) {
+    Type ac_type = a.type().vector_of(result_type.width * 2);
+    Type bd_type = b.type().vector_of(result_type.width * 2);
+    Value *ac = interleave_vectors(ac_type, {a, c});
+    Value *bd = interleave_vectors(bd_type, {b, d});
+    return call_multiply_add_intrin(result_type, sse_intrin, avx2_intrin, ac, bd);
+}
+
+Value *CodeGen_X86::call_multiply_add_intrin(Type result_type, const string &sse_intrin, const string &avx2_intrin,
+                                             Value *x, Value *y) {
+    // Use the 256-bit form if there are enough lanes, and the
+    // 128-bit form otherwise.
+    int lanes = 128 / result_type.bits;
+    string intrin = sse_intrin;
+    if (target.has_feature(Target::AVX2) && result_type.width % (lanes * 2) == 0) {
+        lanes *= 2;
+        intrin = avx2_intrin;
+    }
+
+    vector<Value *> results;
+    for (int i = 0; i < result_type.width; i += lanes) {
+        vector<Value *> args = {slice_vector(x, i * 2, lanes * 2), slice_vector(y, i * 2, lanes * 2)};
+        results.push_back(call_intrin(llvm_type_of(result_type.element_of().vector_of(lanes)), lanes, intrin, args));
+    }
+    return slice_vector(concat_vectors(results), 0, result_type.width);
 }
 
 
 void CodeGen_X86::visit(const Add *op) {
     vector<Expr> matches;
     if (should_use_pmaddwd(op->a, op->b, matches)) {
-        codegen(Call::make(op->type, "pmaddwd", matches, Call::Extern));
+        value = call_multiply_add_intrin(op->type, "llvm.x86.sse2.pmadd.wd", "llvm.x86.avx2.pmadd.wd",
+                                         matches[0], matches[1], matches[2], matches[3]);
     } else {
         CodeGen_Posix::visit(op);
     }
@@ -165,7 +264,8 @@ void CodeGen_X86::visit(const Sub *op) {
         } else {
             matches[3] = -matches[3];
         }
-        codegen(Call::make(op->type, "pmaddwd", matches, Call::Extern));
+        value = call_multiply_add_intrin(op->type, "llvm.x86.sse2.pmadd.wd", "llvm.x86.avx2.pmadd.wd",
+                                         matches[0], matches[1], matches[2], matches[3]);
     } else {
         CodeGen_Posix::visit(op);
     }
@@ -259,46 +359,11 @@ void CodeGen_X86::visit(const NE *op) {
 
 void CodeGen_X86::visit(const Select *op) {
 
-    // LLVM doesn't correctly use pblendvb for u8 vectors that aren't
-    // width 16, so we peephole optimize them to intrinsics.
-    struct Pattern {
-        string intrin;
-        Expr pattern;
-    };
-
-    static Pattern patterns[] = {
-        {"pblendvb_ult_i8x16", select(wild_u8x_ < wild_u8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_ult_i8x16", select(wild_u8x_ < wild_u8x_, wild_u8x_, wild_u8x_)},
-        {"pblendvb_slt_i8x16", select(wild_i8x_ < wild_i8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_slt_i8x16", select(wild_i8x_ < wild_i8x_, wild_u8x_, wild_u8x_)},
-        {"pblendvb_ule_i8x16", select(wild_u8x_ <= wild_u8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_ule_i8x16", select(wild_u8x_ <= wild_u8x_, wild_u8x_, wild_u8x_)},
-        {"pblendvb_sle_i8x16", select(wild_i8x_ <= wild_i8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_sle_i8x16", select(wild_i8x_ <= wild_i8x_, wild_u8x_, wild_u8x_)},
-        {"pblendvb_ne_i8x16", select(wild_u8x_ != wild_u8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_ne_i8x16", select(wild_u8x_ != wild_u8x_, wild_u8x_, wild_u8x_)},
-        {"pblendvb_ne_i8x16", select(wild_i8x_ != wild_i8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_ne_i8x16", select(wild_i8x_ != wild_i8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_eq_i8x16", select(wild_u8x_ == wild_u8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_eq_i8x16", select(wild_u8x_ == wild_u8x_, wild_u8x_, wild_u8x_)},
-        {"pblendvb_eq_i8x16", select(wild_i8x_ == wild_i8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_eq_i8x16", select(wild_i8x_ == wild_i8x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_i8x16", select(wild_u1x_, wild_i8x_, wild_i8x_)},
-        {"pblendvb_i8x16", select(wild_u1x_, wild_u8x_, wild_u8x_)}
-    };
-
-
-    if (target.has_feature(Target::SSE41) &&
-        op->condition.type().is_vector() &&
-        op->type.bits == 8 &&
+    if (op->condition.type().is_vector() &&
         op->type.width != 16) {
-
-        vector<Expr> matches;
-        for (size_t i = 0; i < sizeof(patterns)/sizeof(patterns[0]); i++) {
-            if (expr_match(patterns[i].pattern, op, matches)) {
-                value = call_intrin(op->type, 16, patterns[i].intrin, matches);
-                return;
-            }
+        if (Value *v = codegen_pattern(selects, op)) {
+            value = v;
+            return;
         }
     }
 
@@ -316,73 +381,36 @@ void CodeGen_X86::visit(const Cast *op) {
 
     vector<Expr> matches;
 
-    struct Pattern {
-        bool needs_sse_41;
-        bool wide_op;
-        Type type;
-        string intrin;
-        Expr pattern;
-    };
-
-    static Pattern patterns[] = {
-        {false, true, Int(8, 16), "llvm.x86.sse2.padds.b",
-         _i8(clamp(wild_i16x_ + wild_i16x_, -128, 127))},
-        {false, true, Int(8, 16), "llvm.x86.sse2.psubs.b",
-         _i8(clamp(wild_i16x_ - wild_i16x_, -128, 127))},
-        {false, true, UInt(8, 16), "llvm.x86.sse2.paddus.b",
-         _u8(min(wild_u16x_ + wild_u16x_, 255))},
-        {false, true, UInt(8, 16), "llvm.x86.sse2.psubus.b",
-         _u8(max(wild_i16x_ - wild_i16x_, 0))},
-        {false, true, Int(16, 8), "llvm.x86.sse2.padds.w",
-         _i16(clamp(wild_i32x_ + wild_i32x_, -32768, 32767))},
-        {false, true, Int(16, 8), "llvm.x86.sse2.psubs.w",
-         _i16(clamp(wild_i32x_ - wild_i32x_, -32768, 32767))},
-        {false, true, UInt(16, 8), "llvm.x86.sse2.paddus.w",
-         _u16(min(wild_u32x_ + wild_u32x_, 65535))},
-        {false, true, UInt(16, 8), "llvm.x86.sse2.psubus.w",
-         _u16(max(wild_i32x_ - wild_i32x_, 0))},
-        {false, true, Int(16, 8), "llvm.x86.sse2.pmulh.w",
-         _i16((wild_i32x_ * wild_i32x_) / 65536)},
-        {false, true, UInt(16, 8), "llvm.x86.sse2.pmulhu.w",
-         _u16((wild_u32x_ * wild_u32x_) / 65536)},
-        {false, true, UInt(8, 16), "llvm.x86.sse2.pavg.b",
-         _u8(((wild_u16x_ + wild_u16x_) + 1) / 2)},
-        {false, true, UInt(16, 8), "llvm.x86.sse2.pavg.w",
-         _u16(((wild_u32x_ + wild_u32x_) + 1) / 2)},
-        {false, false, Int(16, 8), "packssdwx8",
-         _i16(clamp(wild_i32x_, -32768, 32767))},
-        {false, false, Int(8, 16), "packsswbx16",
-         _i8(clamp(wild_i16x_, -128, 127))},
-        {false, false, UInt(8, 16), "packuswbx16",
-         _u8(clamp(wild_i16x_, 0, 255))},
-        {true, false, UInt(16, 8), "packusdwx8",
-         _u16(clamp(wild_i32x_, 0, 65535))}
-    };
-
-    for (size_t i = 0; i < sizeof(patterns)/sizeof(patterns[0]); i++) {
-        const Pattern &pattern = patterns[i];
+    if (target.has_feature(Target::SSE41) && should_use_pmaddubsw(op, matches)) {
+        value = call_multiply_add_intrin(op->type, "llvm.x86.ssse3.pmadd.ub.sw.128", "llvm.x86.avx2.pmadd.ub.sw",
+                                         matches[0], matches[1], matches[2], matches[3]);
+        return;
+    }
 
-        if (!target.has_feature(Target::SSE41) && pattern.needs_sse_41) {
-            continue;
-        }
+    if (Value *v = codegen_pattern(casts, op)) {
+        value = v;
+        return;
+    }
 
-        if (expr_match(pattern.pattern, op, matches)) {
-            bool match = true;
-            if (pattern.wide_op) {
-                // Try to narrow the matches to the target type.
-                for (size_t i = 0; i < matches.size(); i++) {
-                    matches[i] = lossless_cast(op->type, matches[i]);
-                    if (!matches[i].defined()) match = false;
-                }
-            }
-            if (match) {
-                value = call_intrin(op->type, pattern.type.width, pattern.intrin, matches);
-                return;
-            }
+    if (target.has_feature(Target::F16C)) {
+        // Convert between half and single precision eight lanes at a
+        // time. The half-precision side of the instructions is a
+        // vector of 16-bit integers.
+        Type src = op->value.type();
+        if (op->type.element_of() == Float(32) && src.element_of() == Float(16)) {
+            Value *bits = builder->CreateBitCast(codegen(op->value), llvm_type_of(UInt(16, src.width)));
+            value = call_intrin(llvm_type_of(op->type), 8, "llvm.x86.vcvtph2ps.256", {bits});
+            return;
+        } else if (op->type.element_of() == Float(16) && src.element_of() == Float(32)) {
+            // Round to nearest even.
+            Value *round = ConstantInt::get(i32, 0);
+            Value *bits = call_intrin(llvm_type_of(UInt(16, op->type.width)), 8, "llvm.x86.vcvtps2ph.256",
+                                      {codegen(op->value), round});
+            value = builder->CreateBitCast(bits, llvm_type_of(op->type));
+            return;
         }
     }
 
-
     #if LLVM_VERSION >= 38
     // Workaround for https://llvm.org/bugs/show_bug.cgi?id=24512
     // LLVM uses a numerically unstable method for vector
@@ -640,7 +668,118 @@ void CodeGen_X86::visit(const Max *op) {
     }
 }
 
+void CodeGen_X86::visit(const Load *op) {
+    // Gathers of 32-bit values through a vector of arbitrary 32-bit
+    // indices can use the avx2 gather instructions. Dense and strided
+    // loads are better handled by the base class.
+    Type elt = op->type.element_of();
+    if (!target.has_feature(Target::AVX2) ||
+        vector_predicate ||
+        op->type.width < 4 ||
+        op->type.width % 4 != 0 ||
+        op->index.as<Ramp>() ||
+        op->type.bits != 32 ||
+        !(elt == Int(32) || elt == UInt(32) || elt == Float(32))) {
+        CodeGen_Posix::visit(op);
+        return;
+    }
+
+    Value *index = codegen(op->index);
+    Value *base = codegen_buffer_pointer(op->name, elt, make_zero(Int(32)));
+    base = builder->CreatePointerCast(base, i8->getPointerTo());
+    Value *scale = ConstantInt::get(i8, 4);
+
+    // Gather eight lanes at a time, and four at a time for what's left.
+    vector<Value *> slices;
+    for (int i = 0; i < op->type.width; ) {
+        int lanes = (op->type.width - i >= 8) ? 8 : 4;
+        llvm::Type *result_type = llvm_type_of(elt.vector_of(lanes));
+        llvm::Type *int_type = llvm_type_of(Int(32, lanes));
+
+        // All lanes enabled. The mask has the same type as the
+        // result, and only the sign bit of each lane matters.
+        Value *mask = ConstantInt::get(int_type, -1);
+        mask = builder->CreateBitCast(mask, result_type);
+
+        Intrinsic::ID id;
+        if (elt.is_float()) {
+            id = lanes == 8 ? Intrinsic::x86_avx2_gather_d_ps_256 : Intrinsic::x86_avx2_gather_d_ps;
+        } else {
+            id = lanes == 8 ? Intrinsic::x86_avx2_gather_d_d_256 : Intrinsic::x86_avx2_gather_d_d;
+        }
+        llvm::Function *fn = Intrinsic::getDeclaration(module, id);
+
+        Value *args[] = {UndefValue::get(result_type), base,
+                         slice_vector(index, i, lanes), mask, scale};
+        Value *gather = builder->CreateCall(fn, args);
+        slices.push_back(builder->CreateBitCast(gather, result_type));
+        i += lanes;
+    }
+    value = concat_vectors(slices);
+}
+
+void CodeGen_X86::visit(const Call *op) {
+    if (op->call_type == Call::Intrinsic && op->name == Call::store_fence) {
+        // A release fence doesn't order non-temporal stores on x86,
+        // so use an sfence.
+        internal_assert(op->args.empty());
+        llvm::Function *fn = Intrinsic::getDeclaration(module, Intrinsic::x86_sse_sfence);
+        builder->CreateCall(fn);
+        value = ConstantInt::get(i32, 0);
+    } else {
+        CodeGen_Posix::visit(op);
+    }
+}
+
+Value *CodeGen_X86::codegen_vector_reduce(const string &op, Expr e) {
+    Type t = e.type();
+    if (op != Call::vector_reduce_add || !t.is_vector() || t.is_float()) {
+        return CodeGen_Posix::codegen_vector_reduce(op, e);
+    }
+
+    // psadbw against zero sums each group of eight bytes into a
+    // 64-bit lane. Wrapping the exact sum to the narrower result type
+    // gives the same answer as adding up the widened bytes.
+    const Cast *c = e.as<Cast>();
+    if (c && c->value.type().element_of() == UInt(8) &&
+        t.bits >= 16 && t.width % 16 == 0) {
+        Value *bytes = codegen(c->value);
+        Value *zero = Constant::getNullValue(llvm_type_of(UInt(8, 16)));
+        vector<Value *> sums;
+        for (int i = 0; i < t.width; i += 16) {
+            Value *slice = slice_vector(bytes, i, 16);
+            sums.push_back(call_intrin(llvm_type_of(UInt(64, 2)), 2, "llvm.x86.sse2.psad.bw", {slice, zero}));
+        }
+        string name = unique_name('s');
+        sym_push(name, concat_vectors(sums));
+        Value *sum = CodeGen_Posix::codegen_vector_reduce(op, Variable::make(UInt(64, t.width / 8), name));
+        sym_pop(name);
+        return builder->CreateTrunc(sum, llvm_type_of(t.element_of()));
+    }
+
+    // pmaddwd multiplies 16-bit values and adds adjacent pairs of
+    // products, halving the number of lanes left to combine.
+    const Mul *mul = e.as<Mul>();
+    if (mul && t.element_of() == Int(32) && t.width % 8 == 0) {
+        Expr a = lossless_cast(Int(16, t.width), mul->a);
+        Expr b = lossless_cast(Int(16, t.width), mul->b);
+        if (a.defined() && b.defined()) {
+            Value *sums = call_multiply_add_intrin(Int(32, t.width / 2),
+                                                   "llvm.x86.sse2.pmadd.wd", "llvm.x86.avx2.pmadd.wd",
+                                                   codegen(a), codegen(b));
+            string name = unique_name('s');
+            sym_push(name, sums);
+            Value *sum = CodeGen_Posix::codegen_vector_reduce(op, Variable::make(Int(32, t.width / 2), name));
+            sym_pop(name);
+            return sum;
+        }
+    }
+
+    return CodeGen_Posix::codegen_vector_reduce(op, e);
+}
+
 string CodeGen_X86::mcpu() const {
+    if (target.has_feature(Target::AVX2)) return "core-avx2";
     if (target.has_feature(Target::AVX)) return "corei7-avx";
     // We want SSE4.1 but not SSE4.2, hence "penryn" rather than "corei7"
     if (target.has_feature(Target::SSE41)) return "penryn";
@@ -46,7 +46,34 @@ protected:
     void visit(const EQ *);
     void visit(const NE *);
     void visit(const Select *);
+    void visit(const Load *);
+    void visit(const Call *);
     // @}
+
+    /** Call an x86 multiply-add intrinsic, such as pmaddwd, which
+     * multiplies adjacent pairs of lanes of its arguments and adds
+     * the products. Uses the 256-bit avx2 form where possible, and
+     * otherwise the 128-bit form given. The first version
+     * interleaves a with c and b with d to compute a*b + c*d
+     * lane-wise. The second version takes already-interleaved
+     * operands with twice as many lanes as the result. */
+    // @{
+    llvm::Value *call_multiply_add_intrin(Type result_type, const std::string &sse_intrin,
+                                          const std::string &avx2_intrin,
+                                          Expr a, Expr b, Expr c, Expr d);
+    llvm::Value *call_multiply_add_intrin(Type result_type, const std::string &sse_intrin,
+                                          const std::string &avx2_intrin,
+                                          llvm::Value *x, llvm::Value *y);
+    // @}
+
+    /** Patterns for casts and selects that map to sse/avx
+     * instructions the llvm backend doesn't find by itself. Built at
+     * construction according to the target's features. */
+    PatternTable casts, selects;
+
+    /** Use psadbw for sums of widened bytes, and pmaddwd for sums of
+     * products of 16-bit values. */
+    llvm::Value *codegen_vector_reduce(const std::string &op, Expr e);
 };
 
 }}
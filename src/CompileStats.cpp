@@ -0,0 +1,120 @@
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "CompileStats.h"
+#include "Error.h"
+#include "IRVisitor.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The stats for the pipeline being compiled, in the order they were
+// first added. Each thread compiles its own pipeline, so they're kept
+// separately per thread to stop concurrent compiles from mixing.
+std::mutex stats_mutex;
+std::map<std::thread::id, vector<pair<string, double>>> stats;
+
+// The peak resident set size of the process so far, in kilobytes.
+long peak_rss_kb() {
+    #ifdef _WIN32
+    return 0;
+    #else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    #ifdef __APPLE__
+    // Darwin reports bytes rather than kilobytes.
+    return usage.ru_maxrss / 1024;
+    #else
+    return usage.ru_maxrss;
+    #endif
+    #endif
+}
+
+class CountNodes : public IRGraphVisitor {
+public:
+    size_t count(Stmt s) {
+        include(s);
+        return visited.size();
+    }
+};
+
+}
+
+bool compile_stats_enabled() {
+    static bool enabled = !get_env_variable("HL_COMPILE_STATS").empty();
+    return enabled;
+}
+
+CompilePhaseTimer::CompilePhaseTimer(const string &p) :
+    phase(p), enabled(compile_stats_enabled()) {
+    if (enabled) {
+        start = std::chrono::high_resolution_clock::now();
+    }
+}
+
+CompilePhaseTimer::~CompilePhaseTimer() {
+    if (enabled) {
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        add_compile_stat(phase + "_seconds", elapsed.count());
+    }
+}
+
+void add_compile_stat(const string &name, double value) {
+    if (!compile_stats_enabled()) return;
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    vector<pair<string, double>> &s = stats[std::this_thread::get_id()];
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i].first == name) {
+            s[i].second += value;
+            return;
+        }
+    }
+    s.push_back(std::make_pair(name, value));
+}
+
+size_t count_ir_nodes(Stmt s) {
+    CountNodes counter;
+    return counter.count(s);
+}
+
+void write_compile_stats(const string &pipeline_name) {
+    if (!compile_stats_enabled()) return;
+    std::lock_guard<std::mutex> lock(stats_mutex);
+
+    string filename = get_env_variable("HL_COMPILE_STATS");
+    std::ofstream f(filename.c_str(), std::ios::app);
+    user_assert(f.is_open()) << "Could not open compile stats file " << filename << "\n";
+    f.precision(12);
+
+    std::map<std::thread::id, vector<pair<string, double>>>::iterator iter =
+        stats.find(std::this_thread::get_id());
+    f << "{\"pipeline\": \"" << pipeline_name << "\"";
+    if (iter != stats.end()) {
+        const vector<pair<string, double>> &s = iter->second;
+        for (size_t i = 0; i < s.size(); i++) {
+            f << ", \"" << s[i].first << "\": " << s[i].second;
+        }
+        stats.erase(iter);
+    }
+    f << ", \"peak_rss_kb\": " << peak_rss_kb() << "}\n";
+}
+
+}
+}
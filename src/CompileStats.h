@@ -0,0 +1,60 @@
+#ifndef HALIDE_COMPILE_STATS_H
+#define HALIDE_COMPILE_STATS_H
+
+/** \file
+ * Measurement of the time and memory Halide itself takes to compile a
+ * pipeline. Set the environment variable HL_COMPILE_STATS to the name
+ * of a file, and each pipeline compiled appends a line of JSON to it
+ * that looks like:
+ \code
+ {"pipeline": "blur", "lowering_seconds": 0.12, "llvm_codegen_seconds": 0.03,
+  "llvm_optimization_seconds": 0.21, "machine_codegen_seconds": 0.35,
+  "ir_nodes": 4821, "peak_rss_kb": 102400}
+ \endcode
+ * tools/compare_compile_stats.cpp compares two such files. The stats
+ * are gathered separately for each thread, so pipelines compiled
+ * concurrently on different threads don't mix. peak_rss_kb is the
+ * peak of the whole process though, so it only measures one pipeline
+ * if that pipeline is compiled in a process of its own.
+ */
+
+#include <chrono>
+#include <string>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Whether compile stats are being collected. */
+EXPORT bool compile_stats_enabled();
+
+/** Times one phase of compilation, from construction to destruction,
+ * and adds it to the stats for the pipeline being compiled as
+ * <phase>_seconds. Does nothing if compile stats aren't being
+ * collected. */
+class CompilePhaseTimer {
+    std::string phase;
+    std::chrono::high_resolution_clock::time_point start;
+    bool enabled;
+public:
+    EXPORT CompilePhaseTimer(const std::string &phase);
+    EXPORT ~CompilePhaseTimer();
+};
+
+/** Add to one of the stats for the pipeline being compiled on this
+ * thread. */
+EXPORT void add_compile_stat(const std::string &name, double value);
+
+/** Count the distinct IR nodes in a statement. */
+EXPORT size_t count_ir_nodes(Stmt s);
+
+/** Append the stats for the pipeline being compiled on this thread to
+ * the stats file, along with the peak resident set size of the process
+ * so far, and start again from zero for the next one. */
+EXPORT void write_compile_stats(const std::string &pipeline_name);
+
+}
+}
+
+#endif
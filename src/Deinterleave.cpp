@@ -466,6 +466,16 @@ class Interleaver : public IRMutator {
         stmt = visit_let<LetStmt, Stmt>(op);
     }
 
+    void visit(const IfThenElse *op) {
+        if (op->condition.type().is_vector()) {
+            // The loads and stores inside will be masked by the
+            // condition lane-by-lane, so we can't change their widths.
+            stmt = op;
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+
     void visit(const Mod *op) {
         const Ramp *r = op->a.as<Ramp>();
         for (int i = 2; i <= 4; ++i) {
@@ -32,26 +32,37 @@ struct IRNode {
      * visitors.
      */
     virtual void accept(IRVisitor *v) const = 0;
-    IRNode() {}
+    IRNode(IRNodeType *t) : node_type(t) {}
     virtual ~IRNode() {}
 
     /** These classes are all managed with intrusive reference
        counting, so we also track a reference count. It's mutable
        so that we can do reference counting even through const
        references to IR nodes. */
-    mutable RefCount ref_count;
+    mutable UnsyncedRefCount ref_count;
 
     /** Each IR node subclass should return some unique pointer. We
      * can compare these pointers to do runtime type
      * identification. We don't compile with rtti because that
      * injects run-time type identification stuff everywhere (and
      * often breaks when linking external libraries compiled
-     * without it), and we only want it for IR nodes. */
-    virtual const IRNodeType *type_info() const = 0;
+     * without it), and we only want it for IR nodes. The pointer is
+     * stored in the node rather than returned by a virtual method,
+     * because the simplifier and the rewrite rules check it on
+     * nearly every node they look at. */
+    const IRNodeType *type_info() const {return node_type;}
+
+private:
+    IRNodeType *node_type;
+};
+
+template<>
+struct RefCountType<IRNode> {
+    typedef UnsyncedRefCount type;
 };
 
 template<>
-EXPORT inline RefCount &ref_count<IRNode>(const IRNode *n) {return n->ref_count;}
+EXPORT inline UnsyncedRefCount &ref_count<IRNode>(const IRNode *n) {return n->ref_count;}
 
 template<>
 EXPORT inline void destroy<IRNode>(const IRNode *n) {delete n;}
@@ -65,11 +76,13 @@ EXPORT inline void destroy<IRNode>(const IRNode *n) {delete n;}
 /** A base class for statement nodes. They have no properties or
    methods beyond base IR nodes for now */
 struct BaseStmtNode : public IRNode {
+    BaseStmtNode(IRNodeType *t) : IRNode(t) {}
 };
 
 /** A base class for expression nodes. They all contain their types
  * (e.g. Int(32), Float(32)) */
 struct BaseExprNode : public IRNode {
+    BaseExprNode(IRNodeType *t) : IRNode(t) {}
     Type type;
 };
 
@@ -81,15 +94,15 @@ struct BaseExprNode : public IRNode {
    a concrete instantiation of a unique IRNodeType per class. */
 template<typename T>
 struct ExprNode : public BaseExprNode {
+    ExprNode() : BaseExprNode(&_type_info) {}
     EXPORT void accept(IRVisitor *v) const;
-    virtual IRNodeType *type_info() const {return &_type_info;}
     static EXPORT IRNodeType _type_info;
 };
 
 template<typename T>
 struct StmtNode : public BaseStmtNode {
+    StmtNode() : BaseStmtNode(&_type_info) {}
     EXPORT void accept(IRVisitor *v) const;
-    virtual IRNodeType *type_info() const {return &_type_info;}
     static EXPORT IRNodeType _type_info;
 };
 
@@ -258,12 +258,14 @@ void Stage::set_dim_type(VarOrRVar var, ForType t) {
             dims[i].for_type = t;
 
             // If it's an rvar and the for type is parallel, we need to
-            // validate that this doesn't introduce a race condition.
-            if (!dims[i].pure && var.is_rvar && (t == ForType::Vectorized || t == ForType::Parallel)) {
+            // validate that this doesn't introduce a race
+            // condition. Vectorized rvars are checked during lowering,
+            // because associative updates can be vectorized safely.
+            if (!dims[i].pure && var.is_rvar && t == ForType::Parallel) {
                 user_assert(schedule.allow_race_conditions())
                     << "In schedule for " << stage_name
                     << ", marking var " << var.name()
-                    << " as parallel or vectorized may introduce a race"
+                    << " as parallel may introduce a race"
                     << " condition resulting in incorrect output."
                     << " It is possible to override this error using"
                     << " the allow_race_conditions() method. Use this"
@@ -322,7 +324,7 @@ std::string Stage::dump_argument_list() const {
     return oss.str();
 }
 
-void Stage::split(const string &old, const string &outer, const string &inner, Expr factor, bool exact) {
+void Stage::split(const string &old, const string &outer, const string &inner, Expr factor, bool exact, TailStrategy tail) {
     vector<Dim> &dims = schedule.dims();
 
     // Check that the new names aren't already in the dims list.
@@ -363,12 +365,21 @@ void Stage::split(const string &old, const string &outer, const string &inner, E
                    << dump_argument_list();
     }
 
+    if (exact) {
+        user_assert(tail == TailStrategy::GuardWithIf || tail == TailStrategy::Auto)
+            << "In schedule for " << stage_name
+            << ", can't split RVar " << old_name
+            << " using TailStrategy::RoundUp or TailStrategy::ShiftInwards,"
+            << " because it would change the meaning of the algorithm."
+            << " Use TailStrategy::GuardWithIf instead.\n";
+    }
+
     // Add the split to the splits list
-    Split split = {old_name, outer_name, inner_name, factor, exact, Split::SplitVar};
+    Split split = {old_name, outer_name, inner_name, factor, exact, tail, Split::SplitVar};
     schedule.splits().push_back(split);
 }
 
-Stage &Stage::split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor) {
+Stage &Stage::split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor, TailStrategy tail) {
     if (old.is_rvar) {
         user_assert(outer.is_rvar) << "Can't split RVar " << old.name() << " into Var " << outer.name() << "\n";
         user_assert(inner.is_rvar) << "Can't split RVar " << old.name() << " into Var " << inner.name() << "\n";
@@ -376,7 +387,7 @@ Stage &Stage::split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor
         user_assert(!outer.is_rvar) << "Can't split Var " << old.name() << " into RVar " << outer.name() << "\n";
         user_assert(!inner.is_rvar) << "Can't split Var " << old.name() << " into RVar " << inner.name() << "\n";
     }
-    split(old.name(), outer.name(), inner.name(), factor, old.is_rvar);
+    split(old.name(), outer.name(), inner.name(), factor, old.is_rvar, tail);
     return *this;
 }
 
@@ -434,7 +445,7 @@ Stage &Stage::fuse(VarOrRVar inner, VarOrRVar outer, VarOrRVar fused) {
     }
 
     // Add the fuse to the splits list
-    Split split = {fused_name, outer_name, inner_name, Expr(), true, Split::FuseVars};
+    Split split = {fused_name, outer_name, inner_name, Expr(), true, TailStrategy::Auto, Split::FuseVars};
     schedule.splits().push_back(split);
     return *this;
 }
@@ -533,7 +544,7 @@ Stage &Stage::rename(VarOrRVar old_var, VarOrRVar new_var) {
     }
 
     if (!found) {
-        Split split = {old_name, new_name, "", 1, old_var.is_rvar, Split::RenameVar};
+        Split split = {old_name, new_name, "", 1, old_var.is_rvar, TailStrategy::Auto, Split::RenameVar};
         schedule.splits().push_back(split);
     }
 
@@ -577,27 +588,27 @@ Stage &Stage::parallel(VarOrRVar var, Expr factor) {
     return *this;
 }
 
-Stage &Stage::vectorize(VarOrRVar var, int factor) {
+Stage &Stage::vectorize(VarOrRVar var, int factor, TailStrategy tail) {
     if (var.is_rvar) {
         RVar tmp;
-        split(var.rvar, var.rvar, tmp, factor);
+        split(var.name(), var.name(), tmp.name(), factor, true, tail);
         vectorize(tmp);
     } else {
         Var tmp;
-        split(var.var, var.var, tmp, factor);
+        split(var.name(), var.name(), tmp.name(), factor, false, tail);
         vectorize(tmp);
     }
     return *this;
 }
 
-Stage &Stage::unroll(VarOrRVar var, int factor) {
+Stage &Stage::unroll(VarOrRVar var, int factor, TailStrategy tail) {
     if (var.is_rvar) {
         RVar tmp;
-        split(var.rvar, var.rvar, tmp, factor);
+        split(var.rvar, var.rvar, tmp, factor, tail);
         unroll(tmp);
     } else {
         Var tmp;
-        split(var.var, var.var, tmp, factor);
+        split(var.var, var.var, tmp, factor, tail);
         unroll(tmp);
     }
 
@@ -607,18 +618,20 @@ Stage &Stage::unroll(VarOrRVar var, int factor) {
 Stage &Stage::tile(VarOrRVar x, VarOrRVar y,
                    VarOrRVar xo, VarOrRVar yo,
                    VarOrRVar xi, VarOrRVar yi,
-                   Expr xfactor, Expr yfactor) {
-    split(x, xo, xi, xfactor);
-    split(y, yo, yi, yfactor);
+                   Expr xfactor, Expr yfactor,
+                   TailStrategy tail) {
+    split(x, xo, xi, xfactor, tail);
+    split(y, yo, yi, yfactor, tail);
     reorder(xi, yi, xo, yo);
     return *this;
 }
 
 Stage &Stage::tile(VarOrRVar x, VarOrRVar y,
                    VarOrRVar xi, VarOrRVar yi,
-                   Expr xfactor, Expr yfactor) {
-    split(x, x, xi, xfactor);
-    split(y, y, yi, yfactor);
+                   Expr xfactor, Expr yfactor,
+                   TailStrategy tail) {
+    split(x, x, xi, xfactor, tail);
+    split(y, y, yi, yfactor, tail);
     reorder(xi, yi, x, y);
     return *this;
 }
@@ -832,9 +845,9 @@ void Func::invalidate_cache() {
     }
 }
 
-Func &Func::split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor) {
+Func &Func::split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor, TailStrategy tail) {
     invalidate_cache();
-    Stage(func.schedule(), name()).split(old, outer, inner, factor);
+    Stage(func.schedule(), name()).split(old, outer, inner, factor, tail);
     return *this;
 }
 
@@ -861,6 +874,12 @@ Func &Func::memoize() {
     return *this;
 }
 
+Func &Func::store_nontemporal() {
+    invalidate_cache();
+    func.schedule().store_nontemporal() = true;
+    return *this;
+}
+
 Stage Func::specialize(Expr c) {
     invalidate_cache();
     return Stage(func.schedule(), name()).specialize(c);
@@ -896,15 +915,15 @@ Func &Func::parallel(VarOrRVar var, Expr factor) {
     return *this;
 }
 
-Func &Func::vectorize(VarOrRVar var, int factor) {
+Func &Func::vectorize(VarOrRVar var, int factor, TailStrategy tail) {
     invalidate_cache();
-    Stage(func.schedule(), name()).vectorize(var, factor);
+    Stage(func.schedule(), name()).vectorize(var, factor, tail);
     return *this;
 }
 
-Func &Func::unroll(VarOrRVar var, int factor) {
+Func &Func::unroll(VarOrRVar var, int factor, TailStrategy tail) {
     invalidate_cache();
-    Stage(func.schedule(), name()).unroll(var, factor);
+    Stage(func.schedule(), name()).unroll(var, factor, tail);
     return *this;
 }
 
@@ -930,17 +949,19 @@ Func &Func::bound(Var var, Expr min, Expr extent) {
 Func &Func::tile(VarOrRVar x, VarOrRVar y,
                  VarOrRVar xo, VarOrRVar yo,
                  VarOrRVar xi, VarOrRVar yi,
-                 Expr xfactor, Expr yfactor) {
+                 Expr xfactor, Expr yfactor,
+                 TailStrategy tail) {
     invalidate_cache();
-    Stage(func.schedule(), name()).tile(x, y, xo, yo, xi, yi, xfactor, yfactor);
+    Stage(func.schedule(), name()).tile(x, y, xo, yo, xi, yi, xfactor, yfactor, tail);
     return *this;
 }
 
 Func &Func::tile(VarOrRVar x, VarOrRVar y,
                  VarOrRVar xi, VarOrRVar yi,
-                 Expr xfactor, Expr yfactor) {
+                 Expr xfactor, Expr yfactor,
+                 TailStrategy tail) {
     invalidate_cache();
-    Stage(func.schedule(), name()).tile(x, y, xi, yi, xfactor, yfactor);
+    Stage(func.schedule(), name()).tile(x, y, xi, yi, xfactor, yfactor, tail);
     return *this;
 }
 
@@ -1060,14 +1081,14 @@ Func &Func::glsl(Var x, Var y, Var c) {
 Func &Func::reorder_storage(Var x, Var y) {
     invalidate_cache();
 
-    vector<string> &dims = func.schedule().storage_dims();
+    vector<StorageDim> &dims = func.schedule().storage_dims();
     bool found_y = false;
     size_t y_loc = 0;
     for (size_t i = 0; i < dims.size(); i++) {
-        if (var_name_match(dims[i], y.name())) {
+        if (var_name_match(dims[i].var, y.name())) {
             found_y = true;
             y_loc = i;
-        } else if (var_name_match(dims[i], x.name())) {
+        } else if (var_name_match(dims[i].var, x.name())) {
             if (found_y) std::swap(dims[i], dims[y_loc]);
             return *this;
         }
@@ -1096,6 +1117,25 @@ Func &Func::reorder_storage(const std::vector<Var> &dims) {
     return reorder_storage(dims, 0);
 }
 
+Func &Func::fold_storage(Var dim, Expr factor) {
+    invalidate_cache();
+
+    user_assert(factor.defined() && (factor.type().is_int() || factor.type().is_uint()))
+        << "Can't fold storage of " << name() << " in dimension " << dim.name()
+        << " by a non-integer factor.\n";
+
+    vector<StorageDim> &dims = func.schedule().storage_dims();
+    for (size_t i = 0; i < dims.size(); i++) {
+        if (var_name_match(dims[i].var, dim.name())) {
+            dims[i].fold_factor = cast<int>(factor);
+            return *this;
+        }
+    }
+    user_error << "Could not find dimension " << dim.name()
+               << " to fold in storage of " << name() << ".\n";
+    return *this;
+}
+
 Func &Func::compute_at(Func f, RVar var) {
     return compute_at(f, Var(var.name()));
 }
@@ -1110,6 +1150,14 @@ Func &Func::compute_at(Func f, Var var) {
     return *this;
 }
 
+Func &Func::compute_with(Func f, Var var) {
+    invalidate_cache();
+    user_assert(!f.function().same_as(func))
+        << "Can't compute " << name() << " with itself.\n";
+    func.schedule().compute_with_level() = LoopLevel(f.name(), var.name());
+    return *this;
+}
+
 Func &Func::compute_root() {
     invalidate_cache();
     func.schedule().compute_level() = LoopLevel::root();
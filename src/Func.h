@@ -44,7 +44,8 @@ class Stage {
     Internal::Schedule schedule;
     void set_dim_type(VarOrRVar var, Internal::ForType t);
     void set_dim_device_api(VarOrRVar var, DeviceAPI device_api);
-    void split(const std::string &old, const std::string &outer, const std::string &inner, Expr factor, bool exact);
+    void split(const std::string &old, const std::string &outer, const std::string &inner,
+               Expr factor, bool exact, TailStrategy tail);
     std::string stage_name;
 public:
     Stage(Internal::Schedule s, const std::string &n) :
@@ -61,22 +62,25 @@ public:
      * traversed. See the documentation for Func for the meanings. */
     // @{
 
-    EXPORT Stage &split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor);
+    EXPORT Stage &split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor,
+                        TailStrategy tail = TailStrategy::Auto);
     EXPORT Stage &fuse(VarOrRVar inner, VarOrRVar outer, VarOrRVar fused);
     EXPORT Stage &serial(VarOrRVar var);
     EXPORT Stage &parallel(VarOrRVar var);
     EXPORT Stage &vectorize(VarOrRVar var);
     EXPORT Stage &unroll(VarOrRVar var);
     EXPORT Stage &parallel(VarOrRVar var, Expr task_size);
-    EXPORT Stage &vectorize(VarOrRVar var, int factor);
-    EXPORT Stage &unroll(VarOrRVar var, int factor);
+    EXPORT Stage &vectorize(VarOrRVar var, int factor, TailStrategy tail = TailStrategy::Auto);
+    EXPORT Stage &unroll(VarOrRVar var, int factor, TailStrategy tail = TailStrategy::Auto);
     EXPORT Stage &tile(VarOrRVar x, VarOrRVar y,
                                 VarOrRVar xo, VarOrRVar yo,
                                 VarOrRVar xi, VarOrRVar yi, Expr
-                                xfactor, Expr yfactor);
+                                xfactor, Expr yfactor,
+                                TailStrategy tail = TailStrategy::Auto);
     EXPORT Stage &tile(VarOrRVar x, VarOrRVar y,
                                 VarOrRVar xi, VarOrRVar yi,
-                                Expr xfactor, Expr yfactor);
+                                Expr xfactor, Expr yfactor,
+                                TailStrategy tail = TailStrategy::Auto);
     EXPORT Stage &reorder(const std::vector<VarOrRVar> &vars);
 
     template <typename... Args>
@@ -817,8 +821,12 @@ public:
      * given names, where the inner dimension iterates from 0 to
      * factor-1. The inner and outer subdimensions can then be dealt
      * with using the other scheduling calls. It's ok to reuse the old
-     * variable name as either the inner or outer variable. */
-    EXPORT Func &split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor);
+     * variable name as either the inner or outer variable. The tail
+     * strategy controls what happens when the factor does not
+     * provably divide the extent of the dimension. See TailStrategy
+     * for the options. */
+    EXPORT Func &split(VarOrRVar old, VarOrRVar outer, VarOrRVar inner, Expr factor,
+                       TailStrategy tail = TailStrategy::Auto);
 
     /** Join two dimensions into a single fused dimenion. The fused
      * dimension covers the product of the extents of the inner and
@@ -844,7 +852,15 @@ public:
      * e.g. because it is the inner dimension following a split by a
      * constant factor. For most uses of vectorize you want the two
      * argument form. The variable to be vectorized should be the
-     * innermost one. */
+     * innermost one.
+     *
+     * The reduction variables of an update stage may be vectorized
+     * if the update has the form f(args) = f(args) op e, where op is
+     * +, *, min, or max and args don't depend on the reduction
+     * domain (e.g. a dot product, or the inner sum of a
+     * convolution). The values of e for each vector lane are
+     * combined with a horizontal reduction before updating f. Note
+     * that this reassociates floating point sums and products. */
     EXPORT Func &vectorize(VarOrRVar var);
 
     /** Mark a dimension to be completely unrolled. The dimension
@@ -857,14 +873,17 @@ public:
      * inner dimension. This is how you vectorize a loop of unknown
      * size. The variable to be vectorized should be the innermost
      * one. After this call, var refers to the outer dimension of the
-     * split. */
-    EXPORT Func &vectorize(VarOrRVar var, int factor);
+     * split. The tail strategy controls what happens when the factor
+     * does not divide the extent. TailStrategy::GuardWithIf computes
+     * the last partial vector with masked loads and stores, which
+     * also works for extents smaller than the factor. */
+    EXPORT Func &vectorize(VarOrRVar var, int factor, TailStrategy tail = TailStrategy::Auto);
 
     /** Split a dimension by the given factor, then unroll the inner
      * dimension. This is how you unroll a loop of unknown size by
      * some constant factor. After this call, var refers to the outer
-     * dimension of the split. */
-    EXPORT Func &unroll(VarOrRVar var, int factor);
+     * dimension of the split. The tail strategy is as for split. */
+    EXPORT Func &unroll(VarOrRVar var, int factor, TailStrategy tail = TailStrategy::Auto);
 
     /** Statically declare that the range over which a function should
      * be evaluated is given by the second and third arguments. This
@@ -878,17 +897,20 @@ public:
 
     /** Split two dimensions at once by the given factors, and then
      * reorder the resulting dimensions to be xi, yi, xo, yo from
-     * innermost outwards. This gives a tiled traversal. */
+     * innermost outwards. This gives a tiled traversal. The tail
+     * strategy applies to both splits. */
     EXPORT Func &tile(VarOrRVar x, VarOrRVar y,
                       VarOrRVar xo, VarOrRVar yo,
                       VarOrRVar xi, VarOrRVar yi,
-                      Expr xfactor, Expr yfactor);
+                      Expr xfactor, Expr yfactor,
+                      TailStrategy tail = TailStrategy::Auto);
 
     /** A shorter form of tile, which reuses the old variable names as
      * the new outer dimensions */
     EXPORT Func &tile(VarOrRVar x, VarOrRVar y,
                       VarOrRVar xi, VarOrRVar yi,
-                      Expr xfactor, Expr yfactor);
+                      Expr xfactor, Expr yfactor,
+                      TailStrategy tail = TailStrategy::Auto);
 
     /** Reorder variables to have the given nesting order, from
      * innermost out */
@@ -1228,6 +1250,23 @@ public:
     }
     // @}
 
+    /** Fold the storage of a dimension of this function modulo the
+     * given factor. Only the most recent 'factor' slices of the
+     * dimension are kept around, which shrinks the footprint of a
+     * line-buffered producer from the whole image to a few
+     * scanlines. Halide already does this automatically when it can
+     * prove the footprint per loop iteration is bounded by a
+     * constant; use this when it can't, e.g. when the factor depends
+     * on a Param. The factor may be any integer expression that does
+     * not depend on the loop variables. An assertion is injected to
+     * check at runtime that the region of the function used per
+     * iteration of the loop over which it is folded fits within the
+     * factor. Folding is still only legal over a serial loop for
+     * which the region used moves monotonically, and it is a compile
+     * error if no such loop exists. More than one dimension of a
+     * function may be folded. */
+    EXPORT Func &fold_storage(Var dim, Expr factor);
+
     /** Compute this function as needed for each unique value of the
      * given var for the given calling function f.
      *
@@ -1304,6 +1343,43 @@ public:
      * to the version of compute_at that takes a Var. */
     EXPORT Func &compute_at(Func f, RVar var);
 
+    /** Compute this function together with f, by fusing their loop
+     * nests from the outermost loop down to and including f's loop
+     * over var. Both functions must be computed and stored at the same
+     * level, must not have update definitions, and neither may use
+     * the other. The loops being fused must match in number, for loop
+     * type, and device API, but may have different bounds. The fused
+     * loops cover the union of their bounds, and each body is guarded
+     * by its own bounds. For example, for two outputs of a pipeline
+     * that read the same input:
+     *
+     \code
+     Func f, g;
+     Var x, y;
+     f(x, y) = in(x, y) * 2;
+     g(x, y) = in(x, y) + 1;
+     g.compute_with(f, y);
+     \endcode
+     *
+     * is equivalent to
+     *
+     \code
+     for (int y = 0; y < height; y++) {
+         for (int x = 0; x < width; x++) {
+             f[y][x] = in[y][x] * 2;
+         }
+         for (int x = 0; x < width; x++) {
+             g[y][x] = in[y][x] + 1;
+         }
+     }
+     \endcode
+     *
+     * so each row of the input is still in cache when g reads
+     * it. Any producers computed at f's fused loops are shared by
+     * both functions.
+     */
+    EXPORT Func &compute_with(Func f, Var var);
+
     /** Compute all of this function once ahead of time. Reusing
      * the example in \ref Func::compute_at :
      *
@@ -1347,6 +1423,15 @@ public:
      */
     EXPORT Func &memoize();
 
+    /** Write this function's values with non-temporal stores, which
+     * bypass the cache. Use this for large outputs that are written
+     * once and not read again soon, such as a full-frame conversion,
+     * so that they don't evict more useful data from the cache. Only
+     * applies to vector stores. On x86 these become movnt
+     * instructions when they are aligned to the vector size, and the
+     * stores are followed by an sfence. */
+    EXPORT Func &store_nontemporal();
+
 
     /** Allocate storage for this function within f's loop over
      * var. Scheduling storage is optional, and can be used to
@@ -1440,6 +1525,16 @@ public:
      * improves locality by reusing recently-accessed memory instead
      * of pulling new memory into cache.
      *
+     * If there is a parallel loop between the store_at and
+     * compute_at levels, each parallel task needs its own copy of
+     * g. If the region of g required moves along the parallel loop,
+     * the loop is divided into parallel strips of consecutive
+     * iterations. Each strip computes the full region required on its
+     * first iteration, and only the new values after that. For
+     * example, g.store_root().compute_at(f, y) with f.parallel(y)
+     * slides g down each strip of rows of f. Otherwise, each
+     * iteration of the parallel loop gets its own copy of g.
+     *
      */
     EXPORT Func &store_at(Func f, Var var);
 
@@ -639,6 +639,12 @@ Call::ConstString Call::likely = "likely";
 Call::ConstString Call::make_int64 = "make_int64";
 Call::ConstString Call::make_float64 = "make_float64";
 Call::ConstString Call::register_destructor = "register_destructor";
+Call::ConstString Call::vector_reduce_add = "vector_reduce_add";
+Call::ConstString Call::vector_reduce_mul = "vector_reduce_mul";
+Call::ConstString Call::vector_reduce_min = "vector_reduce_min";
+Call::ConstString Call::vector_reduce_max = "vector_reduce_max";
+Call::ConstString Call::nontemporal = "nontemporal";
+Call::ConstString Call::store_fence = "store_fence";
 
 }
 }
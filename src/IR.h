@@ -409,7 +409,13 @@ struct Call : public ExprNode<Call> {
         likely,
         make_int64,
         make_float64,
-        register_destructor;
+        register_destructor,
+        vector_reduce_add,
+        vector_reduce_mul,
+        vector_reduce_min,
+        vector_reduce_max,
+        nontemporal,
+        store_fence;
 
     // If it's a call to another halide function, this call node
     // holds onto a pointer to that function.
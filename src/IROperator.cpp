@@ -44,6 +44,57 @@ Expr evaluate_polynomial(Expr x, float *coeff, int n) {
         return odd_terms * x + even_terms;
     }
 }
+
+// A floating point constant of the same precision as the given
+// type. Double constants that don't fit in a FloatImm are encoded
+// exactly.
+Expr float_imm(Type t, double v) {
+    Expr e;
+    if (t.bits == 64) {
+        e = Internal::scalar_to_constant_expr<double>(v);
+    } else {
+        e = Internal::FloatImm::make((float)v);
+    }
+    if (t.is_vector()) {
+        e = Internal::Broadcast::make(e, t.width);
+    }
+    return e;
+}
+
+// The same, but with coefficients of the precision of x, which may
+// be Float(32) or Float(64).
+Expr evaluate_polynomial(Expr x, const double *coeff, int n) {
+    internal_assert(n >= 2);
+    Type t = x.type();
+
+    Expr x2 = x * x;
+
+    Expr even_terms = float_imm(t, coeff[0]);
+    Expr odd_terms = float_imm(t, coeff[1]);
+
+    for (int i = 2; i < n; i++) {
+        Expr c = float_imm(t, coeff[i]);
+        if ((i & 1) == 0) {
+            if (coeff[i] == 0.0) {
+                even_terms *= x2;
+            } else {
+                even_terms = even_terms * x2 + c;
+            }
+        } else {
+            if (coeff[i] == 0.0) {
+                odd_terms *= x2;
+            } else {
+                odd_terms = odd_terms * x2 + c;
+            }
+        }
+    }
+
+    if ((n & 1) == 0) {
+        return even_terms * x + odd_terms;
+    } else {
+        return odd_terms * x + even_terms;
+    }
+}
 }
 
 namespace Internal {
@@ -211,6 +262,50 @@ int int_cast_constant(Type t, int val) {
     return val;
 }
 
+Expr lossless_cast(Type t, Expr e) {
+    if (t == e.type()) {
+        return e;
+    } else if (t.can_represent(e.type())) {
+        return cast(t, e);
+    }
+
+    if (const Cast *c = e.as<Cast>()) {
+        if (t == c->value.type()) {
+            return c->value;
+        } else if (c->type.can_represent(c->value.type()) ||
+                   c->type.can_represent(t)) {
+            // Either the cast didn't change the value, or it can't
+            // have changed any value that fits in the narrower
+            // type, so we lose nothing by stripping it off and
+            // pressing onwards.
+            return lossless_cast(t, c->value);
+        } else {
+            return Expr();
+        }
+    }
+
+    if (const Broadcast *b = e.as<Broadcast>()) {
+        Expr v = lossless_cast(t.element_of(), b->value);
+        if (v.defined()) {
+            return Broadcast::make(v, b->width);
+        } else {
+            return Expr();
+        }
+    }
+
+    if (const IntImm *i = e.as<IntImm>()) {
+        if ((t.is_int() || t.is_uint()) &&
+            !(t.is_uint() && i->value < 0) &&
+            int_cast_constant(t, i->value) == i->value) {
+            return cast(t, e);
+        } else {
+            return Expr();
+        }
+    }
+
+    return Expr();
+}
+
 Expr make_const(Type t, int val) {
     if (t == Int(32)) return val;
     if (t == Float(32)) return (float)val;
@@ -365,8 +460,241 @@ void range_reduce_log(Expr input, Expr *reduced, Expr *exponent) {
     */
 }
 
+namespace {
+
+// Round to the nearest integer without using floor, which only
+// vectorizes well on some targets. Ties round away from zero.
+Expr round_to_int(Expr x) {
+    Type t = x.type();
+    Expr half = select(x < make_zero(t), float_imm(t, -0.5), float_imm(t, 0.5));
+    return cast(Int(32, t.width), x + half);
+}
+
+// Doubles with the given upper 16 bits and zeros below.
+Expr float64_from_high_bits(Type t, int high_bits) {
+    return reinterpret(t, cast(Int(64, t.width), high_bits) << 48);
+}
+
+// Compute 2^k for an Int(32) k in the range [-1022, 1023].
+Expr float64_pow2(Type t, Expr k) {
+    return reinterpret(t, cast(Int(64, t.width), k + 1023) << 52);
+}
+
+// The double-precision versions of the transcendentals below are
+// from Cephes (exp, sin, cos, atan) and fdlibm (log).
+
+Expr halide_exp_f64(Expr x_full) {
+    Type type = x_full.type();
+
+    // Clamp to the range where the result is neither zero nor inf.
+    Expr x = clamp(x_full, float_imm(type, -746.0), float_imm(type, 710.0));
+
+    Expr k = round_to_int(x * float_imm(type, 1.4426950408889634073599));
+    Expr k_real = cast(type, k);
+
+    x -= k_real * float_imm(type, 6.93145751953125E-1);
+    x -= k_real * float_imm(type, 1.42860682030941723212E-6);
+
+    // A Pade approximant in the reduced domain.
+    double p[] = {1.26177193074810590878E-4,
+                  3.02994407707441961300E-2,
+                  9.99999999999999999910E-1};
+    double q[] = {3.00198505138664455042E-6,
+                  2.52448340349684104192E-3,
+                  2.27265548208155028766E-1,
+                  2.00000000000000000009E0};
+    Expr x2 = x * x;
+    Expr px = x * evaluate_polynomial(x2, p, 3);
+    Expr qx = evaluate_polynomial(x2, q, 4);
+    Expr result = float_imm(type, 1.0) + float_imm(type, 2.0) * (px / (qx - px));
+
+    // Multiply by 2^k in two steps, so that neither factor overflows
+    // or becomes subnormal.
+    Expr k1 = k >> 1;
+    Expr k2 = k - k1;
+    result *= float64_pow2(type, k1);
+    result *= float64_pow2(type, k2);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr halide_log_f64(Expr x_full) {
+    Type type = x_full.type();
+    Type int_type = Int(32, type.width);
+    Type i64_type = Int(64, type.width);
+
+    Expr nan = float64_from_high_bits(type, 0x7ff8);
+    Expr neg_inf = float64_from_high_bits(type, -16);
+    Expr inf = float64_from_high_bits(type, 0x7ff0);
+
+    Expr use_nan = x_full < make_zero(type);
+    Expr use_neg_inf = x_full == make_zero(type);
+    Expr use_inf = x_full == inf;
+    Expr exceptional = use_nan | use_neg_inf | use_inf;
+
+    Expr patched = select(exceptional, make_one(type), x_full);
+
+    // Scale subnormals up into the normal range.
+    Expr subnormal = patched < float_imm(type, 2.2250738585072014e-308);
+    patched = select(subnormal, patched * float_imm(type, 18014398509481984.0), patched);
+
+    // Split into 2^k * m, with m in [1, 2).
+    Expr bits = reinterpret(i64_type, patched);
+    Expr k = cast(int_type, bits >> 52) - select(subnormal,
+                                                  make_const(int_type, 1023 + 54),
+                                                  make_const(int_type, 1023));
+    Expr mantissa_mask = (cast(i64_type, 1) << 52) - 1;
+    Expr m = reinterpret(type, (bits & mantissa_mask) | (cast(i64_type, 1023) << 52));
+
+    // Move m into [sqrt(2)/2, sqrt(2)].
+    Expr big = m > float_imm(type, 1.41421356237309504880);
+    m = select(big, m * float_imm(type, 0.5), m);
+    k = select(big, k + 1, k);
+
+    double lg[] = {1.479819860511658591e-01,
+                   1.531383769920937332e-01,
+                   1.818357216161805012e-01,
+                   2.222219843214978396e-01,
+                   2.857142874366239149e-01,
+                   3.999999999940941908e-01,
+                   6.666666666666735130e-01};
+
+    Expr f = m - make_one(type);
+    Expr s = f / (float_imm(type, 2.0) + f);
+    Expr z = s * s;
+    Expr r = z * evaluate_polynomial(z, lg, 7);
+    Expr hfsq = float_imm(type, 0.5) * f * f;
+    Expr k_real = cast(type, k);
+
+    Expr result = (k_real * float_imm(type, 6.93147180369123816490e-01) -
+                   ((hfsq - (s * (hfsq + r) + k_real * float_imm(type, 1.90821492927058770002e-10))) - f));
+
+    result = select(exceptional, select(use_nan, nan, select(use_inf, inf, neg_inf)), result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr sin_or_cos(Expr x, bool is_cos, bool fast) {
+    Type type = x.type();
+    bool f64 = (type.bits == 64);
+
+    // Reduce to [-pi/4, pi/4] by subtracting a multiple of pi/2,
+    // which is split into pieces that multiply exactly by k.
+    Expr k = round_to_int(x * float_imm(type, 0.63661977236758134308));
+    Expr k_real = cast(type, k);
+    Expr r;
+    if (f64) {
+        r = x - k_real * float_imm(type, 2 * 7.85398125648498535156E-1);
+        r -= k_real * float_imm(type, 2 * 3.77489470793079817668E-8);
+        r -= k_real * float_imm(type, 2 * 2.69515142907905952645E-15);
+    } else if (fast) {
+        r = x - k_real * 1.5703125f;
+        r -= k_real * float_imm(type, 1.57079632679489661923 - 1.5703125);
+    } else {
+        r = x - k_real * 1.5703125f;
+        r -= k_real * 4.837512969970703125e-4f;
+        r -= k_real * 7.54978995489188216e-8f;
+    }
+
+    Expr z = r * r;
+    Expr one = make_one(type), half = float_imm(type, 0.5);
+    Expr s, c;
+    if (f64) {
+        double sc[] = {1.58962301576546568060E-10,
+                       -2.50507477628578072866E-8,
+                       2.75573136213857245213E-6,
+                       -1.98412698295895385996E-4,
+                       8.33333333332211858878E-3,
+                       -1.66666666666666307295E-1};
+        double cc[] = {-1.13585365213876817300E-11,
+                       2.08757008419747316778E-9,
+                       -2.75573141792967388112E-7,
+                       2.48015872888517045348E-5,
+                       -1.38888888888730564116E-3,
+                       4.16666666666665929218E-2};
+        s = r + r * z * evaluate_polynomial(z, sc, 6);
+        c = one - half * z + z * z * evaluate_polynomial(z, cc, 6);
+    } else if (fast) {
+        double sc[] = {0.008152990891364507, -0.1666283372554649};
+        double cc[] = {0.04048893995943097, -0.49977630913955967};
+        s = r + r * z * evaluate_polynomial(z, sc, 2);
+        c = one + z * evaluate_polynomial(z, cc, 2);
+    } else {
+        double sc[] = {-1.9515295891E-4, 8.3321608736E-3, -1.6666654611E-1};
+        double cc[] = {2.443315711809948E-5, -1.388731625493765E-3, 4.166664568298827E-2};
+        s = r + r * z * evaluate_polynomial(z, sc, 3);
+        c = one - half * z + z * z * evaluate_polynomial(z, cc, 3);
+    }
+
+    // cos(x) = sin(x + pi/2). The low bit of the quadrant picks
+    // between the polynomials, and the next bit gives the sign.
+    Type int_type = k.type();
+    Expr quadrant = is_cos ? k + 1 : k;
+    Expr result = select((quadrant & make_one(int_type)) != 0, c, s);
+    result = select((quadrant & make_two(int_type)) != 0, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr atan_impl(Expr x_full) {
+    Type type = x_full.type();
+    bool f64 = (type.bits == 64);
+
+    Expr x = abs(x_full);
+    Expr one = make_one(type);
+
+    // Reduce to a small range using atan(x) = pi/2 - atan(1/x) and
+    // atan(x) = pi/4 + atan((x-1)/(x+1)).
+    Expr big = x > float_imm(type, 2.41421356237309504880);
+    Expr mid = x > float_imm(type, f64 ? 0.66 : 0.41421356237309504880);
+    Expr y0 = select(big, float_imm(type, 1.57079632679489661923),
+                     mid, float_imm(type, 0.78539816339744830962),
+                     make_zero(type));
+    Expr t = select(big, -one / x,
+                    mid, (x - one) / (x + one),
+                    x);
+    Expr z = t * t;
+
+    Expr result;
+    if (f64) {
+        double p[] = {-8.750608600031904122785E-1,
+                      -1.615753718733365076637E1,
+                      -7.500855792314704667340E1,
+                      -1.228866684490136173410E2,
+                      -6.485021904942025371773E1};
+        double q[] = {1.0,
+                      2.485846490142306297962E1,
+                      1.650270098316988542046E2,
+                      4.328810604912902668951E2,
+                      4.853903996359136964868E2,
+                      1.945506571482613964425E2};
+        Expr r = z * evaluate_polynomial(z, p, 5) / evaluate_polynomial(z, q, 6);
+        r = t * r + t;
+        // Add back the low bits of the multiple of pi/4.
+        double more_bits = 6.123233995736765886130E-17;
+        r += select(big, float_imm(type, more_bits),
+                    mid, float_imm(type, 0.5 * more_bits),
+                    make_zero(type));
+        result = y0 + r;
+    } else {
+        double p[] = {8.05374449538e-2,
+                      -1.38776856032E-1,
+                      1.99777106478E-1,
+                      -3.33329491539E-1};
+        result = y0 + (evaluate_polynomial(z, p, 4) * z * t + t);
+    }
+
+    result = select(x_full < make_zero(type), -result, result);
+    return result;
+}
+
+}
+
 Expr halide_log(Expr x_full) {
     Type type = x_full.type();
+    if (type.element_of() == Float(64)) {
+        return halide_log_f64(x_full);
+    }
     internal_assert(type.element_of() == Float(32));
 
     Expr nan = Call::make(type, "nan_f32", std::vector<Expr>(), Call::Extern);
@@ -411,6 +739,9 @@ Expr halide_log(Expr x_full) {
 
 Expr halide_exp(Expr x_full) {
     Type type = x_full.type();
+    if (type.element_of() == Float(64)) {
+        return halide_exp_f64(x_full);
+    }
     internal_assert(type.element_of() == Float(32));
 
     float ln2_part1 = 0.6931457519f;
@@ -496,6 +827,32 @@ Expr halide_erf(Expr x_full) {
     return result;
 }
 
+Expr halide_sin(Expr x) {
+    internal_assert(x.type().is_float());
+    return sin_or_cos(x, false, false);
+}
+
+Expr halide_cos(Expr x) {
+    internal_assert(x.type().is_float());
+    return sin_or_cos(x, true, false);
+}
+
+Expr halide_atan(Expr x) {
+    internal_assert(x.type().is_float());
+    return common_subexpression_elimination(atan_impl(x));
+}
+
+Expr halide_atan2(Expr y, Expr x) {
+    Type type = x.type();
+    internal_assert(type.is_float() && y.type() == type);
+
+    Expr result = atan_impl(y / x);
+    Expr pi = float_imm(type, 3.14159265358979323846);
+    result = select(x < make_zero(type), result + select(y < make_zero(type), -pi, pi), result);
+    result = select(x == make_zero(type) && y == make_zero(type), make_zero(type), result);
+    return common_subexpression_elimination(result);
+}
+
 Expr raise_to_integer_power(Expr e, int p) {
     Expr result;
     if (p == 0) {
@@ -568,6 +925,16 @@ Expr fast_exp(Expr x_full) {
     return result;
 }
 
+Expr fast_sin(Expr x) {
+    user_assert(x.type() == Float(32)) << "fast_sin only works for Float(32)";
+    return Internal::sin_or_cos(x, false, true);
+}
+
+Expr fast_cos(Expr x) {
+    user_assert(x.type() == Float(32)) << "fast_cos only works for Float(32)";
+    return Internal::sin_or_cos(x, true, true);
+}
+
 Expr print(const std::vector<Expr> &args) {
     // Insert spaces between each expr.
     std::vector<Expr> print_args(args.size()*2);
@@ -76,6 +76,12 @@ EXPORT bool is_no_op(Stmt s);
  */
 EXPORT int int_cast_constant(Type t, int val);
 
+/** Attempt to cast an expression to a smaller type while provably not
+ * losing information. Strips off widening casts, and narrows
+ * constants that fit in the new type. If it can't be done, returns
+ * an undefined Expr. */
+EXPORT Expr lossless_cast(Type t, Expr e);
+
 /** Construct a const of the given type */
 EXPORT Expr make_const(Type t, int val);
 
@@ -144,6 +150,10 @@ EXPORT void match_types(Expr &a, Expr &b);
 EXPORT Expr halide_log(Expr a);
 EXPORT Expr halide_exp(Expr a);
 EXPORT Expr halide_erf(Expr a);
+EXPORT Expr halide_sin(Expr a);
+EXPORT Expr halide_cos(Expr a);
+EXPORT Expr halide_atan(Expr a);
+EXPORT Expr halide_atan2(Expr y, Expr x);
 // @}
 
 /** Raise an expression to an integer power by repeatedly multiplying
@@ -597,8 +607,11 @@ inline Expr select(Expr c1, Expr v1,
 // No backend supports these yet.
 
 /** Return the sine of a floating-point expression. If the argument is
- * not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * not floating-point, it is cast to Float(32). Scalar sines call the
+ * system sin function. Vector sines are computed inline, and are
+ * accurate to within 2 ulps for Float(32) arguments of magnitude less
+ * than 8192, and within 2 ulps for Float(64) arguments of magnitude
+ * less than 1e7. Vectorizes cleanly. */
 inline Expr sin(Expr x) {
     user_assert(x.defined()) << "sin of undefined Expr\n";
     if (x.type() == Float(64)) {
@@ -629,8 +642,9 @@ inline Expr asin(Expr x) {
 }
 
 /** Return the cosine of a floating-point expression. If the argument
- * is not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * is not floating-point, it is cast to Float(32). Scalar cosines call
+ * the system cos function. Vector cosines are computed inline with
+ * the same accuracy as sin. Vectorizes cleanly. */
 inline Expr cos(Expr x) {
     user_assert(x.defined()) << "cos of undefined Expr\n";
     if (x.type() == Float(64)) {
@@ -677,8 +691,10 @@ inline Expr tan(Expr x) {
 }
 
 /** Return the arctangent of a floating-point expression. If the
- * argument is not floating-point, it is cast to Float(32). Does not
- * vectorize well. */
+ * argument is not floating-point, it is cast to Float(32). Scalar
+ * arctangents call the system atan function. Vector arctangents are
+ * computed inline, and are accurate to within 3 ulps for Float(32)
+ * and 1 ulp for Float(64). Vectorizes cleanly. */
 inline Expr atan(Expr x) {
     user_assert(x.defined()) << "atan of undefined Expr\n";
     if (x.type() == Float(64)) {
@@ -693,8 +709,10 @@ inline Expr atan(Expr x) {
 }
 
 /** Return the angle of a floating-point gradient. If the argument is
- * not floating-point, it is cast to Float(32). Does not vectorize
- * well. */
+ * not floating-point, it is cast to Float(32). Scalar calls use the
+ * system atan2 function. Vector calls are computed inline, and are
+ * accurate to within 3 ulps for Float(32) and 2 ulps for
+ * Float(64). Vectorizes cleanly. */
 inline Expr atan2(Expr y, Expr x) {
     user_assert(x.defined() && y.defined()) << "atan2 of undefined Expr\n";
 
@@ -834,11 +852,12 @@ inline Expr hypot(Expr x, Expr y) {
 
 /** Return the exponential of a floating-point expression. If the
  * argument is not floating-point, it is cast to Float(32). For
- * Float(64) arguments, this calls the system exp function, and does
- * not vectorize well. For Float(32) arguments, this function is
- * vectorizable, does the right thing for extremely small or extremely
- * large inputs, and is accurate up to the last bit of the
- * mantissa. Vectorizes cleanly. */
+ * scalar Float(64) arguments, this calls the system exp
+ * function. Vector Float(64) arguments are computed inline to within
+ * 2 ulps. For Float(32) arguments, this function is vectorizable,
+ * does the right thing for extremely small or extremely large inputs,
+ * and is accurate up to the last bit of the mantissa. Vectorizes
+ * cleanly. */
 inline Expr exp(Expr x) {
     user_assert(x.defined()) << "exp of undefined Expr\n";
     if (x.type() == Float(64)) {
@@ -854,11 +873,11 @@ inline Expr exp(Expr x) {
 
 /** Return the logarithm of a floating-point expression. If the
  * argument is not floating-point, it is cast to Float(32). For
- * Float(64) arguments, this calls the system log function, and does
- * not vectorize well. For Float(32) arguments, this function is
- * vectorizable, does the right thing for inputs <= 0 (returns -inf or
- * nan), and is accurate up to the last bit of the
- * mantissa. Vectorizes cleanly. */
+ * scalar Float(64) arguments, this calls the system log
+ * function. Vector Float(64) arguments are computed inline to within
+ * 1 ulp. For Float(32) arguments, this function is vectorizable, does
+ * the right thing for inputs <= 0 (returns -inf or nan), and is
+ * accurate up to the last bit of the mantissa. Vectorizes cleanly. */
 inline Expr log(Expr x) {
     user_assert(x.defined()) << "log of undefined Expr\n";
     if (x.type() == Float(64)) {
@@ -875,9 +894,10 @@ inline Expr log(Expr x) {
 /** Return one floating point expression raised to the power of
  * another. The type of the result is given by the type of the first
  * argument. If the first argument is not a floating-point type, it is
- * cast to Float(32). For Float(32), cleanly vectorizable, and
- * accurate up to the last few bits of the mantissa. Gets worse when
- * approaching overflow. Vectorizes cleanly. */
+ * cast to Float(32). For Float(32) and vector Float(64) arguments,
+ * cleanly vectorizable, and accurate up to the last few bits of the
+ * mantissa. Gets worse when approaching overflow. Vectorizes
+ * cleanly. */
 inline Expr pow(Expr x, Expr y) {
     user_assert(x.defined() && y.defined()) << "pow of undefined Expr\n";
 
@@ -920,6 +940,15 @@ EXPORT Expr fast_log(Expr x);
  * approaching overflow. Vectorizes cleanly. */
 EXPORT Expr fast_exp(Expr x);
 
+/** Fast approximate cleanly vectorizable sine and cosine for
+ * Float(32). Uses a shorter polynomial than sin and cos. The absolute
+ * error is less than 2e-5 for arguments of magnitude less than
+ * 8192. Vectorizes cleanly. */
+// @{
+EXPORT Expr fast_sin(Expr x);
+EXPORT Expr fast_cos(Expr x);
+// @}
+
 /** Fast approximate cleanly vectorizable pow for Float(32). Returns
  * nonsense for x < 0.0f. Accurate up to the last 5 bits of the
  * mantissa for typical exponents. Gets worse when approaching
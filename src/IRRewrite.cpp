@@ -0,0 +1,534 @@
+#include <algorithm>
+#include <iostream>
+
+#include "IRRewrite.h"
+#include "IREquality.h"
+#include "IROperator.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The most wildcards a rule can have.
+const int max_wildcards = 8;
+
+// Get pointers to the operands of the types of node that rewrite
+// rules can contain. Returns the number of operands, or -1 for other
+// types of node.
+int operands_of(const Expr &e, const Expr **ops) {
+    const IRNodeType *t = e.ptr->type_info();
+
+#define BINARY_OPERANDS(T)                      \
+    if (t == &T::_type_info) {                  \
+        const T *op = (const T *)e.ptr;         \
+        ops[0] = &op->a;                        \
+        ops[1] = &op->b;                        \
+        return 2;                               \
+    }
+
+    BINARY_OPERANDS(Add)
+    BINARY_OPERANDS(Sub)
+    BINARY_OPERANDS(Mul)
+    BINARY_OPERANDS(Div)
+    BINARY_OPERANDS(Mod)
+    BINARY_OPERANDS(Min)
+    BINARY_OPERANDS(Max)
+    BINARY_OPERANDS(EQ)
+    BINARY_OPERANDS(NE)
+    BINARY_OPERANDS(LT)
+    BINARY_OPERANDS(LE)
+    BINARY_OPERANDS(GT)
+    BINARY_OPERANDS(GE)
+    BINARY_OPERANDS(And)
+    BINARY_OPERANDS(Or)
+
+#undef BINARY_OPERANDS
+
+    if (t == &Not::_type_info) {
+        ops[0] = &((const Not *)e.ptr)->a;
+        return 1;
+    }
+    if (t == &Select::_type_info) {
+        const Select *op = (const Select *)e.ptr;
+        ops[0] = &op->condition;
+        ops[1] = &op->true_value;
+        ops[2] = &op->false_value;
+        return 3;
+    }
+    return -1;
+}
+
+// Make a node of one of the types that operands_of understands.
+Expr make_node(const IRNodeType *t, const Expr &a, const Expr &b, const Expr &c) {
+
+#define MAKE_BINARY(T)                          \
+    if (t == &T::_type_info) {                  \
+        return T::make(a, b);                   \
+    }
+
+    MAKE_BINARY(Add)
+    MAKE_BINARY(Sub)
+    MAKE_BINARY(Mul)
+    MAKE_BINARY(Div)
+    MAKE_BINARY(Mod)
+    MAKE_BINARY(Min)
+    MAKE_BINARY(Max)
+    MAKE_BINARY(EQ)
+    MAKE_BINARY(NE)
+    MAKE_BINARY(LT)
+    MAKE_BINARY(LE)
+    MAKE_BINARY(GT)
+    MAKE_BINARY(GE)
+    MAKE_BINARY(And)
+    MAKE_BINARY(Or)
+
+#undef MAKE_BINARY
+
+    if (t == &Not::_type_info) {
+        return Not::make(a);
+    }
+    internal_assert(t == &Select::_type_info);
+    return Select::make(a, b, c);
+}
+
+// Is an expression an integer constant, or a cast or broadcast of
+// one?
+bool const_value(Expr e, int *value) {
+    if (const IntImm *i = e.as<IntImm>()) {
+        *value = i->value;
+        return true;
+    } else if (const Cast *c = e.as<Cast>()) {
+        return const_value(c->value, value);
+    } else if (const Broadcast *b = e.as<Broadcast>()) {
+        return const_value(b->value, value);
+    }
+    return false;
+}
+
+// Is a variable in a rewrite rule a constant wildcard?
+bool is_const_wildcard_name(const string &name) {
+    if (name.size() < 2 || name[0] != 'c') return false;
+    for (size_t i = 1; i < name.size(); i++) {
+        if (name[i] < '0' || name[i] > '9') return false;
+    }
+    return true;
+}
+
+// Check two compiled rule nodes are the same.
+template<typename NodeT>
+bool same_node(const NodeT &a, const NodeT &b) {
+    if (a.type != b.type || a.wildcard != b.wildcard ||
+        a.is_const != b.is_const || a.value != b.value ||
+        a.operands.size() != b.operands.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.operands.size(); i++) {
+        if (!same_node(a.operands[i], b.operands[i])) return false;
+    }
+    return true;
+}
+
+}
+
+RewriteRules::Node RewriteRules::compile(Expr e, map<string, int> &wildcards, bool in_pattern) {
+    Node n;
+    n.type = NULL;
+    n.wildcard = -1;
+    n.const_wildcard = false;
+    n.is_const = false;
+    n.folds = false;
+    n.value = 0;
+
+    const Expr *ops[3];
+    int num_ops;
+    if (const Variable *var = e.as<Variable>()) {
+        n.const_wildcard = is_const_wildcard_name(var->name);
+        map<string, int>::iterator iter = wildcards.find(var->name);
+        if (iter != wildcards.end()) {
+            n.wildcard = iter->second;
+        } else {
+            internal_assert(in_pattern)
+                << "Rewrite rule replacement or predicate uses " << var->name << ", which isn't in the pattern\n";
+            n.wildcard = (int)wildcards.size();
+            internal_assert(n.wildcard < max_wildcards)
+                << "Rewrite rule has more than " << max_wildcards << " wildcards\n";
+            wildcards[var->name] = n.wildcard;
+        }
+        n.folds = !in_pattern && n.const_wildcard;
+    } else if (const_value(e, &n.value)) {
+        n.is_const = true;
+        n.folds = !in_pattern;
+    } else if ((num_ops = operands_of(e, ops)) >= 0) {
+        n.type = e.ptr->type_info();
+        n.folds = !in_pattern;
+        for (int i = 0; i < num_ops; i++) {
+            n.operands.push_back(compile(*ops[i], wildcards, in_pattern));
+            n.folds = n.folds && n.operands.back().folds;
+        }
+    } else {
+        internal_error << "Can't use " << e << " in a rewrite rule\n";
+    }
+    return n;
+}
+
+vector<const IRNodeType *> RewriteRules::types_matched_by(const Node &n) const {
+    vector<const IRNodeType *> types;
+    if (n.const_wildcard) {
+        types.push_back(&IntImm::_type_info);
+    } else if (n.is_const) {
+        types.push_back(&IntImm::_type_info);
+        types.push_back(&FloatImm::_type_info);
+        types.push_back(&Cast::_type_info);
+        types.push_back(&Broadcast::_type_info);
+    } else if (n.type) {
+        types.push_back(n.type);
+    }
+    return types;
+}
+
+RewriteRules::RewriteRules(const string &n, const vector<RewriteRule> &input_rules) :
+    name(n), root_type(NULL), num_wildcards(0), hits(input_rules.size()) {
+
+    internal_assert(!input_rules.empty()) << "No rewrite rules for " << name << "\n";
+
+    for (size_t i = 0; i < input_rules.size(); i++) {
+        const RewriteRule &r = input_rules[i];
+        map<string, int> wildcards;
+        Node pattern = compile(r.pattern, wildcards, true);
+        internal_assert(pattern.type) << "Rewrite rule " << r.name << " has no node at the root of its pattern\n";
+        if (!root_type) {
+            root_type = pattern.type;
+        }
+        internal_assert(pattern.type == root_type)
+            << "Rewrite rule " << r.name << " has a different type of node at its root to the other rules for " << name << "\n";
+
+        CompiledRule c;
+        c.name = r.name;
+        c.operands = pattern.operands;
+        c.replacement = compile(r.replacement, wildcards, false);
+        c.replacement_operand = -1;
+        for (size_t j = 0; !c.replacement.is_const && j < c.operands.size(); j++) {
+            if (same_node(c.replacement, c.operands[j])) {
+                c.replacement_operand = (int)j;
+                break;
+            }
+        }
+        c.has_predicate = r.predicate.defined();
+        if (c.has_predicate) {
+            c.predicate = compile(r.predicate, wildcards, false);
+            internal_assert(c.predicate.folds)
+                << "The predicate of rewrite rule " << r.name << " may only use constants and constant wildcards\n";
+        }
+        c.rewrite_result = r.rewrite_result;
+        rules.push_back(c);
+
+        num_wildcards = std::max(num_wildcards, (int)wildcards.size());
+        hits[i] = 0;
+    }
+
+    // Build the decision tree. An empty list of types means the
+    // operand can be anything.
+    vector<vector<const IRNodeType *> > first(rules.size()), second(rules.size());
+    for (size_t i = 0; i < rules.size(); i++) {
+        first[i] = types_matched_by(rules[i].operands[0]);
+        if (rules[i].operands.size() > 1) {
+            second[i] = types_matched_by(rules[i].operands[1]);
+        }
+        for (const IRNodeType *t : first[i]) {
+            if (find_type(first_types, t) < 0) first_types.push_back(t);
+        }
+        for (const IRNodeType *t : second[i]) {
+            if (find_type(second_types, t) < 0) second_types.push_back(t);
+        }
+    }
+    first_types.push_back(NULL);
+    second_types.push_back(NULL);
+    for (const IRNodeType *f : first_types) {
+        for (const IRNodeType *s : second_types) {
+            vector<int> c;
+            for (size_t i = 0; i < rules.size(); i++) {
+                if ((first[i].empty() || (f && find_type(first[i], f) >= 0)) &&
+                    (second[i].empty() || (s && find_type(second[i], s) >= 0))) {
+                    c.push_back((int)i);
+                }
+            }
+            candidates.push_back(c);
+        }
+    }
+}
+
+int RewriteRules::find_type(const vector<const IRNodeType *> &types, const IRNodeType *t) const {
+    for (size_t i = 0; i < types.size(); i++) {
+        if (types[i] == t) return (int)i;
+    }
+    return -1;
+}
+
+RewriteRules::~RewriteRules() {
+    if (get_env_variable("HL_REWRITE_RULE_STATS").empty()) {
+        return;
+    }
+    std::cerr << "Rewrite rules for " << name << ":\n";
+    for (size_t i = 0; i < rules.size(); i++) {
+        std::cerr << "  " << rules[i].name << ": " << hits[i] << "\n";
+    }
+}
+
+bool RewriteRules::match(const Node &p, const Expr &e, Expr *bindings) const {
+    if (p.wildcard >= 0) {
+        if (p.const_wildcard && e.ptr->type_info() != &IntImm::_type_info) {
+            return false;
+        }
+        Expr &b = bindings[p.wildcard];
+        if (b.defined()) {
+            return equal(b, e);
+        }
+        b = e;
+        return true;
+    } else if (p.is_const) {
+        return is_const(e, p.value);
+    } else if (e.ptr->type_info() != p.type) {
+        return false;
+    }
+
+    const Expr *ops[3];
+    operands_of(e, ops);
+    for (size_t i = 0; i < p.operands.size(); i++) {
+        if (!match(p.operands[i], *ops[i], bindings)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RewriteRules::evaluate(const Node &n, const Expr *bindings, int64_t *result) const {
+    if (n.wildcard >= 0) {
+        *result = ((const IntImm *)bindings[n.wildcard].ptr)->value;
+        return true;
+    } else if (n.is_const) {
+        *result = n.value;
+        return true;
+    }
+
+    int64_t v[3];
+    for (size_t i = 0; i < n.operands.size(); i++) {
+        if (!evaluate(n.operands[i], bindings, &v[i])) {
+            return false;
+        }
+    }
+
+    const IRNodeType *t = n.type;
+    if (t == &Add::_type_info) {
+        *result = v[0] + v[1];
+    } else if (t == &Sub::_type_info) {
+        *result = v[0] - v[1];
+    } else if (t == &Mul::_type_info) {
+        *result = v[0] * v[1];
+    } else if (t == &Div::_type_info || t == &Mod::_type_info) {
+        // Division rounds down and the remainder is never negative,
+        // as in the IR.
+        if (v[1] == 0) return false;
+        int64_t r = v[0] % v[1];
+        if (r < 0) r += v[1] < 0 ? -v[1] : v[1];
+        *result = (t == &Mod::_type_info) ? r : (v[0] - r) / v[1];
+    } else if (t == &Min::_type_info) {
+        *result = std::min(v[0], v[1]);
+    } else if (t == &Max::_type_info) {
+        *result = std::max(v[0], v[1]);
+    } else if (t == &EQ::_type_info) {
+        *result = v[0] == v[1];
+    } else if (t == &NE::_type_info) {
+        *result = v[0] != v[1];
+    } else if (t == &LT::_type_info) {
+        *result = v[0] < v[1];
+    } else if (t == &LE::_type_info) {
+        *result = v[0] <= v[1];
+    } else if (t == &GT::_type_info) {
+        *result = v[0] > v[1];
+    } else if (t == &GE::_type_info) {
+        *result = v[0] >= v[1];
+    } else if (t == &And::_type_info) {
+        *result = v[0] && v[1];
+    } else if (t == &Or::_type_info) {
+        *result = v[0] || v[1];
+    } else if (t == &Not::_type_info) {
+        *result = !v[0];
+    } else {
+        internal_assert(t == &Select::_type_info);
+        *result = v[0] ? v[1] : v[2];
+    }
+    // Constant wildcards are 32-bit, so give up on anything that
+    // doesn't fit in one.
+    return *result == (int32_t)*result;
+}
+
+Expr RewriteRules::build(const Node &r, Type t, const Expr *bindings) const {
+    if (r.wildcard >= 0 && !r.folds) {
+        return bindings[r.wildcard];
+    } else if (r.folds) {
+        int64_t value;
+        if (!evaluate(r, bindings, &value)) {
+            return Expr();
+        }
+        return make_const(t, (int)value);
+    }
+
+    // Build the operands that aren't constants first, so that the
+    // constants can take their type. The condition of a select
+    // doesn't count.
+    Expr ops[3];
+    Type operand_type = t;
+    for (size_t i = 0; i < r.operands.size(); i++) {
+        if (!r.operands[i].folds) {
+            ops[i] = build(r.operands[i], t, bindings);
+            if (!ops[i].defined()) {
+                return Expr();
+            }
+            if (i > 0 || r.type != &Select::_type_info) {
+                operand_type = ops[i].type();
+            }
+        }
+    }
+    for (size_t i = 0; i < r.operands.size(); i++) {
+        if (r.operands[i].folds) {
+            ops[i] = build(r.operands[i], operand_type, bindings);
+            if (!ops[i].defined()) {
+                return Expr();
+            }
+        }
+    }
+    return make_node(r.type, ops[0], ops[1], ops[2]);
+}
+
+Expr RewriteRules::apply(Type t, const Expr &a, const Expr &b, const Expr &c, bool *rewrite_result) const {
+    // Types of node no rule asks for are the last entry, NULL.
+    int f = find_type(first_types, a.ptr->type_info());
+    if (f < 0) f = (int)first_types.size() - 1;
+    int s = (int)second_types.size() - 1;
+    if (b.defined()) {
+        s = find_type(second_types, b.ptr->type_info());
+        if (s < 0) s = (int)second_types.size() - 1;
+    }
+    const vector<int> &rules_to_try = candidates[f * second_types.size() + s];
+    if (rules_to_try.empty()) {
+        return Expr();
+    }
+
+    const Expr *ops[3] = {&a, &b, &c};
+    Expr bindings[max_wildcards];
+    for (size_t i = 0; i < rules_to_try.size(); i++) {
+        const CompiledRule &r = rules[rules_to_try[i]];
+        for (int j = 0; j < num_wildcards; j++) {
+            bindings[j] = Expr();
+        }
+        bool matched = true;
+        for (size_t j = 0; matched && j < r.operands.size(); j++) {
+            matched = match(r.operands[j], *ops[j], bindings);
+        }
+        if (!matched) continue;
+
+        int64_t holds = 1;
+        if (r.has_predicate && (!evaluate(r.predicate, bindings, &holds) || !holds)) {
+            continue;
+        }
+
+        Expr result;
+        if (r.replacement_operand >= 0) {
+            result = *ops[r.replacement_operand];
+        } else {
+            result = build(r.replacement, t, bindings);
+            if (!result.defined()) continue;
+        }
+
+        hits[rules_to_try[i]]++;
+        if (rewrite_result) {
+            *rewrite_result = r.rewrite_result;
+        }
+        return result;
+    }
+    return Expr();
+}
+
+map<string, uint64_t> RewriteRules::hit_counts() const {
+    map<string, uint64_t> counts;
+    for (size_t i = 0; i < rules.size(); i++) {
+        counts[rules[i].name] = hits[i];
+    }
+    return counts;
+}
+
+void rewrite_rules_test() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+
+    RewriteRules rules("test", {
+        RewriteRule("cancel", (x + y) - y, x),
+        RewriteRule("self", x - x, 0),
+        RewriteRule("zero", x - 0, x)
+    });
+
+    Expr a = Variable::make(Int(32), "a");
+    Expr b = Variable::make(Int(32), "b");
+    Expr u = Variable::make(UInt(8), "u");
+
+    // A wildcard used twice must match the same thing both times.
+    internal_assert(equal(rules.apply(Int(32), a*2 + b, b), a*2));
+    internal_assert(!rules.apply(Int(32), a*2 + b, a).defined());
+
+    // Wildcards and constants match any type, and constants in the
+    // replacement take the type of the expression being rewritten.
+    internal_assert(equal(rules.apply(UInt(8), u, u), make_zero(UInt(8))));
+    internal_assert(equal(rules.apply(UInt(8), u, make_zero(UInt(8))), u));
+    internal_assert(equal(rules.apply(Int(32, 4), Broadcast::make(a, 4), Broadcast::make(0, 4)),
+                          Broadcast::make(a, 4)));
+
+    internal_assert(!rules.apply(Int(32), a, b).defined());
+
+    map<string, uint64_t> hits = rules.hit_counts();
+    internal_assert(hits["cancel"] == 1 && hits["self"] == 1 && hits["zero"] == 2);
+
+    Expr c0 = Variable::make(Int(32), "c0");
+    Expr c1 = Variable::make(Int(32), "c1");
+
+    RewriteRules const_rules("test_const", {
+        RewriteRule("min_min", min(min(x, c0), c1), min(x, c0), c0 <= c1),
+        RewriteRule("min_min_fold", min(min(x, c0), c1), min(x, c1)),
+        RewriteRule("min_mul", min(x * c0, c1), min(x, c1 / c0) * c0, c0 > 0 && c1 % c0 == 0),
+        RewriteRule("min_sub", min(x, y), x - (x - y))
+    });
+
+    // The predicate picks between rules, and the first returns the
+    // operand it matched.
+    Expr m = min(a, 3);
+    internal_assert(const_rules.apply(Int(32), m, 5).same_as(m));
+    internal_assert(equal(const_rules.apply(Int(32), m, 2), min(a, 2)));
+
+    // Constant wildcards only match integer constants.
+    Expr e = const_rules.apply(Int(32), min(a, b), 2);
+    internal_assert(equal(e, min(a, b) - (min(a, b) - 2)));
+
+    // Constants are folded, with division rounding down.
+    internal_assert(equal(const_rules.apply(Int(32), a * 4, -8), min(a, -2) * 4));
+    internal_assert(equal(const_rules.apply(Int(32), a * 4, -6), (a * 4) - ((a * 4) - (-6))));
+
+    // Constants in the replacement take the type of what they're
+    // combined with.
+    e = rules.apply(UInt(8), u + u, u);
+    internal_assert(equal(e, u));
+    RewriteRules typed_rules("test_typed", {
+        RewriteRule("neg", 0 - x, x * -1)
+    });
+    e = typed_rules.apply(Int(16), make_zero(Int(16)), Variable::make(Int(16), "v"));
+    internal_assert(e.defined() && e.type() == Int(16) && equal(e, Variable::make(Int(16), "v") * make_const(Int(16), -1)));
+
+    std::cout << "Rewrite rules test passed" << std::endl;
+}
+
+}
+}
@@ -0,0 +1,139 @@
+#ifndef HALIDE_IR_REWRITE_H
+#define HALIDE_IR_REWRITE_H
+
+/** \file
+ * Defines a way to rewrite IR with tables of declarative rules
+ */
+
+#include <atomic>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** A rule that rewrites anything that matches the pattern into the
+ * replacement. Variables in the pattern are wildcards that match any
+ * expression of any type, and a variable used more than once must
+ * match equal expressions each time. Variables named c0, c1, etc. are
+ * constant wildcards, which only match integer constants. Other
+ * constants in the pattern match constants (or broadcasts of
+ * constants) of the same value and any type. The replacement is made
+ * from the matched expressions. Constants in it, and parts of it that
+ * only use constants and constant wildcards, are folded, and get the
+ * type of the expression they're combined with (or of the expression
+ * being rewritten, if they're the entire replacement). Patterns and
+ * replacements may only contain arithmetic, comparisons, logical
+ * operators and selects.
+ *
+ * A rule may also have a predicate, made from constants and the
+ * constant wildcards in the pattern, which must be true for the rule
+ * to apply.
+ *
+ * For example:
+ \code
+ Expr x = Variable::make(Int(32), "x"), y = Variable::make(Int(32), "y");
+ Expr c0 = Variable::make(Int(32), "c0"), c1 = Variable::make(Int(32), "c1");
+ RewriteRule("not_lt", !(x < y), y <= x);
+ RewriteRule("min_min_const", min(min(x, c0), c1), min(x, c0), c0 <= c1);
+ \endcode
+ */
+struct RewriteRule {
+    std::string name;
+    Expr pattern, replacement, predicate;
+
+    /** Whether the replacement should itself be rewritten further
+     * before it's used, because it may have more rules that apply. */
+    bool rewrite_result;
+
+    RewriteRule(const std::string &n, Expr p, Expr r, bool again = false) :
+        name(n), pattern(p), replacement(r), rewrite_result(again) {}
+
+    RewriteRule(const std::string &n, Expr p, Expr r, Expr pred, bool again = false) :
+        name(n), pattern(p), replacement(r), predicate(pred), rewrite_result(again) {}
+};
+
+/** A list of rewrite rules that all have the same type of node at the
+ * root of their pattern, compiled into a decision tree. The types of
+ * node of the first two operands (which also say whether they might
+ * be constants) pick the rules that could match, so most rules are
+ * ruled out without walking their patterns. The rules are tried in
+ * order and the first that matches wins. Each rule counts the number of times it fires. Set the
+ * environment variable HL_REWRITE_RULE_STATS to print these counts at
+ * exit. */
+class RewriteRules {
+public:
+    EXPORT RewriteRules(const std::string &name, const std::vector<RewriteRule> &rules);
+    EXPORT ~RewriteRules();
+
+    /** Rewrite a node of the given type with the given operands
+     * (e.g. a and b of an Add, or the condition, true value and false
+     * value of a Select), using the first rule that matches. Returns
+     * an undefined Expr if none do. If rewrite_result is non-NULL,
+     * it's set to whether the matching rule asked for its result to
+     * be rewritten again. */
+    EXPORT Expr apply(Type t, const Expr &a, const Expr &b = Expr(), const Expr &c = Expr(),
+                      bool *rewrite_result = NULL) const;
+
+    /** The number of times each rule has fired, by rule name. */
+    EXPORT std::map<std::string, uint64_t> hit_counts() const;
+
+private:
+    struct Node {
+        // The type of node, or NULL for wildcards and constants
+        const IRNodeType *type;
+        int wildcard;
+        bool const_wildcard;
+        bool is_const;
+        // Whether this is a node in a replacement or predicate that
+        // only uses constants and constant wildcards.
+        bool folds;
+        int value;
+        std::vector<Node> operands;
+    };
+
+    struct CompiledRule {
+        std::string name;
+        std::vector<Node> operands;
+        Node replacement;
+        // Which operand the replacement is the same as, or -1.
+        int replacement_operand;
+        bool has_predicate;
+        Node predicate;
+        bool rewrite_result;
+    };
+
+    std::string name;
+    const IRNodeType *root_type;
+    std::vector<CompiledRule> rules;
+    int num_wildcards;
+
+    // The decision tree. The types of node that some rule asks for
+    // as the first and second operand, followed by NULL for any other
+    // type. There are only ever a few, so these are searched
+    // linearly.
+    std::vector<const IRNodeType *> first_types, second_types;
+    // The rules that might match, in order, for each pair of entries
+    // in first_types and second_types.
+    std::vector<std::vector<int> > candidates;
+
+    mutable std::vector<std::atomic<uint64_t> > hits;
+
+    Node compile(Expr e, std::map<std::string, int> &wildcards, bool in_pattern);
+    std::vector<const IRNodeType *> types_matched_by(const Node &n) const;
+    int find_type(const std::vector<const IRNodeType *> &types, const IRNodeType *t) const;
+    bool match(const Node &p, const Expr &e, Expr *bindings) const;
+    bool evaluate(const Node &n, const Expr *bindings, int64_t *result) const;
+    Expr build(const Node &r, Type t, const Expr *bindings) const;
+};
+
+EXPORT void rewrite_rules_test();
+
+}
+}
+
+#endif
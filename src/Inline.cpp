@@ -83,6 +83,16 @@ class Inliner : public IRMutator {
                          << s.bounds()[i].extent << "] because the function is scheduled inline.\n";
         }
 
+        for (size_t i = 0; i < s.storage_dims().size(); i++) {
+            if (s.storage_dims()[i].fold_factor.defined()) {
+                user_warning << "It is meaningless to fold the storage of dimension "
+                             << s.storage_dims()[i].var << " of function "
+                             << f.name() << " by a factor of "
+                             << s.storage_dims()[i].fold_factor
+                             << " because the function is scheduled inline.\n";
+            }
+        }
+
     }
 
     void visit(const Call *op) {
@@ -8,22 +8,51 @@
  */
 
 #include <stdlib.h>
+#include <atomic>
 
 #include "Util.h"
 
 namespace Halide {
 namespace Internal {
 
-/** A class representing a reference count to be used with IntrusivePtr */
+/** A class representing a reference count to be used with
+ * IntrusivePtr. The count is atomic, so that handles to the same
+ * object (e.g. a Pipeline's Parameters and JITModule) can be copied
+ * and destroyed on several threads at once. */
 class RefCount {
-    int count;
+    std::atomic<int> count;
 public:
     RefCount() : count(0) {}
-    void increment() {count++;}
-    void decrement() {count--;}
+    // A copy of an object isn't referred to by anything yet.
+    RefCount(const RefCount &) : count(0) {}
+    RefCount &operator=(const RefCount &) {return *this;}
+    int increment() {return ++count;}
+    int decrement() {return --count;}
     bool is_zero() const {return count == 0;}
 };
 
+/** A reference count that is not atomic. IR nodes use this: lowering
+ * copies Expr and Stmt handles constantly, and a locked increment on
+ * each copy nearly doubles the time it takes. Lowering isn't
+ * thread-safe anyway (e.g. unique_name keeps global state), and
+ * realizing a compiled Pipeline doesn't copy any IR, so nothing
+ * copies IR handles on two threads at once. */
+class UnsyncedRefCount {
+    int count;
+public:
+    UnsyncedRefCount() : count(0) {}
+    int increment() {return ++count;}
+    int decrement() {return --count;}
+    bool is_zero() const {return count == 0;}
+};
+
+/** The kind of reference count stored in a T. Specialize this for
+ * classes that use an UnsyncedRefCount. */
+template<typename T>
+struct RefCountType {
+    typedef RefCount type;
+};
+
 /**
  * Because in this header we don't yet know how client classes store
  * their RefCount (and we don't want to depend on the declarations of
@@ -39,7 +68,7 @@ public:
  * template<> void destroy<MyClass>(const MyClass *c) {delete c;}
  */
 // @{
-template<typename T> EXPORT RefCount &ref_count(const T *);
+template<typename T> EXPORT typename RefCountType<T>::type &ref_count(const T *);
 template<typename T> EXPORT void destroy(const T *);
 // @}
 
@@ -70,8 +99,7 @@ private:
             // the counts due to the cycle. The next line then makes
             // the ref_count negative, which prevents actually
             // entering the destructor recursively.
-            ref_count(p).decrement();
-            if (ref_count(p).is_zero()) {
+            if (ref_count(p).decrement() == 0) {
                 destroy(p);
             }
         }
@@ -4,6 +4,7 @@
 #include <set>
 
 #include "CodeGen_Internal.h"
+#include "CompileStats.h"
 #include "JITModule.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Runtime_Linker.h"
@@ -233,6 +234,7 @@ JITModule::JITModule(const Module &m, const LoweredFunc &fn,
 void JITModule::compile_module(llvm::Module *m, const string &function_name, const Target &target,
                                const std::vector<JITModule> &dependencies,
                                const std::vector<std::string> &requested_exports) {
+    CompilePhaseTimer timer("machine_codegen");
 
     // Make the execution engine
     debug(2) << "Creating new execution engine\n";
@@ -2,6 +2,7 @@
 #include "LLVM_Output.h"
 #include "CodeGen_LLVM.h"
 #include "CodeGen_C.h"
+#include "CompileStats.h"
 
 #include <iostream>
 #include <fstream>
@@ -204,6 +205,7 @@ void emit_file_legacy(llvm::Module *module, const std::string &filename, llvm::T
 #endif
 
 void emit_file(llvm::Module *module, const std::string &filename, llvm::TargetMachine::CodeGenFileType file_type) {
+    Internal::CompilePhaseTimer timer("machine_codegen");
 #if LLVM_VERSION < 37
     emit_file_legacy(module, filename, file_type);
 #else
@@ -0,0 +1,249 @@
+#include "LLVM_Parallel_Optimizer.h"
+#include "LLVM_Headers.h"
+#include "LLVM_Runtime_Linker.h"
+#include "Debug.h"
+#include "Error.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <stdlib.h>
+#include <thread>
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// The number of parts modules have been split into so far.
+std::atomic<int> parts_made(0);
+
+llvm::Module *parse_part(const string &buf, llvm::LLVMContext *context) {
+    llvm::Module *mod = parse_bitcode_file(buf, context, "part");
+    internal_assert(mod) << "Failed to parse the bitcode of an optimized part of a module\n";
+    return mod;
+}
+
+string write_bitcode(llvm::Module *m) {
+    string bitcode;
+    llvm::raw_string_ostream out(bitcode);
+    llvm::WriteBitcodeToFile(m, out);
+    out.flush();
+    return bitcode;
+}
+
+llvm::Module *clone_module(llvm::Module *m) {
+    #if LLVM_VERSION >= 38
+    return llvm::CloneModule(m).release();
+    #else
+    return llvm::CloneModule(m);
+    #endif
+}
+
+size_t function_size(const llvm::Function &f) {
+    size_t size = 0;
+    for (llvm::Function::const_iterator b = f.begin(); b != f.end(); b++) {
+        size += b->size();
+    }
+    return size;
+}
+
+// Link src into dst, and destroy src.
+void link_into(llvm::Module *dst, llvm::Module *src) {
+    string err_msg;
+    #if LLVM_VERSION >= 36
+    bool failed = llvm::Linker::LinkModules(dst, src);
+    #else
+    bool failed = llvm::Linker::LinkModules(dst, src,
+                                            llvm::Linker::DestroySource, &err_msg);
+    #endif
+    internal_assert(!failed) << "Failure linking optimized modules: " << err_msg << "\n";
+    delete src;
+}
+
+// Optimize one part of a module in an llvm context of its own, which
+// is what lets several of them run at once. Replaces the bitcode with
+// the optimized bitcode.
+void optimize_part(string *bitcode, void (*optimize)(llvm::Module *)) {
+    llvm::LLVMContext context;
+    llvm::Module *m = parse_part(*bitcode, &context);
+    optimize(m);
+    *bitcode = write_bitcode(m);
+    delete m;
+}
+
+// Make a symbol with local linkage visible to the other parts while
+// the module is split up, and remember its linkage.
+void externalize(llvm::GlobalValue *gv, map<string, llvm::GlobalValue::LinkageTypes> &local_linkage) {
+    if (gv->isDeclaration() || !gv->hasLocalLinkage()) {
+        return;
+    }
+    if (!gv->hasName()) {
+        gv->setName("halide_local");
+    }
+    local_linkage[gv->getName()] = gv->getLinkage();
+    gv->setLinkage(llvm::GlobalValue::ExternalLinkage);
+}
+
+// Turn a definition into one that the optimizer may look at (to
+// inline it or fold its value), but which doesn't get emitted,
+// because the real definition is in another part.
+void make_available_externally(llvm::GlobalValue *g) {
+    g->setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+    #if LLVM_VERSION >= 35
+    llvm::cast<llvm::GlobalObject>(g)->setComdat(NULL);
+    #endif
+}
+
+}
+
+int num_codegen_threads() {
+    string threads = get_env_variable("HL_NUM_CODEGEN_THREADS");
+    if (threads.empty()) {
+        return 1;
+    }
+    int n = atoi(threads.c_str());
+    if (n <= 0) {
+        n = (int)std::thread::hardware_concurrency();
+    }
+    return std::max(n, 1);
+}
+
+int parallel_optimizer_parts_made() {
+    return parts_made;
+}
+
+llvm::Module *optimize_module_in_parallel(llvm::Module *module,
+                                          const vector<string> &functions,
+                                          int num_threads,
+                                          void (*optimize)(llvm::Module *)) {
+    // Find the functions to split off, largest first.
+    vector<std::pair<size_t, string>> work;
+    for (size_t i = 0; i < functions.size(); i++) {
+        llvm::Function *f = module->getFunction(functions[i]);
+        if (f && !f->isDeclaration()) {
+            work.push_back(std::make_pair(function_size(*f), functions[i]));
+        }
+    }
+    std::sort(work.rbegin(), work.rend());
+
+    size_t num_parts = std::min(work.size(), (size_t)std::max(num_threads, 1));
+    if (num_parts < 2) {
+        optimize(module);
+        return module;
+    }
+
+    debug(1) << "Optimizing " << work.size() << " functions in "
+             << num_parts << " parts\n";
+    parts_made += (int)num_parts;
+
+    // Deal the functions out to the part with the least code in it so
+    // far.
+    map<string, size_t> part_of;
+    vector<size_t> part_size(num_parts, 0);
+    for (size_t i = 0; i < work.size(); i++) {
+        size_t p = std::min_element(part_size.begin(), part_size.end()) - part_size.begin();
+        part_of[work[i].second] = p;
+        part_size[p] += work[i].first;
+    }
+
+    // The parts refer to each other's functions (e.g. to pass a
+    // parallel loop body to the runtime), and to the globals and
+    // runtime in the first part, so nothing they share can be local
+    // while they're apart.
+    map<string, llvm::GlobalValue::LinkageTypes> local_linkage;
+    for (llvm::Module::iterator iter = module->begin(); iter != module->end(); iter++) {
+        externalize(&*iter, local_linkage);
+    }
+    for (llvm::Module::global_iterator iter = module->global_begin(); iter != module->global_end(); iter++) {
+        externalize(&*iter, local_linkage);
+    }
+
+    vector<llvm::Module *> parts(num_parts);
+    parts[0] = module;
+    for (size_t p = 1; p < num_parts; p++) {
+        parts[p] = clone_module(module);
+    }
+
+    for (size_t p = 0; p < num_parts; p++) {
+        llvm::Module *m = parts[p];
+        for (llvm::Module::iterator iter = m->begin(); iter != m->end(); iter++) {
+            if (iter->isDeclaration()) continue;
+            map<string, size_t>::iterator owner = part_of.find(iter->getName());
+            if (owner != part_of.end()) {
+                if (owner->second != p) {
+                    iter->deleteBody();
+                }
+            } else if (p > 0) {
+                make_available_externally(&*iter);
+            }
+        }
+
+        if (p > 0) {
+            // The first part holds the real globals. Appending ones
+            // like the list of constructors can't be shared at all.
+            vector<llvm::GlobalVariable *> appending;
+            for (llvm::Module::global_iterator iter = m->global_begin(); iter != m->global_end(); iter++) {
+                if (iter->hasAppendingLinkage()) {
+                    appending.push_back(&*iter);
+                } else if (!iter->isDeclaration()) {
+                    make_available_externally(&*iter);
+                }
+            }
+            for (size_t i = 0; i < appending.size(); i++) {
+                appending[i]->eraseFromParent();
+            }
+        }
+    }
+
+    // An llvm context can only be used by one thread at a time, so
+    // move all but the first part into contexts of their own.
+    vector<string> bitcode(num_parts);
+    for (size_t p = 1; p < num_parts; p++) {
+        bitcode[p] = write_bitcode(parts[p]);
+        delete parts[p];
+        parts[p] = NULL;
+    }
+
+    vector<std::thread> threads;
+    for (size_t p = 1; p < num_parts; p++) {
+        threads.push_back(std::thread(optimize_part, &bitcode[p], optimize));
+    }
+    optimize(module);
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    for (size_t p = 1; p < num_parts; p++) {
+        llvm::Module *part = parse_part(bitcode[p], &module->getContext());
+        link_into(module, part);
+    }
+
+    // Put back the local linkage, and drop anything the optimized
+    // parts no longer use.
+    for (map<string, llvm::GlobalValue::LinkageTypes>::iterator iter = local_linkage.begin();
+         iter != local_linkage.end(); iter++) {
+        llvm::GlobalValue *gv = module->getNamedValue(iter->first);
+        if (gv && !gv->isDeclaration()) {
+            gv->setLinkage(iter->second);
+        }
+    }
+
+    #if LLVM_VERSION < 37
+    llvm::PassManager pass_manager;
+    #else
+    llvm::legacy::PassManager pass_manager;
+    #endif
+    pass_manager.add(llvm::createGlobalDCEPass());
+    pass_manager.run(*module);
+
+    return module;
+}
+
+}
+}
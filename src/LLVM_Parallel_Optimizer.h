@@ -0,0 +1,46 @@
+#ifndef HALIDE_LLVM_PARALLEL_OPTIMIZER_H
+#define HALIDE_LLVM_PARALLEL_OPTIMIZER_H
+
+/** \file
+ * Support for running the llvm optimizer on several parts of a module
+ * at once.
+ */
+
+#include <string>
+#include <vector>
+
+#include "Util.h"
+
+namespace llvm {
+class Module;
+}
+
+namespace Halide {
+namespace Internal {
+
+/** The number of threads to use when optimizing llvm modules. Set
+ * by the environment variable HL_NUM_CODEGEN_THREADS, and one (meaning
+ * optimize serially) if that isn't set. Zero means one per core. */
+int num_codegen_threads();
+
+/** Split the named functions of an llvm module into up to num_threads
+ * parts, run the given optimizer on each part on its own thread and
+ * llvm context, and link the parts back together. Everything else in
+ * the module (the runtime, globals) stays in the first part, and the
+ * other parts get available_externally copies of it so that it can
+ * still be inlined. Takes ownership of the input module, and returns
+ * the optimized one, which is in the same llvm context. */
+llvm::Module *optimize_module_in_parallel(llvm::Module *module,
+                                          const std::vector<std::string> &functions,
+                                          int num_threads,
+                                          void (*optimize)(llvm::Module *));
+
+/** The number of parts that optimize_module_in_parallel has split
+ * modules into so far, not counting modules it optimized whole. For
+ * testing. */
+EXPORT int parallel_optimizer_parts_made();
+
+}
+}
+
+#endif
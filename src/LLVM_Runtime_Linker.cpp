@@ -1,12 +1,19 @@
 #include "LLVM_Runtime_Linker.h"
 #include "LLVM_Headers.h"
+#include "Debug.h"
+
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <stdio.h>
 
 namespace Halide {
 
 using std::string;
 using std::vector;
 
-namespace {
+namespace Internal {
 
 llvm::Module *parse_bitcode_file(llvm::StringRef buf, llvm::LLVMContext *context, const char *id) {
 
@@ -16,10 +23,16 @@ llvm::Module *parse_bitcode_file(llvm::StringRef buf, llvm::LLVMContext *context
     llvm::MemoryBuffer *bitcode_buffer = llvm::MemoryBuffer::getMemBuffer(buf);
     #endif
 
-    #if LLVM_VERSION >= 37
-    llvm::Module *mod = llvm::parseBitcodeFile(bitcode_buffer, *context).get().release();
-    #elif LLVM_VERSION >= 35
-    llvm::Module *mod = llvm::parseBitcodeFile(bitcode_buffer, *context).get();
+    #if LLVM_VERSION >= 35
+    auto result = llvm::parseBitcodeFile(bitcode_buffer, *context);
+    llvm::Module *mod = NULL;
+    if (result) {
+        #if LLVM_VERSION >= 37
+        mod = result.get().release();
+        #else
+        mod = result.get();
+        #endif
+    }
     #else
     llvm::Module *mod = llvm::ParseBitcodeFile(bitcode_buffer, *context);
     #endif
@@ -28,20 +41,42 @@ llvm::Module *parse_bitcode_file(llvm::StringRef buf, llvm::LLVMContext *context
     delete bitcode_buffer;
     #endif
 
-    mod->setModuleIdentifier(id);
+    if (mod) {
+        mod->setModuleIdentifier(id);
+    }
 
     return mod;
 }
 
 }
 
+namespace {
+
+// The bitcode of every initial module, so that the runtime cache can
+// tell when they have changed.
+vector<std::pair<const unsigned char *, const int *>> &initmod_bitcode() {
+    static vector<std::pair<const unsigned char *, const int *>> bitcode;
+    return bitcode;
+}
+
+struct RegisterInitmod {
+    RegisterInitmod(const unsigned char *bitcode, const int *length) {
+        initmod_bitcode().push_back(std::make_pair(bitcode, length));
+    }
+};
+
+}
+
 #define DECLARE_INITMOD(mod)                                            \
     extern "C" unsigned char halide_internal_initmod_##mod[];           \
     extern "C" int halide_internal_initmod_##mod##_length;              \
+    static RegisterInitmod register_initmod_##mod(halide_internal_initmod_##mod, \
+                                                  &halide_internal_initmod_##mod##_length); \
     llvm::Module *get_initmod_##mod(llvm::LLVMContext *context) {      \
         llvm::StringRef sb = llvm::StringRef((const char *)halide_internal_initmod_##mod, \
                                              halide_internal_initmod_##mod##_length); \
-        llvm::Module *module = parse_bitcode_file(sb, context, #mod);   \
+        llvm::Module *module = Internal::parse_bitcode_file(sb, context, #mod); \
+        internal_assert(module) << "Failed to parse runtime module " #mod "\n"; \
         return module;                                                  \
     }
 
@@ -165,10 +200,12 @@ DECLARE_LL_INITMOD(ptx_compute_35)
 #endif
 #ifdef WITH_X86
 DECLARE_LL_INITMOD(x86_avx)
+DECLARE_LL_INITMOD(x86_avx2)
 DECLARE_LL_INITMOD(x86)
 DECLARE_LL_INITMOD(x86_sse41)
 #else
 DECLARE_NO_INITMOD(x86_avx)
+DECLARE_NO_INITMOD(x86_avx2)
 DECLARE_NO_INITMOD(x86)
 DECLARE_NO_INITMOD(x86_sse41)
 #endif
@@ -537,6 +574,151 @@ void add_underscores_to_posix_calls_on_windows(llvm::Module *m) {
     }
 }
 
+namespace {
+
+// Parsing and linking the dozens of initial modules takes a large
+// share of the time to compile a small pipeline, and the result only
+// depends on the target, the kind of module wanted, and the build of
+// Halide. We keep the bitcode of each linked runtime for the rest of
+// the process. If HL_RUNTIME_CACHE_DIR is set, we also keep it there,
+// so that later processes (e.g. each generator in a build) can skip
+// the linking too. Parsing copies everything out of the bitcode, so
+// entries can be dropped at any time. We keep the most recently used
+// few, which is plenty for the handful of targets a process compiles
+// for.
+std::mutex runtime_cache_mutex;
+int runtime_cache_hit_count = 0;
+const size_t runtime_cache_capacity = 16;
+
+// Key and bitcode, most recently used first.
+typedef std::list<std::pair<string, string> > RuntimeCache;
+
+RuntimeCache &runtime_cache() {
+    static RuntimeCache cache;
+    return cache;
+}
+
+RuntimeCache::iterator find_cached_runtime(const string &key) {
+    RuntimeCache &cache = runtime_cache();
+    for (RuntimeCache::iterator iter = cache.begin(); iter != cache.end(); iter++) {
+        if (iter->first == key) {
+            cache.splice(cache.begin(), cache, iter);
+            return cache.begin();
+        }
+    }
+    return cache.end();
+}
+
+void add_cached_runtime(const string &key, const string &bitcode) {
+    RuntimeCache &cache = runtime_cache();
+    cache.push_front(std::make_pair(key, bitcode));
+    while (cache.size() > runtime_cache_capacity) {
+        cache.pop_back();
+    }
+}
+
+string runtime_cache_file(const string &dir, const string &key) {
+    return dir + "/halide_runtime." + key + ".bc";
+}
+
+// Identifies the build of Halide, so that runtimes cached on disk by
+// another build aren't used. This is the llvm version and a hash
+// (64-bit FNV-1a) of the bitcode of all the initial modules.
+string compute_runtime_build_stamp() {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const std::pair<const unsigned char *, const int *> &bitcode : initmod_bitcode()) {
+        for (int i = 0; i < *bitcode.second; i++) {
+            hash = (hash ^ bitcode.first[i]) * 1099511628211ULL;
+        }
+    }
+    std::ostringstream oss;
+    oss << "llvm" << LLVM_VERSION << "." << std::hex << hash;
+    return oss.str();
+}
+
+const string &runtime_build_stamp() {
+    // Initialized once, even if several threads get here at once.
+    static const string stamp = compute_runtime_build_stamp();
+    return stamp;
+}
+
+llvm::Module *load_cached_runtime(const string &key, llvm::LLVMContext *c) {
+    std::lock_guard<std::mutex> lock(runtime_cache_mutex);
+    RuntimeCache &cache = runtime_cache();
+    RuntimeCache::iterator iter = find_cached_runtime(key);
+    if (iter == cache.end()) {
+        string dir = get_env_variable("HL_RUNTIME_CACHE_DIR");
+        if (dir.empty()) {
+            return NULL;
+        }
+        std::ifstream f(runtime_cache_file(dir, key).c_str(), std::ios::binary);
+        if (!f) {
+            return NULL;
+        }
+        std::ostringstream bitcode;
+        bitcode << f.rdbuf();
+        if (bitcode.str().empty()) {
+            return NULL;
+        }
+        debug(2) << "Loaded runtime " << key << " from " << dir << "\n";
+        add_cached_runtime(key, bitcode.str());
+        iter = cache.begin();
+    }
+    llvm::Module *m = parse_bitcode_file(iter->second, c, key.c_str());
+    if (!m) {
+        // Drop a corrupt entry, so that the runtime gets linked and
+        // saved again.
+        debug(1) << "Cached runtime " << key << " failed to parse. Relinking it.\n";
+        cache.erase(iter);
+        string dir = get_env_variable("HL_RUNTIME_CACHE_DIR");
+        if (!dir.empty()) {
+            remove(runtime_cache_file(dir, key).c_str());
+        }
+        return NULL;
+    }
+    debug(2) << "Using cached runtime " << key << "\n";
+    runtime_cache_hit_count++;
+    return m;
+}
+
+void save_cached_runtime(const string &key, llvm::Module *m) {
+    string bitcode;
+    llvm::raw_string_ostream out(bitcode);
+    llvm::WriteBitcodeToFile(m, out);
+    out.flush();
+
+    std::lock_guard<std::mutex> lock(runtime_cache_mutex);
+    RuntimeCache::iterator iter = find_cached_runtime(key);
+    if (iter != runtime_cache().end()) {
+        iter->second = bitcode;
+    } else {
+        add_cached_runtime(key, bitcode);
+    }
+
+    string dir = get_env_variable("HL_RUNTIME_CACHE_DIR");
+    if (!dir.empty()) {
+        // Write to a temporary file first, so that another process
+        // never sees a partially written file.
+        string filename = runtime_cache_file(dir, key);
+        string tmp_filename = filename + "." + unique_name('t');
+        {
+            std::ofstream f(tmp_filename.c_str(), std::ios::binary);
+            f.write(bitcode.data(), bitcode.size());
+        }
+        if (rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+            remove(tmp_filename.c_str());
+        }
+        debug(2) << "Saved runtime " << key << " to " << dir << "\n";
+    }
+}
+
+}
+
+int runtime_cache_hits() {
+    std::lock_guard<std::mutex> lock(runtime_cache_mutex);
+    return runtime_cache_hit_count;
+}
+
 /** Create an llvm module containing the support code for a given target. */
 llvm::Module *get_initial_module_for_target(Target t, llvm::LLVMContext *c, bool for_shared_jit_runtime, bool just_gpu) {
     enum InitialModuleType {
@@ -563,6 +745,11 @@ llvm::Module *get_initial_module_for_target(Target t, llvm::LLVMContext *c, bool
 
     //    Halide::Internal::debug(0) << "Getting initial module type " << (int)module_type << "\n";
 
+    string cache_key = t.to_string() + "." + std::to_string((int)module_type) + "." + runtime_build_stamp();
+    if (llvm::Module *m = load_cached_runtime(cache_key, c)) {
+        return m;
+    }
+
     internal_assert(t.bits == 32 || t.bits == 64);
     // NaCl always uses the 32-bit runtime modules, because pointers
     // and size_t are 32-bit in 64-bit NaCl, and that's the only way
@@ -675,6 +862,9 @@ llvm::Module *get_initial_module_for_target(Target t, llvm::LLVMContext *c, bool
             if (t.has_feature(Target::AVX)) {
                 modules.push_back(get_initmod_x86_avx_ll(c));
             }
+            if (t.has_feature(Target::AVX2)) {
+                modules.push_back(get_initmod_x86_avx2_ll(c));
+            }
             if (t.has_feature(Target::Profile)) {
                 modules.push_back(get_initmod_profiler_inlined(c, bits_64, debug));
             }
@@ -759,6 +949,8 @@ llvm::Module *get_initial_module_for_target(Target t, llvm::LLVMContext *c, bool
         add_underscores_to_posix_calls_on_windows(modules[0]);
     }
 
+    save_cached_runtime(cache_key, modules[0]);
+
     return modules[0];
 }
 
@@ -10,15 +10,25 @@
 namespace llvm {
 class Module;
 class LLVMContext;
+class StringRef;
 }
 
 namespace Halide {
 
 namespace Internal {
 
+/** Parse llvm bitcode into a module in the given context, with the
+ * given identifier. Returns NULL if the bitcode can't be parsed. */
+llvm::Module *parse_bitcode_file(llvm::StringRef buf, llvm::LLVMContext *context, const char *id);
+
 /** Create an llvm module containing the support code for a given target. */
 llvm::Module *get_initial_module_for_target(Target, llvm::LLVMContext *, bool for_shared_jit_runtime = false, bool just_gpu = false);
 
+/** The number of times get_initial_module_for_target has used a
+ * cached runtime, either from memory or from HL_RUNTIME_CACHE_DIR,
+ * instead of linking one. For testing. */
+EXPORT int runtime_cache_hits();
+
 /** Create an llvm module containing the support code for ptx device. */
 llvm::Module *get_initial_module_for_ptx_device(Target, llvm::LLVMContext *c);
 
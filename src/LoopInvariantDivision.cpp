@@ -0,0 +1,289 @@
+#include "LoopInvariantDivision.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IREquality.h"
+#include "ExprUsesVar.h"
+#include "CodeGen_GPU_Dev.h"
+#include "Scope.h"
+#include "Util.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+bool is_device_loop(const For *op) {
+    return (CodeGen_GPU_Dev::is_gpu_var(op->name) ||
+            (op->device_api != DeviceAPI::Host &&
+             op->device_api != DeviceAPI::Parent));
+}
+
+// Is it safe and cheap to evaluate a divisor outside of the loop it
+// was found in?
+class IsHoistable : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void visit(const Load *) {
+        result = false;
+    }
+
+    void visit(const Call *) {
+        result = false;
+    }
+
+public:
+    bool result;
+    IsHoistable() : result(true) {}
+};
+
+bool is_hoistable(Expr e) {
+    IsHoistable h;
+    e.accept(&h);
+    return h.result;
+}
+
+// The names of the lets holding the precomputed constants for one
+// divisor.
+struct InvariantDivisor {
+    Expr value;
+    string multiplier, shift1, shift2, sign;
+};
+
+// Replace vector divisions and mods by a broadcast scalar that
+// doesn't depend on anything defined inside some loop with multiplies
+// and shifts. This is the method of figure 4.1 of Granlund and
+// Montgomery, "Division by Invariant Integers using Multiplication",
+// with a flip of the numerator's bits to get signed division that
+// rounds towards negative infinity.
+class ReplaceInvariantDivisions : public IRMutator {
+    using IRMutator::visit;
+
+    Scope<int> inner;
+
+    const InvariantDivisor *find_divisor(Expr d) {
+        for (const InvariantDivisor &div : divisors) {
+            if (equal(div.value, d)) {
+                return &div;
+            }
+        }
+        InvariantDivisor div;
+        div.value = d;
+        div.multiplier = unique_name('m');
+        div.shift1 = unique_name('s');
+        div.shift2 = unique_name('s');
+        if (d.type().is_int()) {
+            div.sign = unique_name('b');
+        }
+        divisors.push_back(div);
+        return &divisors.back();
+    }
+
+    // Returns the quotient, or an undefined Expr if this division
+    // can't be replaced.
+    Expr invariant_divide(Type t, Expr b, const string &numerator) {
+        if (!t.is_vector() ||
+            !(t.is_int() || t.is_uint()) ||
+            !(t.bits == 8 || t.bits == 16 || t.bits == 32)) {
+            return Expr();
+        }
+
+        const Broadcast *broadcast = b.as<Broadcast>();
+        if (!broadcast ||
+            is_const(broadcast->value) ||
+            expr_uses_vars(broadcast->value, inner) ||
+            !is_hoistable(broadcast->value)) {
+            return Expr();
+        }
+
+        const InvariantDivisor *div = find_divisor(broadcast->value);
+
+        int bits = t.bits, width = t.width;
+        Type ut = UInt(bits, width);
+        Type wide = UInt(bits * 2, width);
+        Expr n = Variable::make(t, numerator);
+
+        Expr multiplier = Broadcast::make(Variable::make(UInt(bits), div->multiplier), width);
+        Expr shift1 = Broadcast::make(Variable::make(UInt(bits), div->shift1), width);
+        Expr shift2 = Broadcast::make(Variable::make(UInt(bits), div->shift2), width);
+
+        // For signed numerators, flip the bits of negative values so
+        // that we're dividing a non-negative number. This makes the
+        // unsigned division round towards negative infinity.
+        Expr xsign, un;
+        if (t.is_int()) {
+            xsign = n >> make_const(t, bits - 1);
+            un = cast(ut, xsign ^ n);
+        } else {
+            un = n;
+        }
+
+        // Multiply-keep-high-half
+        Expr hi = cast(wide, un) * cast(wide, multiplier);
+        if (bits < 32) {
+            hi = hi / make_const(wide, 1 << bits);
+        } else {
+            hi = hi >> make_const(wide, bits);
+        }
+        hi = cast(ut, hi);
+
+        // Add half the difference between the numerator and the high
+        // half, then do the final shift.
+        Expr q = (hi + ((un - hi) >> shift1)) >> shift2;
+
+        if (t.is_int()) {
+            // Maybe flip the bits again, then negate the result if
+            // the divisor was negative.
+            q = xsign ^ cast(t, q);
+            Expr bsign = Broadcast::make(Variable::make(t.element_of(), div->sign), width);
+            q = (q ^ bsign) - bsign;
+        }
+
+        return q;
+    }
+
+    template<typename T>
+    void visit_div(const T *op, bool is_mod) {
+        string numerator = unique_name('n');
+        Expr q = invariant_divide(op->type, op->b, numerator);
+        if (!q.defined()) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        Expr n = Variable::make(op->type, numerator);
+        if (is_mod) {
+            q = n - q * op->b;
+        }
+        expr = Let::make(numerator, mutate(op->a), q);
+    }
+
+    void visit(const Div *op) {
+        visit_div(op, false);
+    }
+
+    void visit(const Mod *op) {
+        visit_div(op, true);
+    }
+
+    void visit(const Let *op) {
+        Expr value = mutate(op->value);
+        inner.push(op->name, 0);
+        Expr body = mutate(op->body);
+        inner.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            expr = op;
+        } else {
+            expr = Let::make(op->name, value, body);
+        }
+    }
+
+    void visit(const LetStmt *op) {
+        Expr value = mutate(op->value);
+        inner.push(op->name, 0);
+        Stmt body = mutate(op->body);
+        inner.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = LetStmt::make(op->name, value, body);
+        }
+    }
+
+    void visit(const For *op) {
+        if (is_device_loop(op)) {
+            stmt = op;
+            return;
+        }
+        inner.push(op->name, 0);
+        IRMutator::visit(op);
+        inner.pop(op->name);
+    }
+
+public:
+    ReplaceInvariantDivisions(const string &loop_var) {
+        inner.push(loop_var, 0);
+    }
+
+    vector<InvariantDivisor> divisors;
+};
+
+// Wrap a statement in lets that compute the multiplier and shifts for
+// a divisor.
+Stmt compute_divisor_constants(const InvariantDivisor &div, Stmt s) {
+    Expr d = div.value;
+    Type t = d.type();
+    int bits = t.bits;
+    Type ut = UInt(bits);
+
+    // The magnitude of the divisor.
+    Expr ud;
+    if (t.is_int()) {
+        ud = select(d < make_zero(t), make_zero(ut) - cast(ut, d), cast(ut, d));
+    } else {
+        ud = d;
+    }
+    // Division by zero is undefined, but these are computed even if
+    // the loop doesn't run, so they must not fault.
+    ud = max(ud, make_one(ut));
+
+    // l = ceil(log2(ud))
+    Expr l = make_const(ut, bits) - count_leading_zeros(ud - make_one(ut));
+
+    // multiplier = floor(2^bits * (2^l - ud) / ud) + 1
+    Type u64 = UInt(64);
+    Expr ud_wide = cast(u64, ud);
+    Expr multiplier = (make_one(u64) << cast(u64, l)) - ud_wide;
+    multiplier = (multiplier << make_const(u64, bits)) / ud_wide + make_one(u64);
+    multiplier = cast(ut, multiplier);
+
+    Expr shift1 = min(l, make_one(ut));
+    Expr shift2 = max(l, make_one(ut)) - make_one(ut);
+
+    if (t.is_int()) {
+        s = LetStmt::make(div.sign, d >> make_const(t, bits - 1), s);
+    }
+    s = LetStmt::make(div.shift2, shift2, s);
+    s = LetStmt::make(div.shift1, shift1, s);
+    s = LetStmt::make(div.multiplier, multiplier, s);
+    return s;
+}
+
+class HoistLoopInvariantDivisions : public IRMutator {
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        if (is_device_loop(op)) {
+            stmt = op;
+            return;
+        }
+
+        // Replace the divisions that are invariant in this loop, then
+        // recursively look for ones that are only invariant in some
+        // inner loop.
+        ReplaceInvariantDivisions replacer(op->name);
+        Stmt body = replacer.mutate(op->body);
+        body = mutate(body);
+
+        if (body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        }
+
+        for (size_t i = replacer.divisors.size(); i > 0; i--) {
+            stmt = compute_divisor_constants(replacer.divisors[i-1], stmt);
+        }
+    }
+};
+
+}
+
+Stmt hoist_loop_invariant_divisions(Stmt s) {
+    return HoistLoopInvariantDivisions().mutate(s);
+}
+
+}
+}
@@ -0,0 +1,24 @@
+#ifndef HALIDE_LOOP_INVARIANT_DIVISION_H
+#define HALIDE_LOOP_INVARIANT_DIVISION_H
+
+/** \file
+ * Defines a lowering pass that speeds up vector division by
+ * loop-invariant divisors that aren't known at compile time.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Rewrite vector integer divisions and mods by a scalar that doesn't
+ * vary within some loop as multiplies and shifts. The multiplier and
+ * shifts are computed once, outside the outermost such loop. Applies
+ * to 8, 16, and 32-bit signed and unsigned types. Must be done after
+ * vectorization. */
+Stmt hoist_loop_invariant_divisions(Stmt s);
+
+}
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "Bounds.h"
 #include "BoundsInference.h"
 #include "CSE.h"
+#include "CompileStats.h"
 #include "Debug.h"
 #include "DebugToFile.h"
 #include "Deinterleave.h"
@@ -25,7 +26,9 @@
 #include "IRMutator.h"
 #include "IROperator.h"
 #include "IRPrinter.h"
+#include "LoopInvariantDivision.h"
 #include "Memoization.h"
+#include "NontemporalStores.h"
 #include "PartitionLoops.h"
 #include "Profiling.h"
 #include "Qualify.h"
@@ -60,6 +63,7 @@ using std::pair;
 using std::make_pair;
 
 Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const Target &t, const vector<IRMutator *> &custom_passes) {
+    CompilePhaseTimer timer("lowering");
 
     // Compute an environment
     map<string, Function> env;
@@ -137,7 +141,7 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     debug(2) << "Lowering after uniquifying variable names:\n" << s << "\n\n";
 
     debug(1) << "Performing storage folding optimization...\n";
-    s = storage_folding(s);
+    s = storage_folding(s, env);
     debug(2) << "Lowering after storage folding:\n" << s << '\n';
 
     debug(1) << "Injecting debug_to_file calls...\n";
@@ -223,6 +227,15 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
     s = simplify(s);
     debug(2) << "Lowering after partitioning loops:\n" << s << "\n\n";
 
+    debug(1) << "Hoisting loop-invariant divisions...\n";
+    s = hoist_loop_invariant_divisions(s);
+    s = simplify(s);
+    debug(2) << "Lowering after hoisting loop-invariant divisions:\n" << s << "\n\n";
+
+    debug(1) << "Marking non-temporal stores...\n";
+    s = mark_nontemporal_stores(s, env);
+    debug(2) << "Lowering after marking non-temporal stores:\n" << s << "\n\n";
+
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
     debug(2) << "Lowering after injecting early frees:\n" << s << "\n\n";
@@ -252,6 +265,10 @@ Stmt lower(const vector<Function> &outputs, const string &pipeline_name, const T
         }
     }
 
+    if (compile_stats_enabled()) {
+        add_compile_stat("ir_nodes", count_ir_nodes(s));
+    }
+
     return s;
 }
 
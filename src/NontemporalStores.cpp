@@ -0,0 +1,110 @@
+#include "NontemporalStores.h"
+#include "IRMutator.h"
+#include "CodeGen_GPU_Dev.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+
+namespace {
+
+Stmt store_fence() {
+    return Evaluate::make(Call::make(Int(32), Call::store_fence, std::vector<Expr>(), Call::Intrinsic));
+}
+
+class MarkNontemporalStores : public IRMutator {
+    using IRMutator::visit;
+
+    const set<string> &funcs;
+    set<string> buffers;
+
+    void visit(const Store *op) {
+        if (op->value.type().is_vector() && buffers.count(op->name)) {
+            Expr value = Call::make(op->value.type(), Call::nontemporal, {op->value}, Call::Intrinsic);
+            stmt = Store::make(op->name, value, op->index);
+        } else {
+            stmt = op;
+        }
+    }
+
+    void visit(const ProducerConsumer *op) {
+        IRMutator::visit(op);
+        if (funcs.count(op->name) && !stmt.same_as(op)) {
+            // Nontemporal stores are weakly ordered, so fence them
+            // before anything consumes the Func.
+            const ProducerConsumer *pc = stmt.as<ProducerConsumer>();
+            Stmt produce = pc->produce, update = pc->update;
+            if (update.defined()) {
+                update = Block::make(update, store_fence());
+            } else {
+                produce = Block::make(produce, store_fence());
+            }
+            stmt = ProducerConsumer::make(op->name, produce, update, pc->consume);
+        }
+    }
+
+    void visit(const For *op) {
+        if (CodeGen_GPU_Dev::is_gpu_var(op->name) ||
+            (op->device_api != DeviceAPI::Host &&
+             op->device_api != DeviceAPI::Parent)) {
+            // Only the host backends know what to do with the
+            // intrinsics.
+            stmt = op;
+            return;
+        }
+
+        Stmt body = mutate(op->body);
+        if (body.same_as(op->body)) {
+            stmt = op;
+            return;
+        }
+        if (op->for_type == ForType::Parallel) {
+            // The iterations run on different threads, so each one
+            // fences its own stores.
+            body = Block::make(body, store_fence());
+        }
+        stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+
+public:
+    using IRMutator::mutate;
+
+    // Expressions can't contain stores.
+    Expr mutate(Expr e) {
+        return e;
+    }
+
+    MarkNontemporalStores(const set<string> &f, const map<string, Function> &env) : funcs(f) {
+        for (const string &name : funcs) {
+            const Function &func = env.find(name)->second;
+            if (func.outputs() == 1) {
+                buffers.insert(name);
+            } else {
+                for (int i = 0; i < func.outputs(); i++) {
+                    buffers.insert(name + "." + std::to_string(i));
+                }
+            }
+        }
+    }
+};
+
+}
+
+Stmt mark_nontemporal_stores(Stmt s, const map<string, Function> &env) {
+    set<string> funcs;
+    for (const std::pair<string, Function> &i : env) {
+        if (i.second.schedule().store_nontemporal()) {
+            funcs.insert(i.first);
+        }
+    }
+    if (funcs.empty()) {
+        return s;
+    }
+    return MarkNontemporalStores(funcs, env).mutate(s);
+}
+
+}
+}
@@ -0,0 +1,26 @@
+#ifndef HALIDE_NONTEMPORAL_STORES_H
+#define HALIDE_NONTEMPORAL_STORES_H
+
+/** \file
+ * Defines a lowering pass that marks the stores to Funcs scheduled
+ * with Func::store_nontemporal.
+ */
+
+#include <map>
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Wrap the values of vector stores to the buffers of Funcs scheduled
+ * with store_nontemporal in the nontemporal intrinsic, and add a
+ * store_fence after each parallel loop body that does such stores and
+ * after the production of each such Func. Must be done after
+ * vectorization. */
+Stmt mark_nontemporal_stores(Stmt s, const std::map<std::string, Function> &env);
+
+}
+}
+
+#endif
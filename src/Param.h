@@ -119,6 +119,11 @@ public:
         return type_of<T>();
     }
 
+    /** Get at the internal parameter object representing this Param. */
+    Internal::Parameter parameter() const {
+        return param;
+    }
+
     /** Get or set the possible range of this parameter. Use undefined
      * Exprs to mean unbounded. */
     // @{
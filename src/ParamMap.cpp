@@ -0,0 +1,53 @@
+#include "ParamMap.h"
+
+namespace Halide {
+
+using namespace Internal;
+
+ParamMap::ParamMap() {
+}
+
+ParamMap::ParamMapping &ParamMap::mapping_for(const Parameter &p) {
+    user_assert(p.defined()) << "Can't add an undefined parameter to a ParamMap\n";
+    for (ParamMapping &m : mappings) {
+        if (m.parameter.same_as(p)) {
+            return m;
+        }
+    }
+    ParamMapping m;
+    m.parameter = p;
+    m.scalar = 0;
+    mappings.push_back(m);
+    return mappings.back();
+}
+
+void ParamMap::set(const ImageParam &p, Buffer b) {
+    if (b.defined()) {
+        user_assert(b.type() == p.type())
+            << "Can't bind ImageParam " << p.name()
+            << " of type " << p.type()
+            << " to Buffer " << b.name()
+            << " of type " << b.type() << "\n";
+    }
+    mapping_for(p.parameter()).buffer = b;
+}
+
+const void *ParamMap::get_scalar_address(const Parameter &p) const {
+    for (const ParamMapping &m : mappings) {
+        if (m.parameter.same_as(p)) {
+            return &m.scalar;
+        }
+    }
+    return NULL;
+}
+
+Buffer ParamMap::get_buffer(const Parameter &p) const {
+    for (const ParamMapping &m : mappings) {
+        if (m.parameter.same_as(p)) {
+            return m.buffer;
+        }
+    }
+    return Buffer();
+}
+
+}
@@ -0,0 +1,66 @@
+#ifndef HALIDE_PARAM_MAP_H
+#define HALIDE_PARAM_MAP_H
+
+/** \file
+ * Defines a collection of parameters to be passed as formal arguments
+ * to a JIT invocation.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "Buffer.h"
+#include "Param.h"
+
+namespace Halide {
+
+/** A set of values for Params and ImageParams to use for one call to
+ * Pipeline::realize, instead of the values bound to the parameters
+ * themselves. Params and ImageParams not in the map use their bound
+ * values. Because a ParamMap is only read while the pipeline runs,
+ * several threads may realize the same Pipeline at once, each with
+ * its own ParamMap. */
+class ParamMap {
+    struct ParamMapping {
+        Internal::Parameter parameter;
+        Buffer buffer;
+        uint64_t scalar;
+    };
+    std::vector<ParamMapping> mappings;
+
+    EXPORT ParamMapping &mapping_for(const Internal::Parameter &p);
+
+public:
+    EXPORT ParamMap();
+
+    /** Set the value of a Param for calls that use this map. */
+    template<typename T>
+    void set(const Param<T> &p, T val) {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "Param type too large for a ParamMap");
+        ParamMapping &m = mapping_for(p.parameter());
+        m.scalar = 0;
+        memcpy(&m.scalar, &val, sizeof(T));
+    }
+
+    /** Bind a buffer or image to an ImageParam for calls that use
+     * this map. */
+    EXPORT void set(const ImageParam &p, Buffer b);
+
+    /** Get the address of the value given to a scalar parameter by
+     * this map, or NULL if it doesn't have one. */
+    EXPORT const void *get_scalar_address(const Internal::Parameter &p) const;
+
+    /** Get the buffer given to a buffer parameter by this map, or an
+     * undefined Buffer if it doesn't have one. */
+    EXPORT Buffer get_buffer(const Internal::Parameter &p) const;
+
+    /** Does this map have no values in it? */
+    bool empty() const {
+        return mappings.empty();
+    }
+};
+
+}
+
+#endif
@@ -477,11 +477,33 @@ private:
         size_t orig_num_min_vals = min_vals.size();
         size_t orig_num_max_vals = max_vals.size();
 
-        Expr condition = mutate(op->condition);
+        // A condition wrapped in a likely intrinsic (e.g. the guard
+        // on the tail of a split loop) means the condition is usually
+        // true, so the true branch is the steady state. The
+        // vectorizer may have bound the condition to a variable
+        // first.
+        Expr orig_condition = op->condition;
+        bool condition_likely = false;
+        if (const Call *c = orig_condition.as<Call>()) {
+            if (c->call_type == Call::Intrinsic && c->name == Call::likely) {
+                orig_condition = c->args[0];
+                condition_likely = true;
+            }
+        } else if (const Variable *v = orig_condition.as<Variable>()) {
+            if (bound_vars.contains(v->name)) {
+                const Call *c = bound_vars.get(v->name).as<Call>();
+                if (c && c->call_type == Call::Intrinsic && c->name == Call::likely) {
+                    orig_condition = c->args[0];
+                    condition_likely = true;
+                }
+            }
+        }
+
+        Expr condition = mutate(orig_condition);
         bool old_likely = likely;
         likely = false;
         StmtOrExpr true_value = mutate(orig_true_value);
-        bool a_likely = likely;
+        bool a_likely = likely || condition_likely;
         likely = false;
         StmtOrExpr false_value = mutate(orig_false_value);
         bool b_likely = likely;
@@ -535,7 +557,7 @@ private:
             } else {
                 return SelectOrIf::make(new_condition, true_value, false_value);
             }
-        } else if (condition.same_as(op->condition) &&
+        } else if (condition.same_as(orig_condition) &&
                    true_value.same_as(orig_true_value) &&
                    false_value.same_as(orig_false_value)) {
             return op;
@@ -1,7 +1,10 @@
 #include <algorithm>
+#include <list>
+#include <mutex>
 
 #include "Pipeline.h"
 #include "Argument.h"
+#include "CompileStats.h"
 #include "Func.h"
 #include "IRVisitor.h"
 #include "LLVM_Headers.h"
@@ -49,11 +52,26 @@ struct PipelineContents {
     JITModule jit_module;
     Target jit_target;
 
+    // Code jit-compiled for each target realized recently, including
+    // the one above, most recently used first.
+    struct CachedJITModule {
+        Target target;
+        JITModule module;
+    };
+    std::list<CachedJITModule> jit_cache;
+    size_t jit_cache_capacity;
+    JITCacheStats jit_cache_stats;
+
+    // Held while jit-compiling, so that threads realizing the
+    // pipeline at once compile it only once.
+    std::mutex jit_mutex;
+
     /** Clear all cached state */
     void invalidate_cache() {
         module = Module("", Target());
         jit_module = JITModule();
         jit_target = Target();
+        jit_cache.clear();
         inferred_args.clear();
     }
 
@@ -81,7 +99,7 @@ struct PipelineContents {
     std::map<std::string, JITExtern> jit_externs;
 
     PipelineContents() :
-        module("", Target()) {
+        module("", Target()), jit_cache_capacity(4) {
         user_context_arg.arg = Argument("__user_context", Argument::InputScalar, Handle(), 0);
         user_context_arg.param = Parameter(Handle(), false, 0, "__user_context",
                                            /*is_explicit_name*/ true, /*register_instance*/ false);
@@ -178,6 +196,7 @@ void Pipeline::compile_to(const Outputs &output_files,
     }
 
     delete llvm_module;
+    write_compile_stats(fn_name);
 }
 
 
@@ -186,6 +205,7 @@ void Pipeline::compile_to_bitcode(const string &filename,
                                   const string &fn_name,
                                   const Target &target) {
     compile_module_to_llvm_bitcode(compile_to_module(args, fn_name, target), filename);
+    write_compile_stats(fn_name);
 }
 
 void Pipeline::compile_to_object(const string &filename,
@@ -193,6 +213,7 @@ void Pipeline::compile_to_object(const string &filename,
                                  const string &fn_name,
                                  const Target &target) {
     compile_module_to_object(compile_to_module(args, fn_name, target), filename);
+    write_compile_stats(fn_name);
 }
 
 void Pipeline::compile_to_header(const string &filename,
@@ -200,6 +221,7 @@ void Pipeline::compile_to_header(const string &filename,
                                  const string &fn_name,
                                  const Target &target) {
     compile_module_to_c_header(compile_to_module(args, fn_name, target), filename);
+    write_compile_stats(fn_name);
 }
 
 void Pipeline::compile_to_assembly(const string &filename,
@@ -207,6 +229,7 @@ void Pipeline::compile_to_assembly(const string &filename,
                                    const string &fn_name,
                                    const Target &target) {
     compile_module_to_assembly(compile_to_module(args, fn_name, target), filename);
+    write_compile_stats(fn_name);
 }
 
 
@@ -215,6 +238,7 @@ void Pipeline::compile_to_c(const string &filename,
                             const string &fn_name,
                             const Target &target) {
     compile_module_to_c_source(compile_to_module(args, fn_name, target), filename);
+    write_compile_stats(fn_name);
 }
 
 void Pipeline::print_loop_nest() {
@@ -247,6 +271,7 @@ void Pipeline::compile_to_file(const string &filename_prefix,
     } else {
         compile_module_to_object(m, filename_prefix + ".o");
     }
+    write_compile_stats(filename_prefix);
 }
 
 namespace Internal {
@@ -578,7 +603,11 @@ std::string Pipeline::generate_function_name() {
     return name;
 }
 
-void *Pipeline::compile_jit(const Target &target_arg) {
+void *Pipeline::compile_jit(const Target &target) {
+    return compile_jit_module(target).main_function();
+}
+
+JITModule Pipeline::compile_jit_module(const Target &target_arg) {
     user_assert(defined()) << "Pipeline is undefined\n";
 
     Target target(target_arg);
@@ -587,13 +616,31 @@ void *Pipeline::compile_jit(const Target &target_arg) {
 
     debug(2) << "jit-compiling for: " << target_arg.to_string() << "\n";
 
+    std::lock_guard<std::mutex> lock(contents.ptr->jit_mutex);
+
     // If we're re-jitting for the same target, we can just keep the
     // old jit module.
     if (contents.ptr->jit_target == target &&
         contents.ptr->jit_module.compiled()) {
         debug(2) << "Reusing old jit module compiled for :\n" << contents.ptr->jit_target.to_string() << "\n";
-        return contents.ptr->jit_module.main_function();
+        contents.ptr->jit_cache_stats.hits++;
+        return contents.ptr->jit_module;
+    }
+
+    // If we've compiled for this target recently, switch back to that
+    // module.
+    std::list<PipelineContents::CachedJITModule> &cache = contents.ptr->jit_cache;
+    for (auto it = cache.begin(); it != cache.end(); it++) {
+        if (it->target == target) {
+            debug(2) << "Reusing cached jit module compiled for :\n" << target.to_string() << "\n";
+            cache.splice(cache.begin(), cache, it);
+            contents.ptr->jit_target = target;
+            contents.ptr->jit_module = cache.front().module;
+            contents.ptr->jit_cache_stats.hits++;
+            return contents.ptr->jit_module;
+        }
     }
+    contents.ptr->jit_cache_stats.misses++;
 
     contents.ptr->jit_target = target;
 
@@ -619,6 +666,8 @@ void *Pipeline::compile_jit(const Target &target_arg) {
     JITModule jit_module(module, module.functions.back(),
                          make_externs_jit_module(target_arg, lowered_externs));
 
+    write_compile_stats(name);
+
     if (debug::debug_level >= 3) {
         compile_module_to_native(module, name + ".bc", name + ".s");
         compile_module_to_text(module, name + ".stmt");
@@ -626,10 +675,37 @@ void *Pipeline::compile_jit(const Target &target_arg) {
 
     contents.ptr->jit_module = jit_module;
 
-    return jit_module.main_function();
+    PipelineContents::CachedJITModule entry = {target, jit_module};
+    cache.push_front(entry);
+    while (cache.size() > contents.ptr->jit_cache_capacity) {
+        cache.pop_back();
+        contents.ptr->jit_cache_stats.evictions++;
+    }
+
+    return jit_module;
 }
 
 
+void Pipeline::set_jit_cache_capacity(int capacity) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    user_assert(capacity > 0) << "The jit cache must hold at least one module\n";
+    std::lock_guard<std::mutex> lock(contents.ptr->jit_mutex);
+    contents.ptr->jit_cache_capacity = capacity;
+    std::list<PipelineContents::CachedJITModule> &cache = contents.ptr->jit_cache;
+    while (cache.size() > contents.ptr->jit_cache_capacity) {
+        cache.pop_back();
+        contents.ptr->jit_cache_stats.evictions++;
+    }
+}
+
+JITCacheStats Pipeline::jit_cache_stats() {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    std::lock_guard<std::mutex> lock(contents.ptr->jit_mutex);
+    JITCacheStats stats = contents.ptr->jit_cache_stats;
+    stats.entries = (int)contents.ptr->jit_cache.size();
+    return stats;
+}
+
 void Pipeline::set_error_handler(void (*handler)(void *, const char *)) {
     user_assert(defined()) << "Pipeline is undefined\n";
     contents.ptr->jit_handlers.custom_error = handler;
@@ -788,10 +864,12 @@ struct ErrorBuffer {
 struct JITFuncCallContext {
     ErrorBuffer error_buffer;
     JITUserContext jit_context;
-    Parameter &user_context_param;
+    // The value of the __user_context argument. Each call has its
+    // own, so that calls on different threads don't share state.
+    void *user_context_arg;
 
-    JITFuncCallContext(const JITHandlers &handlers, Parameter &user_context_param)
-        : user_context_param(user_context_param) {
+    JITFuncCallContext(const JITHandlers &handlers)
+        : user_context_arg(&jit_context) {
         void *user_context = NULL;
         JITHandlers local_handlers = handlers;
         if (local_handlers.custom_error == NULL) {
@@ -799,7 +877,6 @@ struct JITFuncCallContext {
             user_context = &error_buffer;
         }
         JITSharedRuntime::init_jit_user_context(jit_context, user_context, local_handlers);
-        user_context_param.set_scalar(&jit_context);
 
         debug(2) << "custom_print: " << (void *)jit_context.handlers.custom_print << '\n'
                  << "custom_malloc: " << (void *)jit_context.handlers.custom_malloc << '\n'
@@ -823,21 +900,23 @@ struct JITFuncCallContext {
 
     void finalize(int exit_status) {
         report_if_error(exit_status);
-        user_context_param.set_scalar((void *)NULL); // Don't leave param hanging with pointer to stack.
     }
 };
 }
 
-// Make a vector of void *'s to pass to the jit call using the
-// currently bound value for all of the params and image
-// params. Unbound image params produce null values.
-vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const Target &target) {
+// Make a vector of void *'s to pass to the jit call using the value
+// in the param map, or else the currently bound value, for all of the
+// params and image params. Unbound image params produce null values.
+vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const Target &target,
+                                                          const ParamMap &param_map,
+                                                          void *const *user_context,
+                                                          JITModule *compiled_module) {
     user_assert(defined()) << "Can't realize an undefined Pipeline\n";
 
-    compile_jit(target);
-
-    JITModule &compiled_module = contents.ptr->jit_module;
-    internal_assert(compiled_module.argv_function());
+    // Use our own copy of the module from here on. Another thread may
+    // replace the pipeline's current one at any time.
+    *compiled_module = compile_jit_module(target);
+    internal_assert(compiled_module->argv_function());
 
     struct OutputBufferType {
         Function func;
@@ -883,10 +962,16 @@ vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const
     vector<const void *> arg_values;
 
     // First the inputs
-    for (InferredArgument arg : input_args) {
-        if (arg.param.defined() && arg.param.is_buffer()) {
+    for (const InferredArgument &arg : input_args) {
+        if (arg.param.same_as(contents.ptr->user_context_arg.param)) {
+            arg_values.push_back(user_context);
+            debug(1) << "JIT input user context argument ";
+        } else if (arg.param.defined() && arg.param.is_buffer()) {
             // ImageParam arg
-            Buffer buf = arg.param.get_buffer();
+            Buffer buf = param_map.get_buffer(arg.param);
+            if (!buf.defined()) {
+                buf = arg.param.get_buffer();
+            }
             if (buf.defined()) {
                 arg_values.push_back(buf.raw_buffer());
             } else {
@@ -895,7 +980,8 @@ vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const
             }
             debug(1) << "JIT input ImageParam argument ";
         } else if (arg.param.defined()) {
-            arg_values.push_back(arg.param.get_scalar_address());
+            const void *addr = param_map.get_scalar_address(arg.param);
+            arg_values.push_back(addr ? addr : arg.param.get_scalar_address());
             debug(1) << "JIT input scalar argument ";
         } else {
             debug(1) << "JIT input Image argument ";
@@ -934,11 +1020,11 @@ Pipeline::make_externs_jit_module(const Target &target,
             PipelineContents &pipeline_contents(*jit_extern.pipeline.contents.ptr);
 
             // Ensure that the pipeline is compiled.
-            jit_extern.pipeline.compile_jit(target);
+            JITModule compiled_module = jit_extern.pipeline.compile_jit_module(target);
 
-            free_standing_jit_externs.add_dependency(pipeline_contents.jit_module);
-            free_standing_jit_externs.add_symbol_for_export(iter->first, pipeline_contents.jit_module.entrypoint_symbol());
-            iter->second.c_function = pipeline_contents.jit_module.entrypoint_symbol().address;
+            free_standing_jit_externs.add_dependency(compiled_module);
+            free_standing_jit_externs.add_symbol_for_export(iter->first, compiled_module.entrypoint_symbol());
+            iter->second.c_function = compiled_module.entrypoint_symbol().address;
             iter->second.signature.is_void_return = false;
             iter->second.signature.ret_type = Int(32);
             // Add the arguments to the compiled pipeline
@@ -968,6 +1054,87 @@ Pipeline::make_externs_jit_module(const Target &target,
 }
 
 void Pipeline::realize(Realization dst, const Target &t) {
+    realize(dst, ParamMap(), t);
+}
+
+Callable Pipeline::compile_to_callable(const Target &t) {
+    user_assert(defined()) << "Can't compile an undefined Pipeline\n";
+
+    Target target = t;
+    if (target.os == Target::OSUnknown) {
+        target = get_jit_target_from_environment();
+    }
+    Callable c;
+    c.module = compile_jit_module(target);
+    c.argv_function = c.module.argv_function();
+    internal_assert(c.argv_function);
+    c.handlers = contents.ptr->jit_handlers;
+
+    // The inputs, in the same order as infer_arguments returns them.
+    for (const InferredArgument &arg : contents.ptr->inferred_args) {
+        size_t index = c.arg_template.size();
+        if (arg.param.same_as(contents.ptr->user_context_arg.param)) {
+            c.user_context_index = index;
+            c.arg_template.push_back(NULL);
+        } else if (arg.buffer.defined()) {
+            c.constants.push_back(arg.buffer);
+            c.arg_template.push_back(arg.buffer.raw_buffer());
+        } else {
+            Callable::Slot s = {index, arg.arg.type, arg.arg.is_buffer(), arg.arg.name};
+            c.slots.push_back(s);
+            c.arg_template.push_back(NULL);
+        }
+    }
+
+    // Then the outputs
+    for (Function f : contents.ptr->outputs) {
+        for (Type t : f.output_types()) {
+            Callable::Slot s = {c.arg_template.size(), t, true, "the output " + f.name()};
+            c.slots.push_back(s);
+            c.arg_template.push_back(NULL);
+        }
+    }
+
+    return c;
+}
+
+Callable::Callable() : argv_function(NULL), user_context_index(0) {
+}
+
+void Callable::report_wrong_argument_count(size_t count) const {
+    std::ostringstream expected;
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (i > 0) expected << ", ";
+        expected << slots[i].name;
+    }
+    user_error << "Callable takes " << slots.size() << " arguments ("
+               << expected.str() << "), but was called with " << count << "\n";
+}
+
+void Callable::call_argv(const void **args) const {
+    JITFuncCallContext jit_context(handlers);
+    args[user_context_index] = &jit_context.user_context_arg;
+    int exit_status = argv_function(args);
+    jit_context.finalize(exit_status);
+}
+
+void Pipeline::realize(Buffer b, const ParamMap &param_map, const Target &target) {
+    realize(Realization({b}), param_map, target);
+}
+
+Realization Pipeline::realize(vector<int32_t> sizes, const ParamMap &param_map,
+                              const Target &target) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    vector<Buffer> bufs;
+    for (Type t : contents.ptr->outputs[0].output_types()) {
+        bufs.push_back(Buffer(t, sizes));
+    }
+    Realization r(bufs);
+    realize(r, param_map, target);
+    return r;
+}
+
+void Pipeline::realize(Realization dst, const ParamMap &param_map, const Target &t) {
     Target target = t;
     user_assert(defined()) << "Can't realize an undefined Pipeline\n";
 
@@ -975,6 +1142,7 @@ void Pipeline::realize(Realization dst, const Target &t) {
 
     // If target is unspecified...
     if (target.os == Target::OSUnknown) {
+        std::lock_guard<std::mutex> lock(contents.ptr->jit_mutex);
         // If we've already jit-compiled for a specific target, use that.
         if (contents.ptr->jit_module.compiled()) {
             target = contents.ptr->jit_target;
@@ -984,7 +1152,12 @@ void Pipeline::realize(Realization dst, const Target &t) {
         }
     }
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+    // The user context argument is filled in once the jit_context
+    // exists, which has to be after compiling (see below).
+    void *user_context = NULL;
+    JITModule compiled_module;
+    vector<const void *> args = prepare_jit_call_arguments(dst, target, param_map, &user_context,
+                                                           &compiled_module);
 
     for (size_t i = 0; i < contents.ptr->inferred_args.size(); i++) {
         const InferredArgument &arg = contents.ptr->inferred_args[i];
@@ -1016,9 +1189,14 @@ void Pipeline::realize(Realization dst, const Target &t) {
     // Those global handlers use the user_context passed in to call
     // the right handler for this particular pipeline run. The
     // user_context is just a pointer to a JITUserContext, which is a
-    // member of the JITFuncCallContext which we will declare now:
+    // member of the JITFuncCallContext which we will declare now. It
+    // copies the handlers of the shared module, so it must be made
+    // after the pipeline has been compiled, which is when the shared
+    // module is created. Nothing in the jit_context is shared with
+    // other calls, so several threads can be in here at once.
 
-    JITFuncCallContext jit_context(jit_handlers(), contents.ptr->user_context_arg.param);
+    JITFuncCallContext jit_context(jit_handlers());
+    user_context = jit_context.user_context_arg;
 
     // The handlers in the jit_context default to the default handlers
     // in the runtime of the shared module (e.g. halide_print_impl,
@@ -1058,17 +1236,17 @@ void Pipeline::realize(Realization dst, const Target &t) {
     // exception.
 
     debug(2) << "Calling jitted function\n";
-    int exit_status = contents.ptr->jit_module.argv_function()(&(args[0]));
+    int exit_status = compiled_module.argv_function()(&(args[0]));
     debug(2) << "Back from jitted function. Exit status was " << exit_status << "\n";
 
     // If we're profiling, report runtimes and reset profiler stats.
     if (target.has_feature(Target::Profile)) {
         JITModule::Symbol report_sym =
-            contents.ptr->jit_module.find_symbol_by_name("halide_profiler_report");
+            compiled_module.find_symbol_by_name("halide_profiler_report");
         JITModule::Symbol reset_sym =
-            contents.ptr->jit_module.find_symbol_by_name("halide_profiler_reset");
+            compiled_module.find_symbol_by_name("halide_profiler_reset");
         if (report_sym.address && reset_sym.address) {
-            void *uc = jit_context.user_context_param.get_scalar<void *>();
+            void *uc = jit_context.user_context_arg;
             void (*report_fn_ptr)(void *) = (void (*)(void *))(report_sym.address);
             report_fn_ptr(uc);
 
@@ -1084,7 +1262,15 @@ void Pipeline::infer_input_bounds(Realization dst) {
 
     Target target = get_jit_target_from_environment();
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+    void *user_context = NULL;
+    JITModule compiled_module;
+    vector<const void *> args = prepare_jit_call_arguments(dst, target, ParamMap(), &user_context,
+                                                           &compiled_module);
+
+    // Make the context after compiling, so that it gets the handlers
+    // of the shared runtime.
+    JITFuncCallContext jit_context(jit_handlers());
+    user_context = jit_context.user_context_arg;
 
     struct TrackedBuffer {
         // The query buffer.
@@ -1109,8 +1295,6 @@ void Pipeline::infer_input_bounds(Realization dst) {
         return;
     }
 
-    JITFuncCallContext jit_context(jit_handlers(), contents.ptr->user_context_arg.param);
-
     int iter = 0;
     const int max_iters = 16;
     for (iter = 0; iter < max_iters; iter++) {
@@ -1120,7 +1304,7 @@ void Pipeline::infer_input_bounds(Realization dst) {
         }
 
         Internal::debug(2) << "Calling jitted function\n";
-        int exit_status = contents.ptr->jit_module.argv_function()(&(args[0]));
+        int exit_status = compiled_module.argv_function()(&(args[0]));
         jit_context.report_if_error(exit_status);
         Internal::debug(2) << "Back from jitted function\n";
         bool changed = false;
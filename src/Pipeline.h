@@ -14,6 +14,7 @@
 #include "Image.h"
 #include "JITModule.h"
 #include "Module.h"
+#include "ParamMap.h"
 #include "Tuple.h"
 #include "Target.h"
 
@@ -91,6 +92,142 @@ struct Outputs {
 };
 
 struct JITExtern;
+class Pipeline;
+
+/** Counts of how a Pipeline's cache of jit-compiled code has been
+ * used. See Pipeline::jit_cache_stats. */
+struct JITCacheStats {
+    /** The number of times compiled code was reused. */
+    int hits;
+    /** The number of times the pipeline had to be compiled. */
+    int misses;
+    /** The number of compiled modules dropped from the cache. */
+    int evictions;
+    /** The number of compiled modules in the cache now. */
+    int entries;
+
+    JITCacheStats() : hits(0), misses(0), evictions(0), entries(0) {}
+};
+
+/** A Pipeline jit-compiled for one target, with the layout of its
+ * arguments worked out ahead of time, so that calling it costs little
+ * more than calling the compiled code directly. Get one with
+ * Pipeline::compile_to_callable. The arguments are the pipeline's
+ * inferred arguments, in the order given by
+ * Pipeline::infer_arguments, followed by one output Buffer or Image
+ * per output of the pipeline. Only the number of arguments and their
+ * types are checked on each call. Scalars must be passed as exactly
+ * the type of their Param. Buffer contents aren't copied to or from
+ * a device. Unlike Pipeline::realize, the values bound to the Params
+ * and ImageParams are ignored. Calls on different threads may run at
+ * once.
+ \code
+ Callable c = p.compile_to_callable();
+ c(input_image, 0.5f, output_image);
+ \endcode
+ */
+class Callable {
+    friend class Pipeline;
+
+    Internal::JITModule module;
+    Internal::JITModule::argv_wrapper argv_function;
+    Internal::JITHandlers handlers;
+
+    // Holds constant images alive
+    std::vector<Buffer> constants;
+
+    // The argument vector for a call, with the constants filled in.
+    std::vector<const void *> arg_template;
+
+    // For each argument of operator(), where it goes in the argument
+    // vector, its type, and whether it is a buffer.
+    struct Slot {
+        size_t index;
+        Type type;
+        bool is_buffer;
+        std::string name;
+    };
+    std::vector<Slot> slots;
+
+    // Where the user context goes in the argument vector.
+    size_t user_context_index;
+
+    EXPORT void call_argv(const void **args) const;
+
+    EXPORT void report_wrong_argument_count(size_t count) const;
+
+    const void *marshal(size_t i, const Buffer &b) const {
+        const Slot &s = slots[i];
+        user_assert(s.is_buffer && b.type() == s.type)
+            << "Argument " << i << " to Callable should be " << s.name
+            << ", but is a Buffer of type " << b.type() << "\n";
+        return b.raw_buffer();
+    }
+
+    template<typename T>
+    const void *marshal(size_t i, const Image<T> &im) const {
+        const Slot &s = slots[i];
+        user_assert(s.is_buffer && type_of<T>() == s.type)
+            << "Argument " << i << " to Callable should be " << s.name
+            << ", but is an Image of type " << type_of<T>() << "\n";
+        return im.raw_buffer();
+    }
+
+    const void *marshal(size_t i, buffer_t *b) const {
+        user_assert(slots[i].is_buffer)
+            << "Argument " << i << " to Callable should be " << slots[i].name
+            << ", but is a buffer_t *\n";
+        return b;
+    }
+
+    template<typename T>
+    const void *marshal(size_t i, const T &val) const {
+        const Slot &s = slots[i];
+        user_assert(!s.is_buffer && type_of<T>() == s.type)
+            << "Argument " << i << " to Callable should be " << s.name
+            << " of type " << s.type << ", but is a scalar of type " << type_of<T>() << "\n";
+        return &val;
+    }
+
+    void fill_args(const void **, size_t) const {}
+
+    template<typename T, typename ...Rest>
+    void fill_args(const void **args, size_t i, const T &first, const Rest &...rest) const {
+        args[slots[i].index] = marshal(i, first);
+        fill_args(args, i + 1, rest...);
+    }
+
+public:
+    /** Make an undefined Callable. */
+    EXPORT Callable();
+
+    /** Check if this Callable has been compiled from a Pipeline. */
+    bool defined() const {
+        return argv_function != NULL;
+    }
+
+    /** Run the pipeline on the given inputs and outputs. */
+    template<typename ...Args>
+    NO_INLINE void operator()(const Args &...args) const {
+        user_assert(defined()) << "Can't call an undefined Callable\n";
+        if (sizeof...(args) != slots.size()) {
+            report_wrong_argument_count(sizeof...(args));
+        }
+        // Avoid a heap allocation per call for most pipelines.
+        const void *stack_args[16];
+        std::vector<const void *> heap_args;
+        const void **args_ptr = stack_args;
+        if (arg_template.size() > 16) {
+            heap_args.resize(arg_template.size());
+            args_ptr = &heap_args[0];
+        }
+        for (size_t i = 0; i < arg_template.size(); i++) {
+            args_ptr[i] = arg_template[i];
+        }
+        fill_args(args_ptr, 0, args...);
+        call_argv(args_ptr);
+    }
+};
 
 /** A class representing a Halide pipeline. Constructed from the Func
  * or Funcs that it outputs. */
@@ -98,7 +235,16 @@ class Pipeline {
     Internal::IntrusivePtr<PipelineContents> contents;
 
     std::vector<Buffer> validate_arguments(const std::vector<Argument> &args);
-    std::vector<const void *> prepare_jit_call_arguments(Realization dst, const Target &target);
+    std::vector<const void *> prepare_jit_call_arguments(Realization dst, const Target &target,
+                                                         const ParamMap &param_map,
+                                                         void *const *user_context,
+                                                         Internal::JITModule *compiled_module);
+
+    /** Jit-compile the pipeline for a target, or reuse the module
+     * compiled for it before, and return that module. The copy is
+     * taken under the jit lock, so callers can use it even if another
+     * thread recompiles the pipeline or invalidates its cache. */
+    Internal::JITModule compile_jit_module(const Target &target);
 
     static std::vector<Internal::JITModule> make_externs_jit_module(const Target &target,
                                                                     std::map<std::string, JITExtern> &externs_in_out);
@@ -212,6 +358,26 @@ public:
      */
      EXPORT void *compile_jit(const Target &target = get_jit_target_from_environment());
 
+    /** JIT-compile the pipeline, if it hasn't been already, and
+     * return a Callable that runs it with the least possible
+     * overhead per call. See Callable. The Callable keeps working if
+     * the pipeline is later rescheduled or recompiled, but it uses
+     * the custom handlers set at the time it was made. */
+    EXPORT Callable compile_to_callable(const Target &target = get_jit_target_from_environment());
+
+    /** The pipeline keeps the code jit-compiled for the most recently
+     * used targets, so that switching back and forth between
+     * targets, e.g. with and without Target::Profile, doesn't
+     * recompile each time. This sets how many targets it
+     * remembers. The least recently used ones are dropped first. The
+     * default is four. Rescheduling the pipeline empties the
+     * cache. */
+    EXPORT void set_jit_cache_capacity(int capacity);
+
+    /** Get the counts of hits, misses and evictions in the cache of
+     * jit-compiled code, and how many modules it holds. */
+    EXPORT JITCacheStats jit_cache_stats();
+
     /** Set the error handler function that be called in the case of
      * runtime errors during halide pipelines. If you are compiling
      * statically, you can also just define your own function with
@@ -381,6 +547,29 @@ public:
     }
     // @}
 
+    /** Evaluate this function using the values in param_map for the
+     * Params and ImageParams it contains, instead of their bound
+     * values. Any number of threads may call these at once on the
+     * same Pipeline, each with its own ParamMap and output buffers,
+     * as long as they use the same target and nothing reschedules
+     * the pipeline in the meantime. The pipeline is only compiled
+     * once. */
+    // @{
+    EXPORT Realization realize(std::vector<int32_t> sizes, const ParamMap &param_map,
+                               const Target &target = Target());
+    EXPORT void realize(Realization dst, const ParamMap &param_map,
+                        const Target &target = Target());
+    EXPORT void realize(Buffer dst, const ParamMap &param_map,
+                        const Target &target = Target());
+
+    template<typename T>
+    NO_INLINE void realize(Image<T> dst, const ParamMap &param_map,
+                           const Target &target = Target()) {
+        realize(Buffer(dst), param_map, target);
+        dst.copy_to_host();
+    }
+    // @}
+
     /** For a given size of output, or a given set of output buffers,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
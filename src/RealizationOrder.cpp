@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <set>
 
 #include "RealizationOrder.h"
@@ -11,6 +12,7 @@ using std::map;
 using std::set;
 using std::vector;
 using std::pair;
+using std::make_pair;
 
 void realization_order_dfs(string current,
                            const map<string, set<string>> &graph,
@@ -50,6 +52,29 @@ vector<string> realization_order(const vector<Function> &outputs,
         }
     }
 
+    // A function computed with another shares its loop nest, so the
+    // two must be realized one immediately after the other. Make the
+    // parent depend on the inputs of the child, and the child depend
+    // on the parent. Once the parent is realized, nothing stands
+    // between it and the child.
+    vector<pair<string, string>> fused;
+    for (const pair<string, Function> &child : env) {
+        const LoopLevel &level = child.second.schedule().compute_with_level();
+        if (level.is_inline()) continue;
+        const string &parent = level.func;
+        user_assert(env.count(parent))
+            << "Func " << child.first << " is computed with " << parent
+            << ", which is not used in the same pipeline.\n";
+        user_assert(!find_transitive_calls(child.second).count(parent) &&
+                    !find_transitive_calls(env.find(parent)->second).count(child.first))
+            << "Can't compute " << child.first << " with " << parent
+            << ", because one of them uses the other.\n";
+        set<string> &inputs = graph[parent];
+        inputs.insert(graph[child.first].begin(), graph[child.first].end());
+        graph[child.first].insert(parent);
+        fused.push_back(make_pair(parent, child.first));
+    }
+
     vector<string> order;
     set<string> result_set;
     set<string> visited;
@@ -60,6 +85,17 @@ vector<string> realization_order(const vector<Function> &outputs,
         }
     }
 
+    // Anything between a parent and its child in the order doesn't
+    // depend on the child, so we can move the child up.
+    for (const pair<string, string> &p : fused) {
+        vector<string>::iterator child = std::find(order.begin(), order.end(), p.second);
+        internal_assert(child != order.end());
+        order.erase(child);
+        vector<string>::iterator parent = std::find(order.begin(), order.end(), p.first);
+        internal_assert(parent != order.end());
+        order.insert(parent + 1, p.second);
+    }
+
     return order;
 }
 
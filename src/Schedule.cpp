@@ -11,18 +11,19 @@ namespace Internal {
 struct ScheduleContents {
     mutable RefCount ref_count;
 
-    LoopLevel store_level, compute_level;
+    LoopLevel store_level, compute_level, compute_with_level;
     std::vector<Split> splits;
     std::vector<Dim> dims;
-    std::vector<std::string> storage_dims;
+    std::vector<StorageDim> storage_dims;
     std::vector<Bound> bounds;
     std::vector<Specialization> specializations;
     ReductionDomain reduction_domain;
     bool memoized;
+    bool store_nontemporal;
     bool touched;
     bool allow_race_conditions;
 
-    ScheduleContents() : memoized(false), touched(false), allow_race_conditions(false) {};
+    ScheduleContents() : memoized(false), store_nontemporal(false), touched(false), allow_race_conditions(false) {};
 };
 
 
@@ -46,6 +47,14 @@ bool Schedule::memoized() const {
     return contents.ptr->memoized;
 }
 
+bool &Schedule::store_nontemporal() {
+    return contents.ptr->store_nontemporal;
+}
+
+bool Schedule::store_nontemporal() const {
+    return contents.ptr->store_nontemporal;
+}
+
 bool &Schedule::touched() {
     return contents.ptr->touched;
 }
@@ -70,11 +79,11 @@ const std::vector<Dim> &Schedule::dims() const {
     return contents.ptr->dims;
 }
 
-std::vector<std::string> &Schedule::storage_dims() {
+std::vector<StorageDim> &Schedule::storage_dims() {
     return contents.ptr->storage_dims;
 }
 
-const std::vector<std::string> &Schedule::storage_dims() const {
+const std::vector<StorageDim> &Schedule::storage_dims() const {
     return contents.ptr->storage_dims;
 }
 
@@ -118,6 +127,14 @@ const LoopLevel &Schedule::compute_level() const {
     return contents.ptr->compute_level;
 }
 
+LoopLevel &Schedule::compute_with_level() {
+    return contents.ptr->compute_with_level;
+}
+
+const LoopLevel &Schedule::compute_with_level() const {
+    return contents.ptr->compute_with_level;
+}
+
 
 const ReductionDomain &Schedule::reduction_domain() const {
     return contents.ptr->reduction_domain;
@@ -149,6 +166,11 @@ void Schedule::accept(IRVisitor *visitor) const {
             b.extent.accept(visitor);
         }
     }
+    for (const StorageDim &s : storage_dims()) {
+        if (s.fold_factor.defined()) {
+            s.fold_factor.accept(visitor);
+        }
+    }
     for (const Specialization &s : specializations()) {
         s.condition.accept(visitor);
     }
@@ -8,6 +8,47 @@
 #include "Expr.h"
 
 namespace Halide {
+
+/** Different ways to handle a tail case in a split when the
+ * factor does not provably divide the extent. */
+enum class TailStrategy {
+    /** Round up the extent to be a multiple of the split
+     * factor. Not legal for RVars, as it would change the meaning of
+     * the algorithm. Bounds inference takes the rounding into
+     * account when computing the region required of the inputs to
+     * the stage. Pros: generates the simplest, fastest code, with no
+     * tail case. Cons: if used on a stage that reads from the input
+     * or writes to the output, constrains the input or output size to
+     * be a multiple of the split factor. */
+    RoundUp,
+
+    /** Guard the inner loop with an if statement that prevents
+     * evaluation beyond the original extent. Always legal, including
+     * for RVars. The if statement is treated like a boundary
+     * condition, and factored out into a loop epilogue if
+     * possible. If the inner loop is vectorized, the guard becomes a
+     * predicate on the loads and stores of the vector tail, so the
+     * tail stays vectorized. Pros: no redundant re-evaluation, and
+     * works for extents smaller than the split factor. Cons:
+     * increases code size due to separate tail-case handling, and
+     * masked loads and stores may be slow on some targets. */
+    GuardWithIf,
+
+    /** Prevent evaluation beyond the original extent by shifting the
+     * tail case inwards, re-evaluating some points near the
+     * end. Only legal for pure variables in pure definitions. If the
+     * extent is smaller than the split factor, the shifted loop
+     * starts before the beginning of the region. Pros: no tail case,
+     * so the code stays small. Cons: redundant re-evaluation, and
+     * constrains the extent to be at least the split factor. */
+    ShiftInwards,
+
+    /** For pure definitions use ShiftInwards. For pure vars in
+     * update definitions use RoundUp. Splits of RVars must divide
+     * the extent. */
+    Auto
+};
+
 namespace Internal {
 
 /** A reference to a site in a Halide statement at the top of the
@@ -65,6 +106,10 @@ struct Split {
     Expr factor;
     bool exact; // Is it required that the factor divides the extent of the old var. True for splits of RVars.
 
+    // How to handle the case where the factor does not provably
+    // divide the extent of the old var.
+    TailStrategy tail;
+
     enum SplitType {SplitVar = 0, RenameVar, FuseVars};
 
     // If split_type is Rename, then this is just a renaming of the
@@ -94,6 +139,15 @@ struct Bound {
     Expr min, extent;
 };
 
+/** Properties of one dimension of the storage of a Func. */
+struct StorageDim {
+    std::string var;
+
+    /** If defined, the storage of this dimension is folded modulo
+     * this factor. See \ref Func::fold_storage */
+    Expr fold_factor;
+};
+
 struct ScheduleContents;
 
 struct Specialization {
@@ -120,6 +174,13 @@ public:
     bool memoized() const;
     // @}
 
+    /** This flag is set to true if vector stores to the function's
+     * buffer should bypass the cache. */
+    // @{
+    bool &store_nontemporal();
+    bool store_nontemporal() const;
+    // @}
+
     /** This flag is set to true if the dims list has been manipulated
      * by the user (or if a ScheduleHandle was created that could have
      * been used to manipulate it). It controls the warning that
@@ -160,8 +221,8 @@ public:
      * innermost dimension for storage (i.e. which dimension is
      * tightly packed in memory) */
     // @{
-    const std::vector<std::string> &storage_dims() const;
-    std::vector<std::string> &storage_dims();
+    const std::vector<StorageDim> &storage_dims() const;
+    std::vector<StorageDim> &storage_dims();
     // @}
 
     /** You may explicitly bound some of the dimensions of a
@@ -192,6 +253,16 @@ public:
     LoopLevel &compute_level();
     // @}
 
+    /** The loop level of another function that this function is
+     * computed with. If not inline, the loop nest of this function
+     * is fused with the loop nest of that function, from the
+     * outermost loop down to and including the given loop. See \ref
+     * Func::compute_with */
+    // @{
+    const LoopLevel &compute_with_level() const;
+    LoopLevel &compute_with_level();
+    // @}
+
     /** Are race conditions permitted? */
     // @{
     bool allow_race_conditions() const;
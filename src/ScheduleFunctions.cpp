@@ -8,6 +8,9 @@
 #include "IRMutator.h"
 #include "Target.h"
 #include "Inline.h"
+#include "IREquality.h"
+
+#include <set>
 
 namespace Halide {
 namespace Internal {
@@ -19,12 +22,14 @@ using std::pair;
 using std::make_pair;
 
 namespace {
-// A structure representing a containing LetStmt or For loop. Used in
-// build_provide_loop_nest below.
+// A structure representing a containing LetStmt, For loop, or
+// IfThenElse. Used in build_provide_loop_nest below.
 struct Container {
-    int dim_idx; // index in the dims list. -1 for let statements.
-    string name;
-    Expr value;
+    enum Type {For, Let, If};
+    Type type;
+    int dim_idx; // index in the dims list. Only meaningful for loops.
+    string name; // Empty for if statements.
+    Expr value; // The let value or the if condition.
 };
 }
 
@@ -100,6 +105,16 @@ Stmt build_provide_loop_nest(Function f,
 
                     first.exact |= second.exact;
                     second.exact = first.exact;
+                    // The new inner split has the old inner factor,
+                    // so it takes the old inner tail strategy. The
+                    // outer split covers both tails, so a guard
+                    // requested on either takes precedence.
+                    TailStrategy inner_tail = first.tail;
+                    if (first.tail == TailStrategy::Auto ||
+                        second.tail == TailStrategy::GuardWithIf) {
+                        first.tail = second.tail;
+                    }
+                    second.tail = inner_tail;
                     second.old_var = unique_name('s');
                     first.outer   = second.outer;
                     second.outer  = second.inner;
@@ -119,12 +134,16 @@ Stmt build_provide_loop_nest(Function f,
 
     // Define the function args in terms of the loop variables using the splits
     map<string, pair<string, Expr>> base_values;
+    // Conditions guarding the provide, from splits that use
+    // TailStrategy::GuardWithIf.
+    vector<Expr> predicates;
     for (const Split &split : splits) {
         Expr outer = Variable::make(Int(32), prefix + split.outer);
         if (split.is_split()) {
             Expr inner = Variable::make(Int(32), prefix + split.inner);
             Expr old_max = Variable::make(Int(32), prefix + split.old_var + ".loop_max");
             Expr old_min = Variable::make(Int(32), prefix + split.old_var + ".loop_min");
+            Expr old_extent = Variable::make(Int(32), prefix + split.old_var + ".loop_extent");
 
             known_size_dims[split.inner] = split.factor;
 
@@ -137,6 +156,19 @@ Stmt build_provide_loop_nest(Function f,
                 // We have proved that the split factor divides the
                 // old extent. No need to adjust the base.
                 known_size_dims[split.outer] = iter->second / split.factor;
+            } else if (split.tail == TailStrategy::GuardWithIf) {
+                // Don't adjust the base. Instead, skip the points
+                // beyond the end of the old var with an if
+                // statement. The guard is phrased in terms of a
+                // single variable, so that bounds inference can use
+                // it to tighten the bounds of the region computed.
+                string rebased_name = prefix + split.old_var + ".rebased";
+                Expr rebased = Variable::make(Int(32), rebased_name);
+                stmt = substitute(prefix + split.old_var, rebased + old_min, stmt);
+                stmt = LetStmt::make(prefix + split.old_var, rebased + old_min, stmt);
+                stmt = LetStmt::make(rebased_name, outer * split.factor + inner, stmt);
+                predicates.push_back(likely(rebased < old_extent));
+                continue;
             } else if (split.exact) {
                 // It's an exact split but we failed to prove that the
                 // extent divides the factor. This is a problem.
@@ -146,12 +178,22 @@ Stmt build_provide_loop_nest(Function f,
                            << "divides the extent of " << split.old_var
                            << " (" << iter->second << "). This is required when "
                            << "the split originates from an RVar.\n";
-            } else if (!is_update) {
+            } else if (split.tail == TailStrategy::RoundUp ||
+                       (split.tail == TailStrategy::Auto && is_update)) {
+                // Don't adjust the base. We compute up to the next
+                // multiple of the split factor, and bounds inference
+                // expands the region computed to match.
+            } else {
+                user_assert(!is_update)
+                    << "Can't split " << split.old_var << " in an update definition of "
+                    << f.name() << " using TailStrategy::ShiftInwards, because"
+                    << " recomputing points of an update definition would change"
+                    << " the meaning of the algorithm. Use TailStrategy::RoundUp"
+                    << " or TailStrategy::GuardWithIf instead.\n";
+
                 // Adjust the base downwards to not compute off the
                 // end of the realization.
-
                 base = Min::make(likely(base), old_max + (1 - split.factor));
-
             }
 
             string base_name = prefix + split.inner + ".base";
@@ -204,22 +246,29 @@ Stmt build_provide_loop_nest(Function f,
     // Put the desired loop nest into the containers vector.
     for (int i = (int)s.dims().size() - 1; i >= 0; i--) {
         const Dim &dim = s.dims()[i];
-        Container c = {i, prefix + dim.var, Expr()};
+        Container c = {Container::For, i, prefix + dim.var, Expr()};
         nest.push_back(c);
     }
 
     // Strip off the lets into the containers vector.
     while (const LetStmt *let = stmt.as<LetStmt>()) {
-        Container c = {-1, let->name, let->value};
+        Container c = {Container::Let, 0, let->name, let->value};
         nest.push_back(c);
         stmt = let->body;
     }
 
-    // Resort the containers vector so that lets are as far outwards
-    // as possible. Use reverse insertion sort. Start at the first letstmt.
+    // Add the guards from the splits innermost.
+    for (Expr pred : predicates) {
+        Container c = {Container::If, 0, "", pred};
+        nest.push_back(c);
+    }
+
+    // Resort the containers vector so that lets and ifs are as far
+    // outwards as possible. Use reverse insertion sort. Start at the
+    // first letstmt.
     for (int i = (int)s.dims().size(); i < (int)nest.size(); i++) {
-        // Only push up LetStmts.
-        internal_assert(nest[i].value.defined());
+        // Only push up LetStmts and IfThenElses.
+        internal_assert(nest[i].type != Container::For);
 
         for (int j = i-1; j >= 0; j--) {
             // Try to push it up by one.
@@ -232,10 +281,12 @@ Stmt build_provide_loop_nest(Function f,
         }
     }
 
-    // Rewrap the statement in the containing lets and fors.
+    // Rewrap the statement in the containing lets, ifs, and fors.
     for (int i = (int)nest.size() - 1; i >= 0; i--) {
-        if (nest[i].value.defined()) {
+        if (nest[i].type == Container::Let) {
             stmt = LetStmt::make(nest[i].name, nest[i].value, stmt);
+        } else if (nest[i].type == Container::If) {
+            stmt = IfThenElse::make(nest[i].value, stmt, Stmt());
         } else {
             const Dim &dim = s.dims()[nest[i].dim_idx];
             Expr min = Variable::make(Int(32), nest[i].name + ".loop_min");
@@ -742,6 +793,10 @@ private:
 class ComputeLegalSchedules : public IRVisitor {
 public:
     struct Site {
+        // Storage outside of this loop can't be shared by its
+        // iterations. This is true of vectorized loops, and parallel
+        // loops on a device. The sliding window pass gives each
+        // iteration of a parallel loop on the host its own storage.
         bool is_parallel;
         LoopLevel loop_level;
     };
@@ -764,8 +819,10 @@ private:
         internal_assert(first_dot != string::npos && last_dot != string::npos);
         string func = f->name.substr(0, first_dot);
         string var = f->name.substr(last_dot + 1);
-        Site s = {f->for_type == ForType::Parallel ||
-                  f->for_type == ForType::Vectorized,
+        bool on_host = (f->device_api == DeviceAPI::Host ||
+                        f->device_api == DeviceAPI::Parent);
+        Site s = {f->for_type == ForType::Vectorized ||
+                  (f->for_type == ForType::Parallel && !on_host),
                   LoopLevel(func, var)};
         sites.push_back(s);
         f->body.accept(this);
@@ -924,6 +981,108 @@ public:
     PrintUsesOfFunc(string f, std::ostream &s) : func(f), stream(s) {}
 };
 
+namespace {
+class CallsFunction : public IRVisitor {
+    const string &func;
+
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        IRVisitor::visit(op);
+        if (op->call_type == Call::Halide && op->name == func) {
+            result = true;
+        }
+    }
+
+public:
+    bool result;
+    CallsFunction(const string &f) : func(f), result(false) {}
+};
+
+bool calls_function(Expr e, const string &func) {
+    CallsFunction c(func);
+    e.accept(&c);
+    return c.result;
+}
+
+// Find the variables of the update's original schedule that the
+// given (possibly split, fused, or renamed) var was derived from.
+std::set<string> source_vars(const UpdateDefinition &r, const string &var) {
+    std::set<string> vars;
+    vars.insert(var);
+    const vector<Split> &splits = r.schedule.splits();
+    for (size_t i = splits.size(); i > 0; i--) {
+        const Split &split = splits[i-1];
+        if (split.is_fuse()) {
+            if (vars.count(split.old_var)) {
+                vars.insert(split.outer);
+                vars.insert(split.inner);
+            }
+        } else if (vars.count(split.outer) ||
+                   (split.is_split() && vars.count(split.inner))) {
+            vars.insert(split.old_var);
+        }
+    }
+    return vars;
+}
+
+// Check if an update definition is of the form f(args) = f(args) op
+// e, where op is associative and commutative, args don't depend on
+// the reduction domain, and e depends on the reduction variable the
+// given var was derived from. Such an update can be vectorized across
+// var by combining the vector lanes of e. If e doesn't depend on
+// var, the vectorized loop would only apply e once.
+bool is_associative_update(Function f, const UpdateDefinition &r, const string &var) {
+    if (r.values.size() != 1 || !r.domain.defined()) {
+        return false;
+    }
+
+    for (Expr arg : r.args) {
+        for (const ReductionVariable &rv : r.domain.domain()) {
+            if (expr_uses_var(arg, rv.var)) {
+                return false;
+            }
+        }
+    }
+
+    Expr a, b;
+    Expr value = r.values[0];
+    if (const Add *op = value.as<Add>()) {
+        a = op->a; b = op->b;
+    } else if (const Mul *op = value.as<Mul>()) {
+        a = op->a; b = op->b;
+    } else if (const Min *op = value.as<Min>()) {
+        a = op->a; b = op->b;
+    } else if (const Max *op = value.as<Max>()) {
+        a = op->a; b = op->b;
+    } else {
+        return false;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        const Call *self = a.as<Call>();
+        if (self && self->call_type == Call::Halide && self->name == f.name() &&
+            self->args.size() == r.args.size() && !calls_function(b, f.name())) {
+            bool same_site = true;
+            for (size_t j = 0; j < r.args.size(); j++) {
+                same_site = same_site && equal(self->args[j], r.args[j]);
+            }
+            if (!same_site) return false;
+            std::set<string> vars = source_vars(r, var);
+            for (const ReductionVariable &rv : r.domain.domain()) {
+                if (vars.count(rv.var) && expr_uses_var(b, rv.var)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        std::swap(a, b);
+    }
+
+    return false;
+}
+}
+
 void validate_schedule(Function f, Stmt s, bool is_output) {
 
     // If f is extern, check that none of its inputs are scheduled inline.
@@ -960,6 +1119,30 @@ void validate_schedule(Function f, Stmt s, bool is_output) {
         }
     }
 
+    // Vectorizing across a reduction variable is a race condition,
+    // unless the update is associative and all lanes update the same
+    // site, in which case the lanes are combined with a horizontal
+    // reduction.
+    for (size_t i = 0; i < f.updates().size(); i++) {
+        const UpdateDefinition &r = f.updates()[i];
+        if (r.schedule.allow_race_conditions()) continue;
+        for (const Dim &d : r.schedule.dims()) {
+            if (!d.pure && d.for_type == ForType::Vectorized &&
+                !is_associative_update(f, r, d.var)) {
+                user_error << "In schedule for " << f.name() << ".update(" << i << ")"
+                           << ", marking var " << d.var
+                           << " as vectorized may introduce a race"
+                           << " condition resulting in incorrect output."
+                           << " Reduction variables can only be vectorized in"
+                           << " updates of the form f(args) = f(args) op e,"
+                           << " where op is +, *, min, or max, args don't depend"
+                           << " on the reduction domain, and e depends on the"
+                           << " vectorized variable. It is possible to override"
+                           << " this error using the allow_race_conditions() method.\n";
+            }
+        }
+    }
+
     LoopLevel store_at = f.schedule().store_level();
     LoopLevel compute_at = f.schedule().compute_level();
 
@@ -997,7 +1180,10 @@ void validate_schedule(Function f, Stmt s, bool is_output) {
         }
     }
 
-    // Check there isn't a parallel loop between the compute_at and the store_at
+    // Check there isn't a parallel loop between the compute_at and
+    // the store_at. Parallel loops on the host are ok. Sliding window
+    // gives each iteration, or each strip of iterations, its own
+    // storage.
     std::ostringstream err;
 
     if (store_at_ok && compute_at_ok) {
@@ -1092,6 +1278,156 @@ public:
     }
 };
 
+// Check that a function computed with another is scheduled such that
+// their loop nests can be fused.
+void validate_compute_with(Function child, const map<string, Function> &env) {
+    const LoopLevel &level = child.schedule().compute_with_level();
+    Function parent = env.find(level.func)->second;
+
+    std::ostringstream prefix;
+    prefix << "Can't compute " << child.name() << " with " << parent.name() << ", because ";
+
+    user_assert(!child.has_update_definition() && !parent.has_update_definition())
+        << prefix.str() << "functions with update definitions can't be computed with another function.\n";
+    user_assert(!child.has_extern_definition() && !parent.has_extern_definition())
+        << prefix.str() << "extern functions can't be computed with another function.\n";
+    user_assert(child.schedule().specializations().empty() &&
+                parent.schedule().specializations().empty())
+        << prefix.str() << "specialized functions can't be computed with another function.\n";
+    user_assert(parent.schedule().compute_with_level().is_inline())
+        << prefix.str() << parent.name() << " is itself computed with "
+        << parent.schedule().compute_with_level().func << ".\n";
+    user_assert(!child.schedule().compute_level().is_inline() &&
+                child.schedule().compute_level() == parent.schedule().compute_level() &&
+                child.schedule().store_level() == parent.schedule().store_level())
+        << prefix.str() << "the two functions are not computed and stored at the same loop level.\n";
+
+    for (const pair<string, Function> &other : env) {
+        if (other.first == child.name()) continue;
+        user_assert(other.second.schedule().compute_with_level().func != parent.name())
+            << prefix.str() << other.first << " is also computed with " << parent.name() << ".\n";
+    }
+}
+
+// Fuse the loop nest of a function with the loop nest of the function
+// it is computed with. The realization order puts the production of
+// the parent immediately outside the production of the child, so we
+// move the parent's loops into the child's production, and leave the
+// parent's production empty.
+class FuseComputeWith : public IRMutator {
+    const Function &parent, &child;
+    LoopLevel level;
+
+    using IRMutator::visit;
+
+    // Fuse two loop nests from the outermost loop down to the fused
+    // level. The fused loops cover the union of the bounds of the
+    // original loops, and the guards accumulate the conditions under
+    // which each body should run.
+    Stmt fuse_loops(Stmt p, Stmt c, Expr p_guard, Expr c_guard) {
+        vector<pair<string, Expr>> lets;
+        while (const LetStmt *l = p.as<LetStmt>()) {
+            lets.push_back(make_pair(l->name, l->value));
+            p = l->body;
+        }
+        while (const LetStmt *l = c.as<LetStmt>()) {
+            lets.push_back(make_pair(l->name, l->value));
+            c = l->body;
+        }
+
+        const For *pf = p.as<For>(), *cf = c.as<For>();
+        user_assert(pf && cf)
+            << "Can't compute " << child.name() << " with " << parent.name()
+            << " at " << level.var << ", because " << parent.name() << " has no loop over "
+            << level.var << ", or the two functions have a different number of loops"
+            << " outside of it.\n";
+        user_assert(pf->for_type == cf->for_type &&
+                    pf->device_api == cf->device_api &&
+                    pf->for_type != ForType::Vectorized &&
+                    pf->for_type != ForType::Unrolled)
+            << "Can't compute " << child.name() << " with " << parent.name()
+            << ", because the loops " << pf->name << " and " << cf->name
+            << " are of different types, or are vectorized or unrolled.\n";
+
+        // The loops over __outermost have extent one, and are
+        // removed later, so they need no guards.
+        bool outermost = ends_with(pf->name, "." + Var::outermost().name());
+        Expr min = pf->min, extent = pf->extent;
+        if (!outermost) {
+            Expr loop_var = Variable::make(Int(32), pf->name);
+            Expr p_in = loop_var >= pf->min && loop_var < pf->min + pf->extent;
+            Expr c_in = loop_var >= cf->min && loop_var < cf->min + cf->extent;
+            p_guard = p_guard.defined() ? (p_guard && p_in) : p_in;
+            c_guard = c_guard.defined() ? (c_guard && c_in) : c_in;
+            min = Min::make(pf->min, cf->min);
+            extent = Max::make(pf->min + pf->extent, cf->min + cf->extent) - min;
+        }
+
+        Stmt body;
+        if (level.match(pf->name)) {
+            Stmt p_body = pf->body, c_body = cf->body;
+            if (p_guard.defined()) {
+                p_body = IfThenElse::make(p_guard, p_body);
+                c_body = IfThenElse::make(c_guard, c_body);
+            }
+            body = Block::make(p_body, c_body);
+        } else {
+            body = fuse_loops(pf->body, cf->body, p_guard, c_guard);
+        }
+
+        if (!outermost) {
+            body = LetStmt::make(cf->name, Variable::make(Int(32), pf->name), body);
+        }
+
+        Stmt result = For::make(pf->name, min, extent, pf->for_type, pf->device_api, body);
+        for (size_t i = lets.size(); i > 0; i--) {
+            result = LetStmt::make(lets[i-1].first, lets[i-1].second, result);
+        }
+        return result;
+    }
+
+    // Walk from the consume side of the parent to the production of
+    // the child, and fuse the parent's production into it. Only lets,
+    // realizations, and bounds assertions can come in between.
+    Stmt fuse_into_child(Stmt s, Stmt produce) {
+        if (const LetStmt *l = s.as<LetStmt>()) {
+            Stmt body = fuse_into_child(l->body, produce);
+            return body.defined() ? LetStmt::make(l->name, l->value, body) : Stmt();
+        } else if (const Realize *r = s.as<Realize>()) {
+            Stmt body = fuse_into_child(r->body, produce);
+            return body.defined() ? Realize::make(r->name, r->types, r->bounds, r->condition, body) : Stmt();
+        } else if (const Block *b = s.as<Block>()) {
+            if (!b->first.as<AssertStmt>() || !b->rest.defined()) return Stmt();
+            Stmt rest = fuse_into_child(b->rest, produce);
+            return rest.defined() ? Block::make(b->first, rest) : Stmt();
+        } else if (const ProducerConsumer *pc = s.as<ProducerConsumer>()) {
+            if (pc->name != child.name()) return Stmt();
+            Stmt fused = fuse_loops(produce, pc->produce, Expr(), Expr());
+            return ProducerConsumer::make(pc->name, fused, pc->update, pc->consume);
+        } else {
+            return Stmt();
+        }
+    }
+
+    void visit(const ProducerConsumer *op) {
+        if (op->name == parent.name()) {
+            internal_assert(!op->update.defined());
+            Stmt consume = fuse_into_child(op->consume, op->produce);
+            if (consume.defined()) {
+                stmt = ProducerConsumer::make(op->name, Evaluate::make(0), Stmt(), consume);
+                return;
+            }
+            // The child isn't realized here, so there's nothing to
+            // fuse with.
+        }
+        IRMutator::visit(op);
+    }
+
+public:
+    FuseComputeWith(const Function &p, const Function &c) :
+        parent(p), child(c), level(c.schedule().compute_with_level()) {}
+};
+
 Stmt schedule_functions(const vector<Function> &outputs,
                         const vector<string> &order,
                         const map<string, Function> &env,
@@ -1113,6 +1449,10 @@ Stmt schedule_functions(const vector<Function> &outputs,
 
         validate_schedule(f, s, is_output);
 
+        if (!f.schedule().compute_with_level().is_inline()) {
+            validate_compute_with(f, env);
+        }
+
         if (f.has_pure_definition() &&
             !f.has_update_definition() &&
             f.schedule().compute_level().is_inline()) {
@@ -1123,6 +1463,16 @@ Stmt schedule_functions(const vector<Function> &outputs,
             InjectRealization injector(f, is_output, inject_asserts);
             s = injector.mutate(s);
             internal_assert(injector.found_store_level && injector.found_compute_level);
+
+            // If another function is computed with this one, we just
+            // injected its realization immediately around that
+            // function's, so now we can fuse their loop nests.
+            for (const pair<string, Function> &child : env) {
+                if (child.second.schedule().compute_with_level().func == f.name()) {
+                    debug(1) << "Fusing " << child.first << " with " << f.name() << '\n';
+                    s = FuseComputeWith(f, child.second).mutate(s);
+                }
+            }
         }
         any_memoized = any_memoized || f.schedule().memoized();
         debug(2) << s << '\n';
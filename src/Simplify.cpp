@@ -9,6 +9,7 @@
 #include "IREquality.h"
 #include "IRPrinter.h"
 #include "IRMutator.h"
+#include "IRRewrite.h"
 #include "Scope.h"
 #include "Var.h"
 #include "Debug.h"
@@ -63,6 +64,241 @@ bool no_overflow(Type T) {
     return T.is_float() || (T.is_int() && T.bits == 32);
 }
 
+// The simplifications of logical operators and selects that are pure
+// pattern matching are written as rewrite rules. Each list is in the
+// order the rules should be tried in. Rules marked true produce
+// something that may simplify further.
+vector<RewriteRule> and_rule_list() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr z = Variable::make(Int(32), "z");
+    Expr p = Variable::make(Bool(), "p");
+    Expr t = const_true(), f = const_false();
+    return {
+        RewriteRule("true_and", t && p, p),
+        RewriteRule("and_true", p && t, p),
+        RewriteRule("false_and", f && p, f),
+        RewriteRule("and_false", p && f, f),
+        RewriteRule("and_self", p && p, p),
+        RewriteRule("le_and_le_lhs", x <= y && x <= z, x <= min(y, z), true),
+        RewriteRule("le_and_le_rhs", y <= x && z <= x, max(y, z) <= x, true),
+        RewriteRule("lt_and_lt_lhs", x < y && x < z, x < min(y, z), true),
+        RewriteRule("lt_and_lt_rhs", y < x && z < x, max(y, z) < x, true),
+        RewriteRule("eq_and_ne", x == y && x != y, f),
+        RewriteRule("eq_and_ne_swapped", x == y && y != x, f),
+        RewriteRule("ne_and_eq", x != y && x == y, f),
+        RewriteRule("ne_and_eq_swapped", x != y && y == x, f),
+        RewriteRule("not_and_self", !p && p, f),
+        RewriteRule("and_not_self", p && !p, f),
+        RewriteRule("le_and_gt", x <= y && y < x, f),
+        RewriteRule("lt_and_ge", x < y && y <= x, f)
+    };
+}
+
+vector<RewriteRule> or_rule_list() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr p = Variable::make(Bool(), "p");
+    Expr t = const_true(), f = const_false();
+    return {
+        RewriteRule("true_or", t || p, t),
+        RewriteRule("or_true", p || t, t),
+        RewriteRule("false_or", f || p, p),
+        RewriteRule("or_false", p || f, p),
+        RewriteRule("or_self", p || p, p),
+        RewriteRule("eq_or_ne", x == y || x != y, t),
+        RewriteRule("eq_or_ne_swapped", x == y || y != x, t),
+        RewriteRule("ne_or_eq", x != y || x == y, t),
+        RewriteRule("ne_or_eq_swapped", x != y || y == x, t),
+        RewriteRule("not_or_self", !p || p, t),
+        RewriteRule("or_not_self", p || !p, t),
+        RewriteRule("le_or_gt", x <= y || y < x, t),
+        RewriteRule("lt_or_ge", x < y || y <= x, t)
+    };
+}
+
+vector<RewriteRule> not_rule_list() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr p = Variable::make(Bool(), "p");
+    Expr t = const_true(), f = const_false();
+    return {
+        RewriteRule("not_true", !t, f),
+        RewriteRule("not_false", !f, t),
+        RewriteRule("not_not", !!p, p),
+        RewriteRule("not_le", !(x <= y), y < x),
+        RewriteRule("not_ge", !(x >= y), x < y),
+        RewriteRule("not_lt", !(x < y), y <= x),
+        RewriteRule("not_gt", !(x > y), x <= y),
+        RewriteRule("not_ne", !(x != y), x == y),
+        RewriteRule("not_eq", !(x == y), x != y)
+    };
+}
+
+vector<RewriteRule> select_rule_list() {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr z = Variable::make(Int(32), "z");
+    Expr w = Variable::make(Int(32), "w");
+    Expr p = Variable::make(Bool(), "p");
+    Expr t = const_true(), f = const_false();
+    return {
+        RewriteRule("select_false", Select::make(f, x, y), y),
+        RewriteRule("select_true", Select::make(t, x, y), x),
+        RewriteRule("select_same", Select::make(p, x, x), x),
+        // Normalize select(a != b, c, d) to select(a == b, d, c)
+        RewriteRule("select_ne", Select::make(x != y, z, w), Select::make(x == y, w, z), true),
+        // Normalize select(a <= b, c, d) to select(b < a, d, c)
+        RewriteRule("select_le", Select::make(x <= y, z, w), Select::make(y < x, w, z), true)
+    };
+}
+
+// The min and max rules that only hold when the type can't overflow
+// are only included when no_overflow is true.
+vector<RewriteRule> min_rule_list(bool no_overflow) {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr z = Variable::make(Int(32), "z");
+    Expr w = Variable::make(Int(32), "w");
+    Expr l = Variable::make(Int(32), "l");
+    Expr c0 = Variable::make(Int(32), "c0");
+    Expr c1 = Variable::make(Int(32), "c1");
+    vector<RewriteRule> rules = {
+        RewriteRule("min_add_const_add_const_b", min(x + c0, x + c1), x + c1, c0 > c1),
+        RewriteRule("min_add_const_add_const_a", min(x + c0, x + c1), x + c0),
+        RewriteRule("min_add_const_self_b", min(x + c0, x), x, c0 > 0),
+        RewriteRule("min_add_const_self_a", min(x + c0, x), x + c0),
+        RewriteRule("min_self_add_const_a", min(x, x + c0), x, c0 > 0),
+        RewriteRule("min_self_add_const_b", min(x, x + c0), x + c0),
+        RewriteRule("min_const_sub_const_sub_a", min(c0 - x, c1 - x), c0 - x, c0 < c1),
+        RewriteRule("min_const_sub_const_sub_b", min(c0 - x, c1 - x), c1 - x),
+        RewriteRule("min_max_b", min(max(x, y), y), y),
+        RewriteRule("min_min_b", min(min(x, y), y), min(x, y)),
+        RewriteRule("min_min_a", min(min(x, y), x), min(x, y)),
+        RewriteRule("min_b_min", min(y, min(x, y)), min(x, y)),
+        RewriteRule("min_a_min", min(x, min(x, y)), min(x, y)),
+        RewriteRule("min_min_min_b", min(min(min(x, y), z), y), min(min(x, y), z)),
+        RewriteRule("min_min_min_min_b", min(min(min(min(x, y), z), w), y), min(min(min(x, y), z), w)),
+        RewriteRule("min_min_min_min_min_b", min(min(min(min(min(x, y), z), w), l), y),
+                    min(min(min(min(x, y), z), w), l)),
+        // Distributive law for min/max
+        RewriteRule("min_max_aa", min(max(x, y), max(x, z)), max(min(y, z), x), true),
+        RewriteRule("min_max_ab", min(max(x, y), max(z, x)), max(min(y, z), x), true),
+        RewriteRule("min_max_ba", min(max(y, x), max(x, z)), max(min(y, z), x), true),
+        RewriteRule("min_max_bb", min(max(y, x), max(z, x)), max(min(y, z), x), true),
+        RewriteRule("min_min_aa", min(min(x, y), min(x, z)), min(min(y, z), x), true),
+        RewriteRule("min_min_ab", min(min(x, y), min(z, x)), min(min(y, z), x), true),
+        RewriteRule("min_min_ba", min(min(y, x), min(x, z)), min(min(y, z), x), true),
+        RewriteRule("min_min_bb", min(min(y, x), min(z, x)), min(min(y, z), x), true)
+    };
+    if (no_overflow) {
+        // Distributive law for addition
+        rules.push_back(RewriteRule("min_add_bb", min(x + y, z + y), min(x, z) + y, true));
+        rules.push_back(RewriteRule("min_add_aa", min(y + x, y + z), min(x, z) + y, true));
+        rules.push_back(RewriteRule("min_add_ab", min(y + x, z + y), min(x, z) + y, true));
+        rules.push_back(RewriteRule("min_add_ba", min(x + y, y + z), min(x, z) + y, true));
+    }
+    vector<RewriteRule> rest = {
+        RewriteRule("min_div_pos", min(x / c0, y / c0), min(x, y) / c0, c0 > 0, true),
+        RewriteRule("min_div_neg", min(x / c0, y / c0), max(x, y) / c0, c0 < 0, true),
+        RewriteRule("min_mul_pos", min(x * c0, y * c0), min(x, y) * c0, c0 > 0, true),
+        RewriteRule("min_mul_neg", min(x * c0, y * c0), max(x, y) * c0, true),
+        // min(x*8, 24) -> min(x, 3)*8
+        RewriteRule("min_mul_const_pos", min(x * c0, c1), min(x, c1 / c0) * c0, c0 > 0 && c1 % c0 == 0, true),
+        RewriteRule("min_mul_const_neg", min(x * c0, c1), max(x, c1 / c0) * c0, c0 < 0 && c1 % c0 == 0, true)
+    };
+    rules.insert(rules.end(), rest.begin(), rest.end());
+    return rules;
+}
+
+vector<RewriteRule> max_rule_list(bool no_overflow) {
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr z = Variable::make(Int(32), "z");
+    Expr w = Variable::make(Int(32), "w");
+    Expr l = Variable::make(Int(32), "l");
+    Expr c0 = Variable::make(Int(32), "c0");
+    Expr c1 = Variable::make(Int(32), "c1");
+    vector<RewriteRule> rules = {
+        RewriteRule("max_add_const_add_const_a", max(x + c0, x + c1), x + c0, c0 > c1),
+        RewriteRule("max_add_const_add_const_b", max(x + c0, x + c1), x + c1),
+        RewriteRule("max_add_const_self_a", max(x + c0, x), x + c0, c0 > 0),
+        RewriteRule("max_add_const_self_b", max(x + c0, x), x),
+        RewriteRule("max_self_add_const_b", max(x, x + c0), x + c0, c0 > 0),
+        RewriteRule("max_self_add_const_a", max(x, x + c0), x),
+        RewriteRule("max_const_sub_const_sub_a", max(c0 - x, c1 - x), c0 - x, c0 > c1),
+        RewriteRule("max_const_sub_const_sub_b", max(c0 - x, c1 - x), c1 - x),
+        RewriteRule("max_min_b", max(min(x, y), y), y),
+        RewriteRule("max_max_b", max(max(x, y), y), max(x, y)),
+        RewriteRule("max_max_a", max(max(x, y), x), max(x, y)),
+        RewriteRule("max_b_max", max(y, max(x, y)), max(x, y)),
+        RewriteRule("max_a_max", max(x, max(x, y)), max(x, y)),
+        RewriteRule("max_max_max_b", max(max(max(x, y), z), y), max(max(x, y), z)),
+        RewriteRule("max_max_max_max_b", max(max(max(max(x, y), z), w), y), max(max(max(x, y), z), w)),
+        RewriteRule("max_max_max_max_max_b", max(max(max(max(max(x, y), z), w), l), y),
+                    max(max(max(max(x, y), z), w), l)),
+        // Distributive law for min/max
+        RewriteRule("max_max_aa", max(max(x, y), max(x, z)), max(max(y, z), x), true),
+        RewriteRule("max_max_ab", max(max(x, y), max(z, x)), max(max(y, z), x), true),
+        RewriteRule("max_max_ba", max(max(y, x), max(x, z)), max(max(y, z), x), true),
+        RewriteRule("max_max_bb", max(max(y, x), max(z, x)), max(max(y, z), x), true),
+        RewriteRule("max_min_aa", max(min(x, y), min(x, z)), min(max(y, z), x), true),
+        RewriteRule("max_min_ab", max(min(x, y), min(z, x)), min(max(y, z), x), true),
+        RewriteRule("max_min_ba", max(min(y, x), min(x, z)), min(max(y, z), x), true),
+        RewriteRule("max_min_bb", max(min(y, x), min(z, x)), min(max(y, z), x), true)
+    };
+    if (no_overflow) {
+        // Distributive law for addition
+        rules.push_back(RewriteRule("max_add_bb", max(x + y, z + y), max(x, z) + y, true));
+        rules.push_back(RewriteRule("max_add_aa", max(y + x, y + z), max(x, z) + y, true));
+        rules.push_back(RewriteRule("max_add_ab", max(y + x, z + y), max(x, z) + y, true));
+        rules.push_back(RewriteRule("max_add_ba", max(x + y, y + z), max(x, z) + y, true));
+    }
+    vector<RewriteRule> rest = {
+        RewriteRule("max_div_pos", max(x / c0, y / c0), max(x, y) / c0, c0 > 0, true),
+        RewriteRule("max_div_neg", max(x / c0, y / c0), min(x, y) / c0, c0 < 0, true),
+        RewriteRule("max_mul_pos", max(x * c0, y * c0), max(x, y) * c0, c0 > 0, true),
+        RewriteRule("max_mul_neg", max(x * c0, y * c0), min(x, y) * c0, true),
+        // max(x*8, 24) -> max(x, 3)*8
+        RewriteRule("max_mul_const_pos", max(x * c0, c1), max(x, c1 / c0) * c0, c0 > 0 && c1 % c0 == 0, true),
+        RewriteRule("max_mul_const_neg", max(x * c0, c1), min(x, c1 / c0) * c0, c0 < 0 && c1 % c0 == 0, true)
+    };
+    rules.insert(rules.end(), rest.begin(), rest.end());
+    return rules;
+}
+
+const RewriteRules &and_rules() {
+    static RewriteRules rules("and", and_rule_list());
+    return rules;
+}
+
+const RewriteRules &or_rules() {
+    static RewriteRules rules("or", or_rule_list());
+    return rules;
+}
+
+const RewriteRules &not_rules() {
+    static RewriteRules rules("not", not_rule_list());
+    return rules;
+}
+
+const RewriteRules &select_rules() {
+    static RewriteRules rules("select", select_rule_list());
+    return rules;
+}
+
+const RewriteRules &min_rules(Type t) {
+    static RewriteRules rules("min", min_rule_list(false));
+    static RewriteRules no_overflow_rules("min_no_overflow", min_rule_list(true));
+    return no_overflow(t) ? no_overflow_rules : rules;
+}
+
+const RewriteRules &max_rules(Type t) {
+    static RewriteRules rules("max", max_rule_list(false));
+    static RewriteRules no_overflow_rules("max_no_overflow", max_rule_list(true));
+    return no_overflow(t) ? no_overflow_rules : rules;
+}
+
 class Simplify : public IRMutator {
 public:
     Simplify(bool r, const Scope<Interval> *bi, const Scope<ModulusRemainder> *ai) :
@@ -163,6 +399,19 @@ private:
         }
     }
 
+    // Try a list of rewrite rules on a node with the given
+    // (simplified) operands. Returns false if none of them match.
+    bool rewrite(const RewriteRules &rules, Type t, const Expr &a,
+                 const Expr &b = Expr(), const Expr &c = Expr()) {
+        bool again = false;
+        Expr e = rules.apply(t, a, b, c, &again);
+        if (!e.defined()) {
+            return false;
+        }
+        expr = again ? mutate(e) : e;
+        return true;
+    }
+
     void visit(const Cast *op) {
         Expr value = mutate(op->value);
         const Cast *cast = value.as<Cast>();
@@ -915,26 +1164,13 @@ private:
         const Broadcast *broadcast_a = a.as<Broadcast>();
         const Broadcast *broadcast_b = b.as<Broadcast>();
         const Ramp *ramp_a = a.as<Ramp>();
-        const Add *add_a = a.as<Add>();
-        const Add *add_b = b.as<Add>();
-        const Div *div_a = a.as<Div>();
-        const Div *div_b = b.as<Div>();
-        const Mul *mul_a = a.as<Mul>();
-        const Mul *mul_b = b.as<Mul>();
         const Sub *sub_a = a.as<Sub>();
-        const Sub *sub_b = b.as<Sub>();
         const Min *min_a = a.as<Min>();
-        const Min *min_b = b.as<Min>();
-        const Min *min_a_a = min_a ? min_a->a.as<Min>() : NULL;
-        const Min *min_a_a_a = min_a_a ? min_a_a->a.as<Min>() : NULL;
-        const Min *min_a_a_a_a = min_a_a_a ? min_a_a_a->a.as<Min>() : NULL;
         const Max *max_a = a.as<Max>();
         const Max *max_b = b.as<Max>();
         const Call *call_a = a.as<Call>();
         const Call *call_b = b.as<Call>();
 
-        min_a_a = max_a ? max_a->a.as<Min>() : min_a_a;
-
         // Detect if the lhs or rhs is a rounding-up operation
         int a_round_up_factor = 0, b_round_up_factor = 0;
         Expr a_round_up = is_round_up(a, &a_round_up_factor);
@@ -997,38 +1233,7 @@ private:
             }
         }
 
-        if (add_a && const_int(add_a->b, &ia) &&
-            add_b && const_int(add_b->b, &ib) &&
-            equal(add_a->a, add_b->a)) {
-            // min(x + 3, x - 2) -> x - 2
-            if (ia > ib) {
-                expr = b;
-            } else {
-                expr = a;
-            }
-        } else if (add_a && const_int(add_a->b, &ia) && equal(add_a->a, b)) {
-            // min(x + 5, x) -> x
-            if (ia > 0) {
-                expr = b;
-            } else {
-                expr = a;
-            }
-        } else if (add_b && const_int(add_b->b, &ib) && equal(add_b->a, a)) {
-            // min(x, x + 5) -> x
-            if (ib > 0) {
-                expr = a;
-            } else {
-                expr = b;
-            }
-        } else if (sub_a && sub_b && equal(sub_a->b, sub_b->b) &&
-                   const_int(sub_a->a, &ia) && const_int(sub_b->a, &ib)) {
-            // min (100-x, 101-x) -> 100-x
-            if (ia < ib) {
-                expr = a;
-            } else {
-                expr = b;
-            }
-        } else if (a_round_up.defined() && equal(a_round_up, b)) {
+        if (a_round_up.defined() && equal(a_round_up, b)) {
             // min(((a + 3)/4)*4, a) -> a
             expr = b;
         } else if (a_round_up.defined() && max_b &&
@@ -1042,62 +1247,8 @@ private:
                    equal(b_round_up, max_a->a) && equal(b_round_up_factor, max_a->b)) {
             // min(max(a, 4), ((a + 3)/4)*4) -> max(a, 4)
             expr = a;
-        } else if (max_a && equal(max_a->b, b)) {
-            // min(max(x, y), y) -> y
-            expr = b;
-        } else if (min_a && (equal(min_a->b, b) || equal(min_a->a, b))) {
-            // min(min(x, y), y) -> min(x, y)
-            expr = a;
-        } else if (min_b && (equal(min_b->b, a) || equal(min_b->a, a))) {
-            // min(y, min(x, y)) -> min(x, y)
-            expr = b;
-        } else if (min_a && min_a_a && equal(min_a_a->b, b)) {
-            // min(min(min(x, y), z), y) -> min(min(x, y), z)
-            expr = a;
-        } else if (min_a && min_a_a_a && equal(min_a_a_a->b, b)) {
-            // min(min(min(min(x, y), z), w), y) -> min(min(min(x, y), z), w)
-            expr = a;
-        } else if (min_a && min_a_a_a_a && equal(min_a_a_a_a->b, b)) {
-            // min(min(min(min(min(x, y), z), w), l), y) -> min(min(min(min(x, y), z), w), l)
-            expr = a;
-        } else if (max_a && max_b && equal(max_a->a, max_b->a)) {
-            // Distributive law for min/max
-            // min(max(x, y), max(x, z)) -> max(min(y, z), x)
-            expr = mutate(Max::make(Min::make(max_a->b, max_b->b), max_a->a));
-        } else if (max_a && max_b && equal(max_a->a, max_b->b)) {
-            // min(max(x, y), max(z, x)) -> max(min(y, z), x)
-            expr = mutate(Max::make(Min::make(max_a->b, max_b->a), max_a->a));
-        } else if (max_a && max_b && equal(max_a->b, max_b->a)) {
-            // min(max(y, x), max(x, z)) -> max(min(y, z), x)
-            expr = mutate(Max::make(Min::make(max_a->a, max_b->b), max_a->b));
-        } else if (max_a && max_b && equal(max_a->b, max_b->b)) {
-            // min(max(y, x), max(z, x)) -> max(min(y, z), x)
-            expr = mutate(Max::make(Min::make(max_a->a, max_b->a), max_a->b));
-        } else if (min_a && min_b && equal(min_a->a, min_b->a)) {
-            // min(min(x, y), min(x, z)) -> min(min(y, z), x)
-            expr = mutate(Min::make(Min::make(min_a->b, min_b->b), min_a->a));
-        } else if (min_a && min_b && equal(min_a->a, min_b->b)) {
-            // min(min(x, y), min(z, x)) -> min(min(y, z), x)
-            expr = mutate(Min::make(Min::make(min_a->b, min_b->a), min_a->a));
-        } else if (min_a && min_b && equal(min_a->b, min_b->a)) {
-            // min(min(y, x), min(x, z)) -> min(min(y, z), x)
-            expr = mutate(Min::make(Min::make(min_a->a, min_b->b), min_a->b));
-        } else if (min_a && min_b && equal(min_a->b, min_b->b)) {
-            // min(min(y, x), min(z, x)) -> min(min(y, z), x)
-            expr = mutate(Min::make(Min::make(min_a->a, min_b->a), min_a->b));
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->b, add_b->b)) {
-            // Distributive law for addition
-            // min(a + b, c + b) -> min(a, c) + b
-            expr = mutate(min(add_a->a, add_b->a)) + add_a->b;
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->a, add_b->a)) {
-            // min(b + a, b + c) -> min(a, c) + b
-            expr = mutate(min(add_a->b, add_b->b)) + add_a->a;
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->a, add_b->b)) {
-            // min(b + a, c + b) -> min(a, c) + b
-            expr = mutate(min(add_a->b, add_b->a)) + add_a->a;
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->b, add_b->a)) {
-            // min(a + b, b + c) -> min(a, c) + b
-            expr = mutate(min(add_a->a, add_b->b)) + add_a->b;
+        } else if (rewrite(min_rules(op->type), op->type, a, b)) {
+            return;
         } else if (min_a && is_simple_const(min_a->b)) {
             if (is_simple_const(b)) {
                 // min(min(x, 4), 5) -> min(x, 4)
@@ -1106,34 +1257,6 @@ private:
                 // min(min(x, 4), y) -> min(min(x, y), 4)
                 expr = mutate(Min::make(Min::make(min_a->a, b), min_a->b));
             }
-        } else if (div_a && div_b &&
-                   const_int(div_a->b, &ia) && ia &&
-                   const_int(div_b->b, &ib) &&
-                   (ia == ib)) {
-            // min(a / 4, b / 4) -> min(a, b) / 4
-            if (ia > 0) {
-                expr = mutate(min(div_a->a, div_b->a) / ia);
-            } else {
-                expr = mutate(max(div_a->a, div_b->a) / ia);
-            }
-        } else if (mul_a && mul_b &&
-                   const_int(mul_a->b, &ia) &&
-                   const_int(mul_b->b, &ib) &&
-                   (ia == ib)) {
-            if (ia > 0) {
-                expr = mutate(min(mul_a->a, mul_b->a) * ia);
-            } else {
-                expr = mutate(max(mul_a->a, mul_b->a) * ia);
-            }
-        } else if (mul_a && const_int(mul_a->b, &ia) &&
-                   const_int(b, &ib) &&
-                   ia && (ib % ia == 0)) {
-            // min(x*8, 24) -> min(x, 3)*8
-            if (ia > 0) {
-                expr = mutate(min(mul_a->a, ib/ia) * ia);
-            } else {
-                expr = mutate(max(mul_a->a, ib/ia) * ia);
-            }
         } else if (call_a && call_a->name == Call::likely && call_a->call_type == Call::Intrinsic &&
                    equal(call_a->args[0], b)) {
             // min(likely(b), b) -> likely(b)
@@ -1166,21 +1289,8 @@ private:
         const Broadcast *broadcast_a = a.as<Broadcast>();
         const Broadcast *broadcast_b = b.as<Broadcast>();
         const Ramp *ramp_a = a.as<Ramp>();
-        const Add *add_a = a.as<Add>();
-        const Add *add_b = b.as<Add>();
-        const Div *div_a = a.as<Div>();
-        const Div *div_b = b.as<Div>();
-        const Mul *mul_a = a.as<Mul>();
-        const Mul *mul_b = b.as<Mul>();
         const Sub *sub_a = a.as<Sub>();
-        const Sub *sub_b = b.as<Sub>();
         const Max *max_a = a.as<Max>();
-        const Max *max_b = b.as<Max>();
-        const Max *max_a_a = max_a ? max_a->a.as<Max>() : NULL;
-        const Max *max_a_a_a = max_a_a ? max_a_a->a.as<Max>() : NULL;
-        const Max *max_a_a_a_a = max_a_a_a ? max_a_a_a->a.as<Max>() : NULL;
-        const Min *min_a = a.as<Min>();
-        const Min *min_b = b.as<Min>();
         const Call *call_a = a.as<Call>();
         const Call *call_b = b.as<Call>();
 
@@ -1242,92 +1352,8 @@ private:
             }
         }
 
-        if (add_a && const_int(add_a->b, &ia) && add_b && const_int(add_b->b, &ib) && equal(add_a->a, add_b->a)) {
-            // max(x + 3, x - 2) -> x - 2
-            if (ia > ib) {
-                expr = a;
-            } else {
-                expr = b;
-            }
-        } else if (add_a && const_int(add_a->b, &ia) && equal(add_a->a, b)) {
-            // max(x + 5, x)
-            if (ia > 0) {
-                expr = a;
-            } else {
-                expr = b;
-            }
-        } else if (add_b && const_int(add_b->b, &ib) && equal(add_b->a, a)) {
-            // max(x, x + 5)
-            if (ib > 0) {
-                expr = b;
-            } else {
-                expr = a;
-            }
-        } else if (sub_a && sub_b && equal(sub_a->b, sub_b->b) &&
-                   const_int(sub_a->a, &ia) && const_int(sub_b->a, &ib)) {
-            // max (100-x, 101-x) -> 101-x
-            if (ia > ib) {
-                expr = a;
-            } else {
-                expr = b;
-            }
-        } else if (min_a && equal(min_a->b, b)) {
-            // max(min(x, y), y) -> y
-            expr = b;
-        } else if (max_a && (equal(max_a->b, b) || equal(max_a->a, b))) {
-            // max(max(x, y), y) -> max(x, y)
-            expr = a;
-        } else if (max_b && (equal(max_b->b, a) || equal(max_b->a, a))) {
-            // max(y, max(x, y)) -> max(x, y)
-            expr = b;
-        } else if (max_a_a && equal(max_a_a->b, b)) {
-            // max(max(max(x, y), z), y) -> max(max(x, y), z)
-            expr = a;
-        } else if (max_a_a_a && equal(max_a_a_a->b, b)) {
-            // max(max(max(max(x, y), z), w), y) -> max(max(max(x, y), z), w)
-            expr = a;
-        } else if (max_a_a_a_a && equal(max_a_a_a_a->b, b)) {
-            // max(max(max(max(max(x, y), z), w), l), y) -> max(max(max(max(x, y), z), w), l)
-            expr = a;
-
-        } else if (max_a && max_b && equal(max_a->a, max_b->a)) {
-            // Distributive law for min/max
-            // max(max(x, y), max(x, z)) -> max(max(y, z), x)
-            expr = mutate(Max::make(Max::make(max_a->b, max_b->b), max_a->a));
-        } else if (max_a && max_b && equal(max_a->a, max_b->b)) {
-            // max(max(x, y), max(z, x)) -> max(max(y, z), x)
-            expr = mutate(Max::make(Max::make(max_a->b, max_b->a), max_a->a));
-        } else if (max_a && max_b && equal(max_a->b, max_b->a)) {
-            // max(max(y, x), max(x, z)) -> max(max(y, z), x)
-            expr = mutate(Max::make(Max::make(max_a->a, max_b->b), max_a->b));
-        } else if (max_a && max_b && equal(max_a->b, max_b->b)) {
-            // max(max(y, x), max(z, x)) -> max(max(y, z), x)
-            expr = mutate(Max::make(Max::make(max_a->a, max_b->a), max_a->b));
-        } else if (min_a && min_b && equal(min_a->a, min_b->a)) {
-            // max(min(x, y), min(x, z)) -> min(max(y, z), x)
-            expr = mutate(Min::make(Max::make(min_a->b, min_b->b), min_a->a));
-        } else if (min_a && min_b && equal(min_a->a, min_b->b)) {
-            // max(min(x, y), min(z, x)) -> min(max(y, z), x)
-            expr = mutate(Min::make(Max::make(min_a->b, min_b->a), min_a->a));
-        } else if (min_a && min_b && equal(min_a->b, min_b->a)) {
-            // max(min(y, x), min(x, z)) -> min(max(y, z), x)
-            expr = mutate(Min::make(Max::make(min_a->a, min_b->b), min_a->b));
-        } else if (min_a && min_b && equal(min_a->b, min_b->b)) {
-            // max(min(y, x), min(z, x)) -> min(max(y, z), x)
-            expr = mutate(Min::make(Max::make(min_a->a, min_b->a), min_a->b));
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->b, add_b->b)) {
-            // Distributive law for addition
-            // max(a + b, c + b) -> max(a, c) + b
-            expr = mutate(max(add_a->a, add_b->a)) + add_a->b;
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->a, add_b->a)) {
-            // max(b + a, b + c) -> max(a, c) + b
-            expr = mutate(max(add_a->b, add_b->b)) + add_a->a;
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->a, add_b->b)) {
-            // max(b + a, c + b) -> max(a, c) + b
-            expr = mutate(max(add_a->b, add_b->a)) + add_a->a;
-        } else if (add_a && add_b && no_overflow(op->type) && equal(add_a->b, add_b->a)) {
-            // max(a + b, b + c) -> max(a, c) + b
-            expr = mutate(max(add_a->a, add_b->b)) + add_a->b;
+        if (rewrite(max_rules(op->type), op->type, a, b)) {
+            return;
         } else if (max_a && is_simple_const(max_a->b)) {
             if (is_simple_const(b)) {
                 // max(max(x, 4), 5) -> max(x, 4)
@@ -1336,34 +1362,6 @@ private:
                 // max(max(x, 4), y) -> max(max(x, y), 4)
                 expr = mutate(Max::make(Max::make(max_a->a, b), max_a->b));
             }
-        } else if (div_a && div_b &&
-                   const_int(div_a->b, &ia) && ia &&
-                   const_int(div_b->b, &ib) &&
-                   (ia == ib)) {
-            // max(a / 4, b / 4) -> max(a, b) / 4
-            if (ia > 0) {
-                expr = mutate(max(div_a->a, div_b->a) / ia);
-            } else {
-                expr = mutate(min(div_a->a, div_b->a) / ia);
-            }
-        } else if (mul_a && mul_b &&
-                   const_int(mul_a->b, &ia) &&
-                   const_int(mul_b->b, &ib) &&
-                   (ia == ib)) {
-            if (ia > 0) {
-                expr = mutate(max(mul_a->a, mul_b->a) * ia);
-            } else {
-                expr = mutate(min(mul_a->a, mul_b->a) * ia);
-            }
-        } else if (mul_a && const_int(mul_a->b, &ia) &&
-                   const_int(b, &ib) &&
-                   ia && (ib % ia == 0)) {
-            // max(x*8, 24) -> max(x, 3)*8
-            if (ia > 0) {
-                expr = mutate(max(mul_a->a, ib/ia) * ia);
-            } else {
-                expr = mutate(min(mul_a->a, ib/ia) * ia);
-            }
         } else if (call_a && call_a->name == Call::likely && call_a->call_type == Call::Intrinsic &&
                    equal(call_a->args[0], b)) {
             // max(likely(b), b) -> likely(b)
@@ -1677,64 +1675,9 @@ private:
 
         const Broadcast *broadcast_a = a.as<Broadcast>();
         const Broadcast *broadcast_b = b.as<Broadcast>();
-        const LE *le_a = a.as<LE>();
-        const LE *le_b = b.as<LE>();
-        const LT *lt_a = a.as<LT>();
-        const LT *lt_b = b.as<LT>();
-        const EQ *eq_a = a.as<EQ>();
-        const EQ *eq_b = b.as<EQ>();
-        const NE *neq_a = a.as<NE>();
-        const NE *neq_b = b.as<NE>();
-        const Not *not_a = a.as<Not>();
-        const Not *not_b = b.as<Not>();
-
-        if (is_one(a)) {
-            expr = b;
-        } else if (is_one(b)) {
-            expr = a;
-        } else if (is_zero(a)) {
-            expr = a;
-        } else if (is_zero(b)) {
-            expr = b;
-        } else if (equal(a, b)) {
-            // a && a -> a
-            expr = a;
-        } else if (le_a && le_b && equal(le_a->a, le_b->a)) {
-            // (x <= foo && x <= bar) -> x <= min(foo, bar)
-            expr = mutate(le_a->a <= min(le_a->b, le_b->b));
-        } else if (le_a && le_b && equal(le_a->b, le_b->b)) {
-            // (foo <= x && bar <= x) -> max(foo, bar) <= x
-            expr = mutate(max(le_a->a, le_b->a) <= le_a->b);
-        } else if (lt_a && lt_b && equal(lt_a->a, lt_b->a)) {
-            // (x < foo && x < bar) -> x < min(foo, bar)
-            expr = mutate(lt_a->a < min(lt_a->b, lt_b->b));
-        } else if (lt_a && lt_b && equal(lt_a->b, lt_b->b)) {
-            // (foo < x && bar < x) -> max(foo, bar) < x
-            expr = mutate(max(lt_a->a, lt_b->a) < lt_a->b);
-        } else if (eq_a && neq_b &&
-                   ((equal(eq_a->a, neq_b->a) && equal(eq_a->b, neq_b->b)) ||
-                    (equal(eq_a->a, neq_b->b) && equal(eq_a->b, neq_b->a)))) {
-            // a == b && a != b
-            expr = const_false(op->type.width);
-        } else if (eq_b && neq_a &&
-                   ((equal(eq_b->a, neq_a->a) && equal(eq_b->b, neq_a->b)) ||
-                    (equal(eq_b->a, neq_a->b) && equal(eq_b->b, neq_a->a)))) {
-            // a != b && a == b
-            expr = const_false(op->type.width);
-        } else if ((not_a && equal(not_a->a, b)) ||
-                   (not_b && equal(not_b->a, a))) {
-            // a && !a
-            expr = const_false(op->type.width);
-        } else if (le_a && lt_b &&
-                   equal(le_a->a, lt_b->b) &&
-                   equal(le_a->b, lt_b->a)) {
-            // a <= b && b < a
-            expr = const_false(op->type.width);
-        } else if (lt_a && le_b &&
-                   equal(lt_a->a, le_b->b) &&
-                   equal(lt_a->b, le_b->a)) {
-            // a < b && b <= a
-            expr = const_false(op->type.width);
+
+        if (rewrite(and_rules(), op->type, a, b)) {
+            return;
         } else if (broadcast_a && broadcast_b &&
                    broadcast_a->width == broadcast_b->width) {
             // x8(a) && x8(b) -> x8(a && b)
@@ -1751,52 +1694,9 @@ private:
 
         const Broadcast *broadcast_a = a.as<Broadcast>();
         const Broadcast *broadcast_b = b.as<Broadcast>();
-        const EQ *eq_a = a.as<EQ>();
-        const EQ *eq_b = b.as<EQ>();
-        const NE *neq_a = a.as<NE>();
-        const NE *neq_b = b.as<NE>();
-        const Not *not_a = a.as<Not>();
-        const Not *not_b = b.as<Not>();
-        const LE *le_a = a.as<LE>();
-        const LE *le_b = b.as<LE>();
-        const LT *lt_a = a.as<LT>();
-        const LT *lt_b = b.as<LT>();
-
-
-        if (is_one(a)) {
-            expr = a;
-        } else if (is_one(b)) {
-            expr = b;
-        } else if (is_zero(a)) {
-            expr = b;
-        } else if (is_zero(b)) {
-            expr = a;
-        } else if (equal(a, b)) {
-            expr = a;
-        } else if (eq_a && neq_b &&
-                   ((equal(eq_a->a, neq_b->a) && equal(eq_a->b, neq_b->b)) ||
-                    (equal(eq_a->a, neq_b->b) && equal(eq_a->b, neq_b->a)))) {
-            // a == b || a != b
-            expr = const_true(op->type.width);
-        } else if (neq_a && eq_b &&
-                   ((equal(eq_b->a, neq_a->a) && equal(eq_b->b, neq_a->b)) ||
-                    (equal(eq_b->a, neq_a->b) && equal(eq_b->b, neq_a->a)))) {
-            // a != b || a == b
-            expr = const_true(op->type.width);
-        } else if ((not_a && equal(not_a->a, b)) ||
-                   (not_b && equal(not_b->a, a))) {
-            // a || !a
-            expr = const_true(op->type.width);
-        } else if (le_a && lt_b &&
-                   equal(le_a->a, lt_b->b) &&
-                   equal(le_a->b, lt_b->a)) {
-            // a <= b || b < a
-            expr = const_true(op->type.width);
-        } else if (lt_a && le_b &&
-                   equal(lt_a->a, le_b->b) &&
-                   equal(lt_a->b, le_b->a)) {
-            // a < b || b <= a
-            expr = const_true(op->type.width);
+
+        if (rewrite(or_rules(), op->type, a, b)) {
+            return;
         } else if (broadcast_a && broadcast_b &&
                    broadcast_a->width == broadcast_b->width) {
             // x8(a) || x8(b) -> x8(a || b)
@@ -1811,25 +1711,8 @@ private:
     void visit(const Not *op) {
         Expr a = mutate(op->a);
 
-        if (is_one(a)) {
-            expr = make_zero(a.type());
-        } else if (is_zero(a)) {
-            expr = make_one(a.type());
-        } else if (const Not *n = a.as<Not>()) {
-            // Double negatives cancel
-            expr = n->a;
-        } else if (const LE *n = a.as<LE>()) {
-            expr = LT::make(n->b, n->a);
-        } else if (const GE *n = a.as<GE>()) {
-            expr = LT::make(n->a, n->b);
-        } else if (const LT *n = a.as<LT>()) {
-            expr = LE::make(n->b, n->a);
-        } else if (const GT *n = a.as<GT>()) {
-            expr = LE::make(n->a, n->b);
-        } else if (const NE *n = a.as<NE>()) {
-            expr = EQ::make(n->a, n->b);
-        } else if (const EQ *n = a.as<EQ>()) {
-            expr = NE::make(n->a, n->b);
+        if (rewrite(not_rules(), op->type, a)) {
+            return;
         } else if (const Broadcast *n = a.as<Broadcast>()) {
             expr = mutate(Broadcast::make(!n->value, n->width));
         } else if (a.same_as(op->a)) {
@@ -1847,21 +1730,11 @@ private:
         const Call *ct = true_value.as<Call>();
         const Call *cf = false_value.as<Call>();
 
-        if (is_zero(condition)) {
-            expr = false_value;
-        } else if (is_one(condition)) {
-            expr = true_value;
-        } else if (equal(true_value, false_value)) {
-            expr = true_value;
+        if (rewrite(select_rules(), op->type, condition, true_value, false_value)) {
+            return;
         } else if (const Broadcast *b = condition.as<Broadcast>()) {
             // Select of broadcast -> scalar select
             expr = mutate(Select::make(b->value, true_value, false_value));
-        } else if (const NE *ne = condition.as<NE>()) {
-            // Normalize select(a != b, c, d) to select(a == b, d, c)
-            expr = mutate(Select::make(ne->a == ne->b, false_value, true_value));
-        } else if (const LE *le = condition.as<LE>()) {
-            // Normalize select(a <= b, c, d) to select(b < a, d, c)
-            expr = mutate(Select::make(le->b < le->a, false_value, true_value));
         } else if (ct && ct->name == Call::likely && ct->call_type == Call::Intrinsic &&
                    equal(ct->args[0], false_value)) {
             // select(cond, likely(a), a) -> likely(a)
@@ -1925,9 +1798,13 @@ private:
         Stmt then_nosubs = then_case;
         Stmt else_nosubs = else_case;
 
-        // Mine the condition for useful constraints to apply (eg var == value && bool_param).
+        // Mine the condition for useful constraints to apply (eg
+        // var == value && bool_param). Vector conditions only hold in
+        // some lanes, so they tell us nothing.
         vector<Expr> stack;
-        stack.push_back(condition);
+        if (condition.type().is_scalar()) {
+            stack.push_back(condition);
+        }
         bool and_chain = false, or_chain = false;
         while (!stack.empty()) {
             Expr next = stack.back();
@@ -381,11 +381,35 @@ class MightBeSkippable : public IRVisitor {
             result = true;
             op->consume.accept(this);
             result = result || old_result;
+            // If other funcs are computed with this one, they're
+            // produced in its pipeline, so it can't be skipped.
+            ProvidesOtherFunc other(func);
+            op->produce.accept(&other);
+            if (other.result) {
+                result = false;
+            }
         } else {
             IRVisitor::visit(op);
         }
     }
 
+    class ProvidesOtherFunc : public IRVisitor {
+        using IRVisitor::visit;
+        const string &func;
+        void visit(const Provide *op) {
+            result |= (op->name != func);
+            IRVisitor::visit(op);
+        }
+        // Funcs computed at loops inside this one have their own
+        // pipelines.
+        void visit(const ProducerConsumer *op) {
+            op->consume.accept(this);
+        }
+    public:
+        bool result;
+        ProvidesOtherFunc(const string &f) : func(f), result(false) {}
+    };
+
     string func;
     bool guarded;
 
@@ -1,3 +1,5 @@
+#include <set>
+
 #include "SlidingWindow.h"
 #include "IRMutator.h"
 #include "IROperator.h"
@@ -307,13 +309,75 @@ public:
     SlidingWindowOnFunctionAndLoop(Function f, string v, Expr v_min) : func(f), loop_var(v), loop_min(v_min) {}
 };
 
+// Does a statement contain the production of a particular function?
+class ContainsProduction : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const ProducerConsumer *op) {
+        result |= (op->name == func);
+        IRVisitor::visit(op);
+    }
+
+public:
+    const string &func;
+    bool result;
+    ContainsProduction(const string &f) : func(f), result(false) {}
+};
+
+bool contains_production(Stmt s, const string &func) {
+    ContainsProduction c(func);
+    s.accept(&c);
+    return c.result;
+}
+
 // Perform sliding window optimization for a particular function
 class SlidingWindowOnFunction : public IRMutator {
     Function func;
-
+    const Realize *realize;
 
     using IRMutator::visit;
 
+    // The bounds on the number and size of the strips a parallel
+    // loop is divided into when sliding over it.
+    static const int max_strips = 64;
+    static const int min_strip_size = 16;
+
+    // The function is stored outside of a parallel loop on the host
+    // but computed within it. Each iteration needs its own copy of the storage, so
+    // move the realization inside the loop. If we can also slide
+    // along the loop, divide it into parallel strips. Each strip has
+    // its own copy of the storage, starts by computing the full
+    // region required (the warm-up), and slides from then on.
+    Stmt privatize_in_parallel_loop(const For *op, Stmt body) {
+        string strip_min_name = op->name + ".strip_min";
+        Expr strip_min = Variable::make(Int(32), strip_min_name);
+        Stmt slid = SlidingWindowOnFunctionAndLoop(func, op->name, strip_min).mutate(body);
+
+        if (slid.same_as(body)) {
+            debug(3) << "Giving each iteration of " << op->name << " its own copy of " << func.name() << "\n";
+            body = Realize::make(realize->name, realize->types, realize->bounds, realize->condition, body);
+            return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+        }
+
+        debug(3) << "Sliding " << func.name() << " within parallel strips of " << op->name << "\n";
+
+        string strip_name = op->name + ".strip";
+        string strip_size_name = op->name + ".strip_size";
+        Expr strip = Variable::make(Int(32), strip_name);
+        Expr strip_size = Variable::make(Int(32), strip_size_name);
+        Expr loop_end = op->min + op->extent;
+
+        Stmt s = For::make(op->name, strip_min, min(strip_size, loop_end - strip_min),
+                           ForType::Serial, op->device_api, slid);
+        s = Realize::make(realize->name, realize->types, realize->bounds, realize->condition, s);
+        s = LetStmt::make(strip_min_name, op->min + strip * strip_size, s);
+        s = For::make(strip_name, 0, (op->extent + strip_size - 1) / strip_size,
+                      ForType::Parallel, op->device_api, s);
+        s = LetStmt::make(strip_size_name,
+                          max(min_strip_size, (op->extent + (max_strips - 1)) / max_strips), s);
+        return s;
+    }
+
     void visit(const For *op) {
         debug(3) << " Doing sliding window analysis over loop: " << op->name << "\n";
 
@@ -324,6 +388,14 @@ class SlidingWindowOnFunction : public IRMutator {
         if (op->for_type == ForType::Serial ||
             op->for_type == ForType::Unrolled) {
             new_body = SlidingWindowOnFunctionAndLoop(func, op->name, op->min).mutate(new_body);
+        } else if (op->for_type == ForType::Parallel &&
+                   (op->device_api == DeviceAPI::Host ||
+                    op->device_api == DeviceAPI::Parent) &&
+                   !privatized &&
+                   contains_production(new_body, func.name())) {
+            privatized = true;
+            stmt = privatize_in_parallel_loop(op, new_body);
+            return;
         }
 
         if (new_body.same_as(op->body)) {
@@ -334,7 +406,10 @@ class SlidingWindowOnFunction : public IRMutator {
     }
 
 public:
-    SlidingWindowOnFunction(Function f) : func(f) {}
+    // Set if the realization had to be moved inside a parallel loop.
+    bool privatized;
+
+    SlidingWindowOnFunction(Function f, const Realize *r) : func(f), realize(r), privatized(false) {}
 };
 
 // Perform sliding window optimization for all functions
@@ -362,11 +437,26 @@ class SlidingWindow : public IRMutator {
             return;
         }
 
+        // If the realization has already been moved inside a
+        // parallel loop, we've already slid it.
+        if (privatized.count(op->name)) {
+            IRMutator::visit(op);
+            return;
+        }
+
         Stmt new_body = op->body;
 
         debug(3) << "Doing sliding window analysis on realization of " << op->name << "\n";
 
-        new_body = SlidingWindowOnFunction(iter->second).mutate(new_body);
+        SlidingWindowOnFunction slider(iter->second, op);
+        new_body = slider.mutate(new_body);
+
+        if (slider.privatized) {
+            // The realization now happens inside a parallel loop.
+            privatized.insert(op->name);
+            stmt = mutate(new_body);
+            return;
+        }
 
         new_body = mutate(new_body);
 
@@ -376,6 +466,8 @@ class SlidingWindow : public IRMutator {
             stmt = Realize::make(op->name, op->types, op->bounds, op->condition, new_body);
         }
     }
+    std::set<string> privatized;
+
 public:
     SlidingWindow(const map<string, Function> &e) : env(e) {}
 
@@ -51,21 +51,65 @@ public:
         func(f), dim(d), factor(e) {}
 };
 
+// Check if a statement stores to a function other than in that
+// function's own pipeline. This happens for the pipeline of a
+// function that another is computed with.
+class ProducesFuncDirectly : public IRVisitor {
+    const string &func;
+
+    using IRVisitor::visit;
+
+    void visit(const Provide *op) {
+        result |= (op->name == func);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const ProducerConsumer *op) {
+        if (op->name != func) {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result;
+    ProducesFuncDirectly(const string &f) : func(f), result(false) {}
+};
+
+bool produces_func_directly(Stmt s, const string &func) {
+    ProducesFuncDirectly p(func);
+    s.accept(&p);
+    return p.result;
+}
+
 // Attempt to fold the storage of a particular function in a statement
 class AttemptStorageFoldingOfFunction : public IRMutator {
-    string func;
+    Function func;
 
     using IRMutator::visit;
 
     void visit(const ProducerConsumer *op) {
-        if (op->name == func) {
-            // Can't proceed into the pipeline for this func
+        if (op->name == func.name() ||
+            produces_func_directly(op->produce, func.name())) {
+            // Can't proceed into the pipeline for this func, or the
+            // pipeline of a func computed with it.
             stmt = op;
         } else {
             IRMutator::visit(op);
         }
     }
 
+    // Get the fold factor the user requested for the given dimension
+    // of the function, if any.
+    Expr explicit_fold_factor(int dim) {
+        const string &arg = func.args()[dim];
+        for (const StorageDim &sd : func.schedule().storage_dims()) {
+            if (sd.var == arg) {
+                return sd.fold_factor;
+            }
+        }
+        return Expr();
+    }
+
     void visit(const For *op) {
         if (op->for_type != ForType::Serial && op->for_type != ForType::Unrolled) {
             // We can't proceed into a parallel for loop.
@@ -78,16 +122,24 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             return;
         }
 
-        Box box = box_touched(op->body, func);
+        Box box = box_touched(op->body, func.name());
 
         Stmt result = op;
 
+        // Set if we folded some dimension for which the regions used
+        // by consecutive loop iterations overlap. Each loop iteration
+        // only touches values within its own box, so it remains safe
+        // to fold other dimensions over this same loop, but we can't
+        // look for further folds in the loops inside it.
+        bool overlapping = false;
+
         // Try each dimension in turn from outermost in
         for (size_t i = box.size(); i > 0; i--) {
-            Expr min = simplify(box[i-1].min);
-            Expr max = simplify(box[i-1].max);
+            int dim = (int)i - 1;
+            Expr min = simplify(box[dim].min);
+            Expr max = simplify(box[dim].max);
 
-            debug(3) << "\nConsidering folding " << func << " over for loop over " << op->name << '\n'
+            debug(3) << "\nConsidering folding " << func.name() << " over for loop over " << op->name << '\n'
                      << "Min: " << min << '\n'
                      << "Max: " << max << '\n';
 
@@ -96,46 +148,62 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             if (is_monotonic(min, op->name) == MonotonicIncreasing ||
                 is_monotonic(max, op->name) == MonotonicDecreasing) {
 
-                // The max of the extent over all values of the loop variable must be a constant
                 Expr extent = simplify(max - min);
-                Scope<Interval> scope;
-                scope.push(op->name, Interval(Variable::make(Int(32), op->name + ".loop_min"),
-                                              Variable::make(Int(32), op->name + ".loop_max")));
-                Expr max_extent = bounds_of_expr_in_scope(extent, scope).max;
-                scope.pop(op->name);
-
-                max_extent = simplify(max_extent);
-
-                const IntImm *max_extent_int = max_extent.as<IntImm>();
-                if (max_extent_int) {
-                    int extent = max_extent_int->value;
+                Expr factor = explicit_fold_factor(dim);
+
+                if (factor.defined()) {
+                    debug(3) << "Proceeding with explicit factor " << factor << "\n";
+
+                    // Check at runtime that the region used per loop
+                    // iteration fits within the requested factor.
+                    const For *loop = result.as<For>();
+                    internal_assert(loop);
+                    Expr error = Call::make(Int(32), "halide_error_fold_factor_too_small",
+                                            {func.name(), func.args()[dim], factor, op->name, extent + 1},
+                                            Call::Extern);
+                    Stmt body = Block::make(AssertStmt::make(extent < factor, error), loop->body);
+                    result = For::make(loop->name, loop->min, loop->extent,
+                                       loop->for_type, loop->device_api, body);
+                } else {
+                    // The max of the extent over all values of the loop variable must be a constant
+                    Scope<Interval> scope;
+                    scope.push(op->name, Interval(Variable::make(Int(32), op->name + ".loop_min"),
+                                                  Variable::make(Int(32), op->name + ".loop_max")));
+                    Expr max_extent = bounds_of_expr_in_scope(extent, scope).max;
+                    scope.pop(op->name);
+
+                    max_extent = simplify(max_extent);
+
+                    const IntImm *max_extent_int = max_extent.as<IntImm>();
+                    if (!max_extent_int) {
+                        debug(3) << "Not folding because extent not bounded by a constant\n"
+                                 << "extent = " << extent << "\n"
+                                 << "max extent = " << max_extent << "\n";
+                        continue;
+                    }
 
-                    int factor = 1;
-                    while (factor <= extent) factor *= 2;
+                    int f = 1;
+                    while (f <= max_extent_int->value) f *= 2;
+                    factor = f;
 
                     debug(3) << "Proceeding with factor " << factor << "\n";
+                }
 
-                    Fold fold = {(int)i - 1, factor};
-                    dims_folded.push_back(fold);
-                    result = FoldStorageOfFunction(func, (int)i - 1, factor).mutate(result);
-
-                    Expr step = finite_difference(min, op->name);
+                Fold fold = {dim, factor};
+                dims_folded.push_back(fold);
+                result = FoldStorageOfFunction(func.name(), dim, factor).mutate(result);
 
-                    if (is_one(simplify(extent < step))) {
-                        // There's no overlapping usage between loop
-                        // iterations, so we can continue to search
-                        // for further folding opportinities
-                        // recursively.
-                    } else {
-                        stmt = result;
-                        return;
-                    }
+                Expr step = finite_difference(min, op->name);
 
+                if (is_one(simplify(extent < step))) {
+                    // There's no overlapping usage between loop
+                    // iterations, so we can continue to search
+                    // for further folding opportinities
+                    // recursively.
                 } else {
-                    debug(3) << "Not folding because extent not bounded by a constant\n"
-                             << "extent = " << extent << "\n"
-                             << "max extent = " << max_extent << "\n";
+                    overlapping = true;
                 }
+
             } else {
                 debug(3) << "Not folding because loop min or max not monotonic in the loop variable\n"
                          << "min = " << min << "\n"
@@ -143,6 +211,11 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             }
         }
 
+        if (overlapping) {
+            stmt = result;
+            return;
+        }
+
         // Any folds that took place folded dimensions away entirely, so we can proceed recursively.
         if (const For *f = result.as<For>()) {
             Stmt body = mutate(f->body);
@@ -164,7 +237,7 @@ public:
     };
     vector<Fold> dims_folded;
 
-    AttemptStorageFoldingOfFunction(string f) : func(f) {}
+    AttemptStorageFoldingOfFunction(Function f) : func(f) {}
 };
 
 /** Check if a buffer's allocated is referred to directly via an
@@ -190,17 +263,44 @@ private:
 
 // Look for opportunities for storage folding in a statement
 class StorageFolding : public IRMutator {
+    const map<string, Function> &env;
+
     using IRMutator::visit;
 
+    // Complain about any dimensions of the function that the user
+    // asked us to fold, but which we could not.
+    void check_explicit_folds(const Function &f, const vector<AttemptStorageFoldingOfFunction::Fold> &folded) {
+        for (const StorageDim &sd : f.schedule().storage_dims()) {
+            if (!sd.fold_factor.defined()) continue;
+            bool found = false;
+            for (const AttemptStorageFoldingOfFunction::Fold &fold : folded) {
+                found |= (f.args()[fold.dim] == sd.var);
+            }
+            user_assert(found)
+                << "Can't fold the storage of " << f.name()
+                << " in dimension " << sd.var
+                << " by " << sd.fold_factor
+                << ", because there is no serial loop between its store_at"
+                << " and compute_at levels over which the region of "
+                << f.name() << " used moves monotonically in that dimension,"
+                << " or because its buffer is used directly (e.g. by an extern stage).\n";
+        }
+    }
+
     void visit(const Realize *op) {
         Stmt body = mutate(op->body);
 
-        AttemptStorageFoldingOfFunction folder(op->name);
+        map<string, Function>::const_iterator iter = env.find(op->name);
+        internal_assert(iter != env.end()) << "Realize node refers to function not in environment.\n";
+        const Function &func = iter->second;
+
+        AttemptStorageFoldingOfFunction folder(func);
         IsBufferSpecial special(op->name);
         op->accept(&special);
 
         if (special.special) {
             debug(3) << "Not attempting to fold " << op->name << " because it is referenced by an intrinsic\n";
+            check_explicit_folds(func, folder.dims_folded);
             if (body.same_as(op->body)) {
                 stmt = op;
             } else {
@@ -209,6 +309,7 @@ class StorageFolding : public IRMutator {
         } else {
             debug(3) << "Attempting to fold " << op->name << "\n";
             Stmt new_body = folder.mutate(body);
+            check_explicit_folds(func, folder.dims_folded);
 
             if (new_body.same_as(op->body)) {
                 stmt = op;
@@ -230,6 +331,9 @@ class StorageFolding : public IRMutator {
             }
         }
     }
+
+public:
+    StorageFolding(const map<string, Function> &e) : env(e) {}
 };
 
 // Because storage folding runs before simplification, it's useful to
@@ -266,9 +370,9 @@ class SubstituteInConstants : public IRMutator {
     }
 };
 
-Stmt storage_folding(Stmt s) {
+Stmt storage_folding(Stmt s, const map<string, Function> &env) {
     s = SubstituteInConstants().mutate(s);
-    s = StorageFolding().mutate(s);
+    s = StorageFolding(env).mutate(s);
     return s;
 }
 
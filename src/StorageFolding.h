@@ -6,6 +6,8 @@
  * down to smaller circular buffers when possible
  */
 
+#include <map>
+
 #include "IR.h"
 
 namespace Halide {
@@ -22,9 +24,11 @@ namespace Internal {
  \endcode
  *
  * We can store f as a circular buffer of size two, instead of
- * allocating space for all of it.
+ * allocating space for all of it. Dimensions given an explicit fold
+ * factor with Func::fold_storage are folded by that factor, with a
+ * runtime assertion that the footprint fits.
  */
-Stmt storage_folding(Stmt s);
+Stmt storage_folding(Stmt s, const std::map<std::string, Function> &env);
 
 }
 }
@@ -112,30 +112,8 @@ Target get_host_target() {
 #endif
 }
 
-namespace {
-string get_env(const char *name) {
-#ifdef _WIN32
-    char buf[128];
-    size_t read = 0;
-    getenv_s(&read, buf, name);
-    if (read) {
-        return string(buf);
-    } else {
-        return "";
-    }
-#else
-    char *buf = getenv(name);
-    if (buf) {
-        return string(buf);
-    } else {
-        return "";
-    }
-#endif
-}
-}
-
 Target get_target_from_environment() {
-    string target = get_env("HL_TARGET");
+    string target = Internal::get_env_variable("HL_TARGET");
     if (target.empty()) {
         return get_host_target();
     } else {
@@ -146,7 +124,7 @@ Target get_target_from_environment() {
 Target get_jit_target_from_environment() {
     Target host = get_host_target();
     host.set_feature(Target::JIT);
-    string target = get_env("HL_JIT_TARGET");
+    string target = Internal::get_env_variable("HL_JIT_TARGET");
     if (target.empty()) {
         return host;
     } else {
@@ -121,5 +121,25 @@ std::vector<std::string> split_string(const std::string &source, const std::stri
     return elements;
 }
 
+std::string get_env_variable(const char *name) {
+#ifdef _WIN32
+    char buf[128];
+    size_t read = 0;
+    getenv_s(&read, buf, name);
+    if (read) {
+        return std::string(buf);
+    } else {
+        return "";
+    }
+#else
+    char *buf = getenv(name);
+    if (buf) {
+        return std::string(buf);
+    } else {
+        return "";
+    }
+#endif
+}
+
 }
 }
@@ -81,6 +81,10 @@ EXPORT std::string base_name(const std::string &name, char delim = '.');
 /** Split the source string using 'delim' as the divider. */
 EXPORT std::vector<std::string> split_string(const std::string &source, const std::string &delim);
 
+/** Get the value of an environment variable, or the empty string if
+ * it isn't set. */
+EXPORT std::string get_env_variable(const char *name);
+
 template <typename T>
 inline NO_INLINE void collect_args(std::vector<T> &collected_args) {
 }
@@ -16,6 +16,112 @@ namespace Internal {
 using std::string;
 using std::vector;
 
+namespace {
+
+// Checks whether a vectorized statement can be executed under a
+// vector predicate, with all of its loads and stores masked by
+// it. This is the case if the statement consists only of lets,
+// nested ifs, and loads and stores of the predicate's width, and
+// has no side-effects other than the stores.
+class CanPredicate : public IRVisitor {
+    int width;
+
+    using IRVisitor::visit;
+
+    void visit(const For *) {result = false;}
+    void visit(const Allocate *) {result = false;}
+    void visit(const Free *) {result = false;}
+    void visit(const AssertStmt *) {result = false;}
+    void visit(const Evaluate *) {result = false;}
+    void visit(const ProducerConsumer *) {result = false;}
+    void visit(const Realize *) {result = false;}
+    void visit(const Provide *) {result = false;}
+
+    void visit(const Load *op) {
+        if (op->type.width != 1 && op->type.width != width) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Store *op) {
+        // Scalar stores are the same for every lane, so they happen
+        // if any lane is active. Vector stores of every lane to the
+        // same address can't be masked, because which lane's value
+        // lands depends on which lanes are active.
+        if ((op->value.type().width != 1 && op->value.type().width != width) ||
+            op->index.as<Broadcast>()) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Call *op) {
+        if (op->call_type == Call::Extern) {
+            // Only the math library is known to be free of
+            // side-effects.
+            if (!ends_with(op->name, "_f32") &&
+                !ends_with(op->name, "_f64")) {
+                result = false;
+                return;
+            }
+        } else if (op->call_type == Call::Intrinsic) {
+            if (op->name == Call::trace ||
+                op->name == Call::trace_expr ||
+                op->name == Call::copy_memory ||
+                op->name == Call::shuffle_vector ||
+                op->name == Call::glsl_texture_load ||
+                op->name == Call::glsl_texture_store ||
+                op->name == Call::image_load ||
+                op->name == Call::image_store) {
+                result = false;
+                return;
+            }
+        }
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result;
+    CanPredicate(int w) : width(w), result(true) {}
+};
+
+bool can_predicate(Stmt s, int width) {
+    CanPredicate c(width);
+    s.accept(&c);
+    return c.result;
+}
+
+// Checks whether an expression loads from memory, or from a
+// particular buffer if one is named.
+class ContainsLoad : public IRVisitor {
+    const string &name;
+
+    using IRVisitor::visit;
+
+    void visit(const Load *op) {
+        if (name.empty() || op->name == name) {
+            result = true;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+public:
+    bool result;
+    ContainsLoad(const string &n) : name(n), result(false) {}
+};
+
+bool contains_load(Expr e, const string &name = "") {
+    ContainsLoad c(name);
+    e.accept(&c);
+    return c.result;
+}
+
+}
+
 class VectorizeLoops : public IRMutator {
     class VectorSubs : public IRMutator {
         string var;
@@ -27,6 +133,10 @@ class VectorizeLoops : public IRMutator {
         bool scalarized;
         int scalar_lane;
 
+        // The lanes active in the code being vectorized, if it is
+        // inside an if statement with a vector condition.
+        Expr vector_condition;
+
         Expr widen(Expr e, int width) {
             if (e.type().width == width) {
                 return e;
@@ -83,8 +193,24 @@ class VectorizeLoops : public IRMutator {
         void visit(const Add *op) {mutate_binary_operator(op);}
         void visit(const Sub *op) {mutate_binary_operator(op);}
         void visit(const Mul *op) {mutate_binary_operator(op);}
-        void visit(const Div *op) {mutate_binary_operator(op);}
-        void visit(const Mod *op) {mutate_binary_operator(op);}
+        // Integer division by zero traps. Under a vector condition,
+        // the inactive lanes may hold anything, such as the values of
+        // masked loads that didn't happen, so give them a divisor of
+        // one instead.
+        template<typename T>
+        void mutate_division(const T *op) {
+            mutate_binary_operator(op);
+            const T *d = expr.as<T>();
+            if (d && vector_condition.defined() &&
+                d->type.width == vector_condition.type().width &&
+                !d->type.is_float() && !is_positive_const(d->b)) {
+                Expr divisor = Select::make(vector_condition, d->b, make_one(d->b.type()));
+                expr = T::make(d->a, divisor);
+            }
+        }
+
+        void visit(const Div *op) {mutate_division(op);}
+        void visit(const Mod *op) {mutate_division(op);}
         void visit(const Min *op) {mutate_binary_operator(op);}
         void visit(const Max *op) {mutate_binary_operator(op);}
         void visit(const EQ *op)  {mutate_binary_operator(op);}
@@ -393,12 +519,87 @@ class VectorizeLoops : public IRMutator {
 
             if (value.same_as(op->value) && index.same_as(op->index)) {
                 stmt = op;
+            } else if (index.type().is_scalar() && value.type().is_vector() &&
+                       !internal_allocations.contains(op->name)) {
+                // Every lane stores to the same place. This is only
+                // well-defined if it's an associative update, in
+                // which case we combine the lanes first and then do
+                // a single scalar update.
+                Expr reduced = reduce_update(op->name, index, value);
+                if (reduced.defined()) {
+                    stmt = Store::make(op->name, reduced, index);
+                } else {
+                    int width = value.type().width;
+                    stmt = Store::make(op->name, value, widen(index, width));
+                }
             } else {
                 int width = std::max(value.type().width, index.type().width);
                 stmt = Store::make(op->name, widen(value, width), widen(index, width));
             }
         }
 
+        // Check if a vectorized value is of the form f[index] op e,
+        // where f[index] was broadcast, and e doesn't load from f.
+        template<typename T>
+        bool is_update(Expr value, const string &name, Expr index, Expr *acc, Expr *rest) {
+            const T *op = value.as<T>();
+            return op && (is_update_of(op->a, op->b, name, index, acc, rest) ||
+                          is_update_of(op->b, op->a, name, index, acc, rest));
+        }
+
+        bool is_update_of(Expr a, Expr e, const string &name, Expr index, Expr *acc, Expr *rest) {
+            const Broadcast *b = a.as<Broadcast>();
+            const Load *load = b ? b->value.as<Load>() : NULL;
+            if (load && load->name == name && equal(load->index, index) &&
+                !contains_load(e, name)) {
+                *acc = b->value;
+                *rest = e;
+                return true;
+            }
+            return false;
+        }
+
+        // Turn a vector update of a single location, f[index] = f[index] op e,
+        // into a scalar update with the lanes of e combined using a
+        // horizontal reduction. Returns the new value to store, or an
+        // undefined Expr if the update isn't associative.
+        Expr reduce_update(const string &name, Expr index, Expr value) {
+            Type t = value.type().element_of();
+            Expr acc, rest, identity;
+            const char *reduce = NULL;
+            if (is_update<Add>(value, name, index, &acc, &rest)) {
+                reduce = Call::vector_reduce_add;
+                identity = make_zero(t);
+            } else if (is_update<Mul>(value, name, index, &acc, &rest)) {
+                reduce = Call::vector_reduce_mul;
+                identity = make_one(t);
+            } else if (is_update<Min>(value, name, index, &acc, &rest)) {
+                reduce = Call::vector_reduce_min;
+                identity = t.max();
+            } else if (is_update<Max>(value, name, index, &acc, &rest)) {
+                reduce = Call::vector_reduce_max;
+                identity = t.min();
+            } else {
+                return Expr();
+            }
+
+            // Inactive lanes mustn't contribute.
+            if (vector_condition.defined()) {
+                rest = Select::make(vector_condition, rest, Broadcast::make(identity, rest.type().width));
+            }
+
+            Expr r = Call::make(t, reduce, {rest}, Call::Intrinsic);
+            if (reduce == Call::vector_reduce_add) {
+                return Add::make(acc, r);
+            } else if (reduce == Call::vector_reduce_mul) {
+                return Mul::make(acc, r);
+            } else if (reduce == Call::vector_reduce_min) {
+                return Min::make(acc, r);
+            } else {
+                return Max::make(acc, r);
+            }
+        }
+
         void visit(const AssertStmt *op) {
             if (op->condition.type().width > 1) {
                 stmt = scalarize(op);
@@ -413,7 +614,59 @@ class VectorizeLoops : public IRMutator {
             debug(3) << "Vectorizing over " << var << "\n"
                      << "Old: " << op->condition << "\n"
                      << "New: " << cond << "\n";
+            Stmt then_case, else_case;
+            string cond_name = unique_name('t');
+            Expr cond_var = Variable::make(cond.type(), cond_name);
             if (width > 1) {
+                Expr old_condition = vector_condition;
+                vector_condition = old_condition.defined() ? (old_condition && cond_var) : cond_var;
+                then_case = mutate(op->then_case);
+                if (op->else_case.defined()) {
+                    vector_condition = old_condition.defined() ? (old_condition && !cond_var) : !cond_var;
+                    else_case = mutate(op->else_case);
+                }
+                vector_condition = old_condition;
+            }
+            const Store *then_store = then_case.defined() ? then_case.as<Store>() : NULL;
+            const Store *else_store = else_case.defined() ? else_case.as<Store>() : NULL;
+            if (then_store && else_store &&
+                then_store->name == else_store->name &&
+                then_store->value.type() == else_store->value.type() &&
+                then_store->value.type().width == width &&
+                equal(then_store->index, else_store->index) &&
+                !contains_load(then_store->value) &&
+                !contains_load(else_store->value)) {
+                // Both branches store to the same place, and
+                // evaluating the value of the branch not taken can't
+                // read out of bounds. Divisions in it are guarded by
+                // the condition. If-convert to a single store of a
+                // select.
+                debug(3) << "If-converting if then else\n";
+                Expr value = select(cond_var, then_store->value, else_store->value);
+                stmt = Store::make(then_store->name, value, then_store->index);
+                stmt = LetStmt::make(cond_name, cond, stmt);
+            } else if (then_case.defined() &&
+                       can_predicate(then_case, width) &&
+                       (!else_case.defined() || can_predicate(else_case, width))) {
+                // It's an if statement on a vector of conditions, but
+                // the branches only load and store. We can execute
+                // each branch with its loads and stores masked by the
+                // condition (or its negation). This is how the tails
+                // of loops split with TailStrategy::GuardWithIf stay
+                // vectorized.
+                debug(3) << "Predicating if then else\n";
+                // The then case may store to something the
+                // condition loads from, so evaluate it once. Any
+                // horizontal reductions in the branches also refer
+                // to it.
+                if (else_case.defined()) {
+                    stmt = Block::make(IfThenElse::make(cond_var, then_case, Stmt()),
+                                       IfThenElse::make(!cond_var, else_case, Stmt()));
+                } else {
+                    stmt = IfThenElse::make(cond_var, then_case, Stmt());
+                }
+                stmt = LetStmt::make(cond_name, cond, stmt);
+            } else if (width > 1) {
                 // It's an if statement on a vector of
                 // conditions. We'll have to scalarize and make
                 // multiple copies of the if statement.
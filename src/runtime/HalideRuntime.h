@@ -414,6 +414,11 @@ enum halide_error_code_t {
      * a GPU kernel. Turn on -debug in your target string to see more
      * details. */
     halide_error_code_device_run_failed = -23,
+
+    /** The region of a Func used per iteration of the loop over
+     * which its storage was folded with Func::fold_storage was
+     * larger than the fold factor. */
+    halide_error_code_fold_factor_too_small = -24,
 };
 
 /** Halide calls the functions below on various error conditions. The
@@ -465,6 +470,8 @@ extern int halide_error_out_of_memory(void *user_context);
 extern int halide_error_buffer_argument_is_null(void *user_context, const char *buffer_name);
 extern int halide_error_debug_to_file_failed(void *user_context, const char *func,
                                              const char *filename, int error_code);
+extern int halide_error_fold_factor_too_small(void *user_context, const char *func_name, const char *var_name,
+                                              int fold_factor, const char *loop_name, int required_extent);
 // @}
 
 
@@ -197,4 +197,14 @@ WEAK int halide_error_debug_to_file_failed(void *user_context, const char *func,
     return halide_error_code_debug_to_file_failed;
 }
 
+WEAK int halide_error_fold_factor_too_small(void *user_context, const char *func_name, const char *var_name,
+                                            int fold_factor, const char *loop_name, int required_extent) {
+    error(user_context)
+        << "The fold factor (" << fold_factor
+        << ") of dimension " << var_name << " of " << func_name
+        << " is too small to store the required region accessed by loop "
+        << loop_name << " (" << required_extent << ").";
+    return halide_error_code_fold_factor_too_small;
+}
+
 }
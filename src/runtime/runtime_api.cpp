@@ -46,6 +46,7 @@ __attribute__((used)) void *runtime_api_functions[] = {
     (void *)&halide_error_debug_to_file_failed,
     (void *)&halide_error_explicit_bounds_too_small,
     (void *)&halide_error_extern_stage_failed,
+    (void *)&halide_error_fold_factor_too_small,
     (void *)&halide_error_out_of_memory,
     (void *)&halide_error_param_too_large_f64,
     (void *)&halide_error_param_too_large_i64,
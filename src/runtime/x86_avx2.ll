@@ -0,0 +1,49 @@
+declare <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8>, <32 x i8>, <32 x i8>) nounwind readnone
+
+define weak_odr <32 x i8> @pblendvb_i8x32(<32 x i1> %c, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = sext <32 x i1> %c to <32 x i8>
+  %2 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %1)
+  ret <32 x i8> %2
+}
+
+define weak_odr <32 x i8> @pblendvb_eq_i8x32(<32 x i8> %a, <32 x i8> %b, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = icmp eq <32 x i8> %a, %b
+  %2 = sext <32 x i1> %1 to <32 x i8>
+  %3 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %2)
+  ret <32 x i8> %3
+}
+
+define weak_odr <32 x i8> @pblendvb_ne_i8x32(<32 x i8> %a, <32 x i8> %b, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = icmp ne <32 x i8> %a, %b
+  %2 = sext <32 x i1> %1 to <32 x i8>
+  %3 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %2)
+  ret <32 x i8> %3
+}
+
+define weak_odr <32 x i8> @pblendvb_ult_i8x32(<32 x i8> %a, <32 x i8> %b, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = icmp ult <32 x i8> %a, %b
+  %2 = sext <32 x i1> %1 to <32 x i8>
+  %3 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %2)
+  ret <32 x i8> %3
+}
+
+define weak_odr <32 x i8> @pblendvb_slt_i8x32(<32 x i8> %a, <32 x i8> %b, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = icmp slt <32 x i8> %a, %b
+  %2 = sext <32 x i1> %1 to <32 x i8>
+  %3 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %2)
+  ret <32 x i8> %3
+}
+
+define weak_odr <32 x i8> @pblendvb_ule_i8x32(<32 x i8> %a, <32 x i8> %b, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = icmp ule <32 x i8> %a, %b
+  %2 = sext <32 x i1> %1 to <32 x i8>
+  %3 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %2)
+  ret <32 x i8> %3
+}
+
+define weak_odr <32 x i8> @pblendvb_sle_i8x32(<32 x i8> %a, <32 x i8> %b, <32 x i8> %t, <32 x i8> %f) nounwind alwaysinline {
+  %1 = icmp sle <32 x i8> %a, %b
+  %2 = sext <32 x i1> %1 to <32 x i8>
+  %3 = tail call <32 x i8> @llvm.x86.avx2.pblendvb(<32 x i8> %f, <32 x i8> %t, <32 x i8> %2)
+  ret <32 x i8> %3
+}
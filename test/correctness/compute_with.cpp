@@ -0,0 +1,68 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    // Two outputs of different sizes that share a producer computed
+    // per row of the fused loop.
+    {
+        Func in("in"), f("f"), g("g");
+        in(x, y) = x * 3 + y;
+        f(x, y) = in(x, y) * 2;
+        g(x, y) = in(x, y) + in(x + 1, y);
+
+        in.compute_at(f, y);
+        g.compute_with(f, y);
+
+        Image<int> f_im(20, 10), g_im(13, 17);
+        Pipeline({f, g}).realize(Realization{f_im, g_im});
+
+        for (int j = 0; j < f_im.height(); j++) {
+            for (int i = 0; i < f_im.width(); i++) {
+                int correct = (i * 3 + j) * 2;
+                if (f_im(i, j) != correct) {
+                    printf("f(%d, %d) = %d instead of %d\n", i, j, f_im(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+        for (int j = 0; j < g_im.height(); j++) {
+            for (int i = 0; i < g_im.width(); i++) {
+                int correct = (i * 3 + j) + ((i + 1) * 3 + j);
+                if (g_im(i, j) != correct) {
+                    printf("g(%d, %d) = %d instead of %d\n", i, j, g_im(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Two intermediates fused all the way down to the innermost loop,
+    // over regions that are offset from each other.
+    {
+        Func f("f"), g("g"), out("out");
+        f(x, y) = x + y * 10;
+        g(x, y) = x * y;
+        out(x, y) = f(x, y) + g(x + 5, y - 1);
+
+        f.compute_root();
+        g.compute_root().compute_with(f, x);
+
+        Image<int> result = out.realize(16, 16);
+        for (int j = 0; j < result.height(); j++) {
+            for (int i = 0; i < result.width(); i++) {
+                int correct = (i + j * 10) + (i + 5) * (j - 1);
+                if (result(i, j) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
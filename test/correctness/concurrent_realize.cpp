@@ -0,0 +1,90 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 256, H = 64;
+    const int num_threads = 8;
+    const int iterations = 50;
+
+    ImageParam input(Int(32), 2);
+    Param<int> offset;
+    Param<float> scale;
+
+    Var x("x"), y("y");
+    Func f("f");
+    f(x, y) = cast<int>(input(x, y) * scale) + offset;
+    f.vectorize(x, 8).parallel(y);
+
+    Pipeline p(f);
+
+    // Each thread gets its own input, and there's nothing bound to
+    // the params themselves.
+    std::vector<Image<int>> inputs;
+    for (int t = 0; t < num_threads; t++) {
+        Image<int> in(W, H);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                in(x, y) = x + y * W + t;
+            }
+        }
+        inputs.push_back(in);
+    }
+
+    std::vector<int> errors(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.push_back(std::thread([&, t]() {
+            for (int i = 0; i < iterations; i++) {
+                ParamMap params;
+                params.set(input, inputs[t]);
+                params.set(offset, t * 1000 + i);
+                params.set(scale, (float)(t + 1));
+
+                Image<int> out(W, H);
+                p.realize(out, params);
+
+                for (int y = 0; y < H; y++) {
+                    for (int x = 0; x < W; x++) {
+                        int correct = (int)(inputs[t](x, y) * (float)(t + 1)) + t * 1000 + i;
+                        if (out(x, y) != correct) {
+                            errors[t]++;
+                        }
+                    }
+                }
+            }
+        }));
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    for (int t = 0; t < num_threads; t++) {
+        if (errors[t]) {
+            printf("Thread %d saw %d wrong values\n", t, errors[t]);
+            return -1;
+        }
+    }
+
+    // Params that aren't in the map use their bound values.
+    offset.set(17);
+    scale.set(2.0f);
+    ParamMap only_input;
+    only_input.set(input, inputs[0]);
+    Image<int> out = p.realize({W, H}, only_input);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int correct = inputs[0](x, y) * 2 + 17;
+            if (out(x, y) != correct) {
+                printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
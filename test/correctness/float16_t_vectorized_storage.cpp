@@ -0,0 +1,78 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <limits>
+
+using namespace Halide;
+
+uint32_t bits_of(float f) {
+    uint32_t b;
+    memcpy(&b, &f, sizeof(f));
+    return b;
+}
+
+bool test(Target target) {
+    const int N = 1024;
+    Image<float> input(N);
+    for (int i = 0; i < N; i++) {
+        // Cover the range of a half, including values that overflow
+        // or become subnormal.
+        float mantissa = (float)rand() / RAND_MAX + 1.0f;
+        int exponent = (rand() % 48) - 30;
+        input(i) = ldexpf(mantissa, exponent) * ((i & 1) ? -1 : 1);
+    }
+    input(0) = 0.0f;
+    input(1) = -0.0f;
+    input(2) = std::numeric_limits<float>::infinity();
+    input(3) = -std::numeric_limits<float>::infinity();
+    input(4) = 65504.0f;
+    input(5) = 65520.0f;
+    // Halfway between two subnormals
+    input(6) = ldexpf(3.0f, -25);
+    input(7) = std::numeric_limits<float>::quiet_NaN();
+
+    Var x("x");
+
+    // Store an intermediate in half precision, but do the arithmetic
+    // in single precision.
+    Func half("half"), doubled("doubled");
+    half(x) = cast<float16_t>(input(x));
+    doubled(x) = Tuple(half(x), cast<float>(half(x)) * 2.0f);
+    half.compute_root().vectorize(x, 16);
+    doubled.vectorize(x, 16);
+
+    Realization r = doubled.realize(N, target);
+    Image<float16_t> h = r[0];
+    Image<float> d = r[1];
+
+    for (int i = 0; i < N; i++) {
+        float16_t correct(input(i));
+        float correct_d = (float)correct * 2.0f;
+        if (correct.is_nan()) {
+            if (!h(i).is_nan() || !std::isnan(d(i))) {
+                printf("Expected nans for input %d\n", i);
+                return false;
+            }
+        } else if (h(i).to_bits() != correct.to_bits() ||
+                   bits_of(d(i)) != bits_of(correct_d)) {
+            printf("%.9g -> 0x%04x, %.9g instead of 0x%04x, %.9g\n",
+                   input(i), h(i).to_bits(), d(i), correct.to_bits(), correct_d);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+
+    // With F16C, if the host has it, and then with the fallback path.
+    if (!test(target) ||
+        !test(target.without_feature(Target::F16C))) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include "Halide.h"
+
+using namespace Halide;
+
+// Override Halide's malloc and free
+
+size_t custom_malloc_size = 0;
+
+void *my_malloc(void *user_context, size_t x) {
+    custom_malloc_size = x;
+    void *orig = malloc(x+32);
+    void *ptr = (void *)((((size_t)orig + 32) >> 5) << 5);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    free(((void**)ptr)[-1]);
+}
+
+bool error_occurred = false;
+void my_error_handler(void *user_context, const char *msg) {
+    printf("Expected: %s\n", msg);
+    error_occurred = true;
+}
+
+int main(int argc, char **argv) {
+    Var x, y;
+
+    {
+        // The footprint of f per scanline of g depends on a Param, so
+        // it can't be folded automatically. Fold it explicitly.
+        Func f, g;
+        Param<int> offset;
+
+        f(x, y) = x * y;
+        g(x, y) = f(x, y) + f(x, y + offset);
+        f.store_root().compute_at(g, y).fold_storage(y, 8);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        offset.set(3);
+        Image<int> im = g.realize(1000, 1000);
+
+        if (custom_malloc_size == 0 || custom_malloc_size > 1000*8*sizeof(int)) {
+            printf("Scratch space allocated was %d instead of %d\n",
+                   (int)custom_malloc_size, (int)(1000*8*sizeof(int)));
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = x * y + x * (y + 3);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+
+        // An offset too large for the fold factor should trip the
+        // runtime assertion.
+        g.set_error_handler(my_error_handler);
+        offset.set(10);
+        g.realize(1000, 1000);
+        if (!error_occurred) {
+            printf("There should have been an error for a fold factor that is too small\n");
+            return -1;
+        }
+    }
+
+    {
+        // The fold factor may also be a Param.
+        custom_malloc_size = 0;
+        Func f, g;
+        Param<int> radius, factor;
+
+        f(x, y) = x + y;
+        g(x, y) = f(x, y - radius) + f(x, y + radius);
+        f.store_root().compute_at(g, y).fold_storage(y, factor);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        radius.set(2);
+        factor.set(5);
+        Image<int> im = g.realize(100, 100);
+
+        if (custom_malloc_size == 0 || custom_malloc_size > 100*5*sizeof(int)) {
+            printf("Scratch space allocated was %d instead of %d\n",
+                   (int)custom_malloc_size, (int)(100*5*sizeof(int)));
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = (x + y - 2) + (x + y + 2);
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Both dimensions of f slide along with the loop over x, so
+        // both can be folded over it.
+        custom_malloc_size = 0;
+        Func f, g;
+        Param<int> step;
+
+        f(x, y) = x * 2 + y;
+        g(x) = f(x, x) + f(x + step, x + step);
+        f.store_root().compute_at(g, x).fold_storage(x, 4).fold_storage(y, 4);
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        step.set(1);
+        Image<int> im = g.realize(1000);
+
+        if (custom_malloc_size != 0) {
+            printf("There should not have been a heap allocation\n");
+            return -1;
+        }
+
+        for (int x = 0; x < im.width(); x++) {
+            int correct = (x * 2 + x) + ((x + 1) * 2 + x + 1);
+            if (im(x) != correct) {
+                printf("im(%d) = %d instead of %d\n", x, im(x), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
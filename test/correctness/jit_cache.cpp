@@ -0,0 +1,80 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+bool check(Image<int> im) {
+    for (int x = 0; x < im.width(); x++) {
+        if (im(x) != x * 2) {
+            printf("im(%d) = %d instead of %d\n", x, im(x), x * 2);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool check_stats(Pipeline p, int hits, int misses, int evictions, int entries) {
+    JITCacheStats s = p.jit_cache_stats();
+    if (s.hits != hits || s.misses != misses ||
+        s.evictions != evictions || s.entries != entries) {
+        printf("Cache stats were %d hits, %d misses, %d evictions, %d entries "
+               "instead of %d, %d, %d, %d\n",
+               s.hits, s.misses, s.evictions, s.entries,
+               hits, misses, evictions, entries);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Var x("x");
+    Func f("f");
+    f(x) = x * 2;
+    f.vectorize(x, 4);
+
+    Target a = get_jit_target_from_environment();
+    Target b = a.with_feature(Target::NoAsserts);
+    Target c = a.with_feature(Target::NoBoundsQuery);
+
+    Pipeline p(f);
+
+    // Switching back and forth between two targets only compiles
+    // each of them once.
+    for (int i = 0; i < 3; i++) {
+        if (!check(p.realize(16, a)) || !check(p.realize(16, b))) {
+            return -1;
+        }
+    }
+    if (!check_stats(p, 4, 2, 0, 2)) {
+        return -1;
+    }
+
+    // With room for just one module, the least recently used one is
+    // dropped.
+    p.set_jit_cache_capacity(1);
+    if (!check_stats(p, 4, 2, 1, 1)) {
+        return -1;
+    }
+    if (!check(p.realize(16, b)) ||
+        !check(p.realize(16, a)) ||
+        !check(p.realize(16, c))) {
+        return -1;
+    }
+    if (!check_stats(p, 5, 4, 3, 1)) {
+        return -1;
+    }
+
+    // Rescheduling empties the cache.
+    p.set_jit_cache_capacity(2);
+    f.vectorize(x, 8);
+    p.invalidate_cache();
+    if (!check(p.realize(16, c))) {
+        return -1;
+    }
+    if (!check_stats(p, 5, 5, 3, 1)) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
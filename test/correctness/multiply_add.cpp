@@ -0,0 +1,85 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <algorithm>
+
+using namespace Halide;
+
+// Check the results of sums of pairs of widening products, which x86
+// lowers to pmaddwd and pmaddubsw, against a scalar reference.
+
+int main(int argc, char **argv) {
+    const int W = 256;
+    Image<uint8_t> u8s(W);
+    Image<int8_t> i8s(W);
+    Image<int16_t> i16s_a(W), i16s_b(W);
+    for (int i = 0; i < W; i++) {
+        u8s(i) = rand() & 0xff;
+        i8s(i) = (rand() & 0xff) - 128;
+        i16s_a(i) = (rand() & 0xffff) - 0x8000;
+        // Keep -32768 * -32768 + -32768 * -32768 from overflowing.
+        i16s_b(i) = (rand() % 0xffff) - 0x7fff;
+    }
+    // Make sure the saturating cases come up, and the largest
+    // products that don't overflow 32 bits.
+    for (int i = 0; i < 8; i++) {
+        u8s(i) = 255;
+        i8s(i) = (i & 4) ? 127 : -128;
+        i16s_a(i) = -32768;
+        i16s_b(i) = (i & 1) ? 32767 : -32767;
+    }
+
+    Var x("x");
+
+    for (int vec : {8, 16, 32}) {
+        // pmaddubsw, with the unsigned factor first in one product
+        // and second in the other.
+        {
+            Func f("f");
+            Expr a = cast<int>(u8s(2*x)), b = cast<int>(i8s(2*x));
+            Expr c = cast<int>(u8s(2*x + 1)), d = cast<int>(i8s(2*x + 1));
+            f(x) = cast<int16_t>(clamp(a * b + d * c, -32768, 32767));
+            f.vectorize(x, vec);
+
+            Image<int16_t> result = f.realize(W/2);
+            for (int i = 0; i < W/2; i++) {
+                int correct = u8s(2*i) * i8s(2*i) + u8s(2*i + 1) * i8s(2*i + 1);
+                correct = std::min(std::max(correct, -32768), 32767);
+                if (result(i) != correct) {
+                    printf("Saturating u8 * i8 multiply-add with vector width %d:\n"
+                           "result(%d) = %d instead of %d\n", vec, i, result(i), correct);
+                    return -1;
+                }
+            }
+        }
+
+        // pmaddwd, as a sum and as a difference.
+        {
+            Func f("f"), g("g");
+            Expr a = cast<int>(i16s_a(2*x)), b = cast<int>(i16s_b(2*x));
+            Expr c = cast<int>(i16s_a(2*x + 1)), d = cast<int>(i16s_b(2*x + 1));
+            f(x) = a * b + c * d;
+            g(x) = a * b - c * d;
+            f.vectorize(x, vec);
+            g.vectorize(x, vec);
+
+            Image<int> f_result = f.realize(W/2);
+            Image<int> g_result = g.realize(W/2);
+            for (int i = 0; i < W/2; i++) {
+                int ab = i16s_a(2*i) * i16s_b(2*i);
+                int cd = i16s_a(2*i + 1) * i16s_b(2*i + 1);
+                int correct_f = ab + cd;
+                int correct_g = ab - cd;
+                if (f_result(i) != correct_f || g_result(i) != correct_g) {
+                    printf("i16 multiply-add with vector width %d:\n"
+                           "f(%d) = %d instead of %d, g(%d) = %d instead of %d\n", vec,
+                           i, f_result(i), correct_f, i, g_result(i), correct_g);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+#ifdef _MSC_VER
+    printf("Skipping test on windows\n");
+    return 0;
+#else
+    // Optimize the llvm module on several threads.
+    setenv("HL_NUM_CODEGEN_THREADS", "4", 1);
+
+    // Several stages computed at root, each with its own parallel
+    // loop, so that there are several loop bodies to split the
+    // module into.
+    Var x("x"), y("y");
+    Func f("f"), g("g"), h("h"), out("out");
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) * 2 + f(x + 1, y);
+    h(x, y) = g(x, y) - g(x, y + 1);
+    out(x, y) = h(x, y) + select(x > 10, f(x, y), g(x, y));
+
+    f.compute_root().parallel(y);
+    g.compute_root().parallel(y).vectorize(x, 4);
+    h.compute_root().parallel(y);
+    out.parallel(y);
+
+    int parts_before = Internal::parallel_optimizer_parts_made();
+    Image<int> result = out.realize(64, 64);
+
+    // Check that the module really was split up, rather than quietly
+    // optimized whole.
+    int parts = Internal::parallel_optimizer_parts_made() - parts_before;
+    if (parts < 2) {
+        printf("The module was optimized in %d parts instead of at least 2\n", parts);
+        return -1;
+    }
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            int fv = x + y;
+            int gv = fv * 2 + (x + 1 + y);
+            int gv_below = (x + y + 1) * 2 + (x + 1 + y + 1);
+            int correct = (gv - gv_below) + (x > 10 ? fv : gv);
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %d instead of %d\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // Ahead-of-time compilation goes the same way.
+    std::vector<Argument> empty_args;
+    parts_before = Internal::parallel_optimizer_parts_made();
+    out.compile_to_object("parallel_codegen.o", empty_args, "parallel_codegen");
+    parts = Internal::parallel_optimizer_parts_made() - parts_before;
+    if (parts < 2) {
+        printf("The object file was optimized in %d parts instead of at least 2\n", parts);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
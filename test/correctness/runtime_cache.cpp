@@ -0,0 +1,105 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#ifndef _MSC_VER
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+using namespace Halide;
+
+#ifndef _MSC_VER
+// Find the runtimes saved in the cache directory.
+std::vector<std::string> cached_runtimes(const char *dir) {
+    std::vector<std::string> result;
+    DIR *d = opendir(dir);
+    if (!d) return result;
+    while (dirent *e = readdir(d)) {
+        if (strncmp(e->d_name, "halide_runtime.", 15) == 0) {
+            result.push_back(std::string(dir) + "/" + e->d_name);
+        }
+    }
+    closedir(d);
+    return result;
+}
+
+// Compile a pipeline, and return whether it used a cached runtime.
+bool compile(const char *name) {
+    Func f(name);
+    Var x, y;
+    f(x, y) = x + y;
+
+    std::vector<Argument> empty_args;
+    int hits = Internal::runtime_cache_hits();
+    f.compile_to_object(std::string("runtime_cache_") + name + ".o", empty_args, name,
+                        get_target_from_environment());
+    return Internal::runtime_cache_hits() > hits;
+}
+#endif
+
+int main(int argc, char **argv) {
+#ifdef _MSC_VER
+    printf("Skipping test on windows\n");
+    return 0;
+#else
+    // A later process uses the runtime saved by an earlier one. This
+    // is the later one.
+    if (argc > 1) {
+        return compile("g") == (atoi(argv[1]) != 0) ? 0 : -1;
+    }
+
+    // Keep the linked runtime in a new directory. Child processes
+    // inherit it.
+    char dir[] = "runtime_cache_XXXXXX";
+    if (!mkdtemp(dir)) {
+        printf("Couldn't make a cache directory\n");
+        return -1;
+    }
+    setenv("HL_RUNTIME_CACHE_DIR", dir, 1);
+
+    // The first compile links the runtime and saves it.
+    if (compile("f")) {
+        printf("The first compile used a cached runtime\n");
+        return -1;
+    }
+    std::vector<std::string> saved = cached_runtimes(dir);
+    if (saved.size() != 1) {
+        printf("%d runtimes were saved to %s instead of 1\n", (int)saved.size(), dir);
+        return -1;
+    }
+
+    // Later ones in this process use the copy in memory.
+    if (!compile("g")) {
+        printf("The second compile didn't use the cached runtime\n");
+        return -1;
+    }
+
+    // Another process loads it from the directory.
+    std::string child = std::string("\"") + argv[0] + "\" ";
+    if (system((child + "1").c_str()) != 0) {
+        printf("Another process didn't use the runtime saved in %s\n", dir);
+        return -1;
+    }
+
+    // A corrupt runtime is relinked and saved again.
+    FILE *file = fopen(saved[0].c_str(), "wb");
+    fputs("not bitcode", file);
+    fclose(file);
+    if (system((child + "0").c_str()) != 0) {
+        printf("Another process used a corrupt runtime\n");
+        return -1;
+    }
+    if (system((child + "1").c_str()) != 0) {
+        printf("The corrupt runtime wasn't replaced\n");
+        return -1;
+    }
+
+    unlink(saved[0].c_str());
+    rmdir(dir);
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
@@ -347,6 +347,21 @@ void check_sse_all() {
         check("pmaddwd", 8, i32(i16_1) * 3 + i32(i16_2) * 4);
     }
 
+    // Widening multiply-adds of adjacent pairs, as in a two-tap filter.
+    for (int w = 2; w <= 4; w++) {
+        check("pmaddwd", 2*w,
+              i32(in_i16(2*x)) * 3 + i32(in_i16(2*x+1)) * -5);
+    }
+
+    if (use_ssse3) {
+        for (int w = 2; w <= 4; w++) {
+            check("pmaddubsw", 4*w,
+                  i16(clamp(i32(u8_1) * i32(i8_1) + i32(u8_2) * i32(i8_2), min_i16, max_i16)));
+            check("pmaddubsw", 4*w,
+                  i16(clamp(i32(i8_1) * 3 + i32(u8_2) * -7, min_i16, max_i16)));
+        }
+    }
+
     // llvm doesn't distinguish between signed and unsigned multiplies
     //check("pmuldq", 4, i64(i32_1) * i64(i32_2));
 
@@ -477,6 +492,13 @@ void check_sse_all() {
         check("vpmulhuw", 16, i16((i32(i16_1) * i32(i16_2))/(256*256)));
         check("vpmulhuw", 16, i16((i32(i16_1) * i32(i16_2))>>16));
 
+        // Vectors that are a multiple of 256 bits should use the
+        // 256-bit forms for each piece.
+        check("vpaddsb", 64, i8(clamp(i16(i8_1) + i16(i8_2), min_i8, max_i8)));
+        check("vpsubusw", 32, u16(max(i32(u16_1) - i32(u16_2), 0)));
+        check("vpmulhw", 32, i16((i32(i16_1) * i32(i16_2)) / (256*256)));
+        check("vpavgb", 64, u8((u16(u8_1) + u16(u8_2) + 1)/2));
+
         check("vpaddq", 8, i64_1 + i64_2);
         check("vpsubq", 8, i64_1 - i64_2);
         check("vpmuludq", 8, u64_1 * u64_2);
@@ -494,7 +516,13 @@ void check_sse_all() {
         check("vpmuludq", 8, u64(u32_1) * u64(u32_2));
         check("vpmulld", 8, i32_1 * i32_2);
 
+        check("vpmaddwd", 16, i32(i16_1) * i32(i16_2) + i32(i16_3) * 7);
+        check("vpmaddubsw", 32, i16(clamp(i32(u8_1) * i32(i8_1) + i32(u8_2) * i32(i8_2), min_i16, max_i16)));
+
         check("vpblendvb", 32, select(u8_1 > 7, u8_1, u8_2));
+        check("vpblendvb", 32, select(u8_1 == 7, u8_1, u8_2));
+        check("vpblendvb", 32, select(u8_1 <= 7, i8_1, i8_2));
+        check("vpblendvb", 64, select(u8_1 != u8_2, u8_1, u8_2));
 
         check("vpmaxsb", 32, max(i8_1, i8_2));
         check("vpminsb", 32, min(i8_1, i8_2));
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <atomic>
+#include "Halide.h"
+
+using namespace Halide;
+
+#ifdef _MSC_VER
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+std::atomic<int> count;
+extern "C" DLLEXPORT int call_counter(int x, int y) {
+    count++;
+    return x + y * 10;
+}
+HalideExtern_2(int, call_counter, int, int);
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    // Slide f down g, where the loop over the rows of g is parallel.
+    {
+        count = 0;
+        Func f("f"), g("g");
+        f(x, y) = call_counter(x, y);
+        g(x, y) = f(x, y - 1) + f(x, y) + f(x, y + 1);
+
+        f.store_root().compute_at(g, y);
+        g.parallel(y);
+
+        Image<int> im = g.realize(10, 100);
+
+        for (int j = 0; j < im.height(); j++) {
+            for (int i = 0; i < im.width(); i++) {
+                int correct = 3 * (i + j * 10);
+                if (im(i, j) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", i, j, im(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+
+        // The 100 rows are divided into 7 strips of at most 16
+        // rows. Each strip computes two extra rows of f to warm up.
+        int correct = (100 + 7 * 2) * 10;
+        if (count != correct) {
+            printf("f was called %d times instead of %d times\n", (int)count, correct);
+            return -1;
+        }
+    }
+
+    // If the region of f doesn't move along the parallel loop, each
+    // iteration gets its own copy of f.
+    {
+        count = 0;
+        Func f("f"), g("g");
+        f(x, y) = call_counter(x, y);
+        g(x, y) = f(x, 0) + y;
+
+        f.store_root().compute_at(g, y);
+        g.parallel(y);
+
+        Image<int> im = g.realize(10, 20);
+
+        for (int j = 0; j < im.height(); j++) {
+            for (int i = 0; i < im.width(); i++) {
+                int correct = i + j;
+                if (im(i, j) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", i, j, im(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+// Count the stores marked as non-temporal, and the fences, in a
+// lowered statement.
+class CountNontemporal : public Internal::IRVisitor {
+    using Internal::IRVisitor::visit;
+
+    void visit(const Internal::Call *op) {
+        if (op->name == Internal::Call::nontemporal) {
+            stores++;
+        } else if (op->name == Internal::Call::store_fence) {
+            fences++;
+        }
+        Internal::IRVisitor::visit(op);
+    }
+
+public:
+    int stores, fences;
+    CountNontemporal() : stores(0), fences(0) {}
+};
+
+// Loop partitioning may split a vectorized loop in two, so this only
+// checks that some stores are marked, but counts the fences exactly.
+class CheckNontemporal : public Internal::IRMutator {
+public:
+    int expected_fences;
+    CheckNontemporal(int f) : expected_fences(f) {}
+
+    using Internal::IRMutator::mutate;
+
+    Internal::Stmt mutate(Internal::Stmt s) {
+        CountNontemporal c;
+        s.accept(&c);
+        if (c.stores == 0) {
+            printf("Found no non-temporal stores\n");
+            exit(-1);
+        }
+        if (c.fences != expected_fences) {
+            printf("Found %d store fences instead of %d\n", c.fences, expected_fences);
+            exit(-1);
+        }
+        return s;
+    }
+};
+
+int main(int argc, char **argv) {
+    const int W = 1024, H = 64;
+    Image<uint8_t> input(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            input(x, y) = (uint8_t)rand();
+        }
+    }
+
+    Var x("x"), y("y");
+
+    // A planar-to-float conversion that is written once and never
+    // read again.
+    Func converted("converted");
+    converted(x, y) = cast<float>(input(x, y)) / 255.0f;
+    converted.vectorize(x, 8).parallel(y).store_nontemporal();
+
+    // One fence at the end of each parallel iteration, and one after
+    // the produce.
+    CheckNontemporal checker(2);
+    converted.add_custom_lowering_pass(&checker, NULL);
+
+    Image<float> result = converted.realize(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            float correct = input(x, y) / 255.0f;
+            if (result(x, y) != correct) {
+                printf("result(%d, %d) = %f instead of %f\n", x, y, result(x, y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // The vectorized pure step of hist is marked, but the scalar
+    // stores of its update aren't. The fence goes after the update,
+    // before out consumes hist.
+    Func hist("hist"), out("out");
+    hist(x) = 0;
+    RDom r(0, W);
+    hist(input(r, 0)) += 1;
+    hist.compute_root().vectorize(x, 8).store_nontemporal();
+    out(x) = hist(x) * 2;
+    out.vectorize(x, 4);
+
+    CheckNontemporal hist_checker(1);
+    out.add_custom_lowering_pass(&hist_checker, NULL);
+
+    Image<int> counts = out.realize(256);
+    int correct_counts[256] = {0};
+    for (int i = 0; i < W; i++) {
+        correct_counts[input(i, 0)]++;
+    }
+    for (int i = 0; i < 256; i++) {
+        if (counts(i) != correct_counts[i] * 2) {
+            printf("counts(%d) = %d instead of %d\n", i, counts(i), correct_counts[i] * 2);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
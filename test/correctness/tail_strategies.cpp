@@ -0,0 +1,79 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Check the region of the input required when the stage reading it is
+// split with the given tail strategy.
+void check_input_bounds(TailStrategy tail, int extent) {
+    ImageParam input(Int(32), 1);
+    Var x("x"), xo("xo"), xi("xi");
+    Func g("g"), h("h");
+    g(x) = input(x);
+    h(x) = g(x);
+    g.compute_root().split(x, xo, xi, 8, tail);
+
+    Buffer buf;
+    input.set(buf);
+    h.infer_input_bounds(13);
+    Image<int> im = input.get();
+
+    if (im.min(0) != 0 || im.extent(0) != extent) {
+        printf("Inferred size was [%d, %d] instead of [%d, %d]\n",
+               im.min(0), im.extent(0), 0, extent);
+        exit(-1);
+    }
+}
+
+int main(int argc, char **argv) {
+    // Rounding up computes g over [0, 15], so more of the input is
+    // required. The other strategies compute exactly [0, 12].
+    check_input_bounds(TailStrategy::RoundUp, 16);
+    check_input_bounds(TailStrategy::GuardWithIf, 13);
+    check_input_bounds(TailStrategy::ShiftInwards, 13);
+
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+
+    // Tile a pure definition and its update with different strategies.
+    {
+        Func f("f"), out("out");
+        f(x, y) = x + y * 100;
+        f(x, y) += 1;
+        out(x, y) = f(x, y);
+
+        f.compute_root().tile(x, y, xi, yi, 4, 4, TailStrategy::ShiftInwards);
+        f.update().tile(x, y, xi, yi, 4, 4, TailStrategy::RoundUp);
+
+        Image<int> result = out.realize(10, 7);
+        for (int j = 0; j < result.height(); j++) {
+            for (int i = 0; i < result.width(); i++) {
+                int correct = i + j * 100 + 1;
+                if (result(i, j) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // Unroll an RVar that the factor doesn't divide.
+    {
+        Func h("h");
+        RDom r(0, 10);
+        h(x) = 0;
+        h(r) = r * 2;
+        h.update().unroll(r.x, 4, TailStrategy::GuardWithIf);
+
+        Image<int> result = h.realize(12);
+        for (int i = 0; i < result.width(); i++) {
+            int correct = i < 10 ? i * 2 : 0;
+            if (result(i) != correct) {
+                printf("result(%d) = %d instead of %d\n", i, result(i), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// Transpose square tiles in registers, vectorizing either the loads
+// or the stores of the transposed tile.
+template<typename T>
+bool test(int size, bool vectorize_x) {
+    const int W = 64, H = 32;
+    Image<T> input(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            input(x, y) = (T)(rand());
+        }
+    }
+
+    Func block("block"), block_transpose("block_transpose"), output("output");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+
+    block(x, y) = input(x, y);
+    block_transpose(x, y) = block(y, x);
+    output(x, y) = block_transpose(x, y);
+
+    output.tile(x, y, xi, yi, size, size).vectorize(xi).unroll(yi);
+    block.compute_at(output, x).vectorize(x).unroll(y);
+    if (vectorize_x) {
+        block_transpose.compute_at(output, x).vectorize(x).unroll(y);
+    } else {
+        block_transpose.compute_at(output, x).vectorize(y).unroll(x);
+    }
+
+    Image<T> result = output.realize(H, W);
+    for (int y = 0; y < W; y++) {
+        for (int x = 0; x < H; x++) {
+            if (result(x, y) != input(y, x)) {
+                printf("%d-bit %dx%d transpose: result(%d, %d) = %d instead of %d\n",
+                       (int)sizeof(T) * 8, size, size, x, y,
+                       (int)result(x, y), (int)input(y, x));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Interleave planes into a buffer with a constant number of channels.
+bool test_interleave(int channels) {
+    const int W = 256;
+    Image<uint8_t> input(W, channels);
+    for (int c = 0; c < channels; c++) {
+        for (int x = 0; x < W; x++) {
+            input(x, c) = (uint8_t)rand();
+        }
+    }
+
+    Func planar("planar"), interleaved("interleaved");
+    Var x("x"), c("c");
+    planar(x, c) = input(x, c) + 1;
+    interleaved(c, x) = planar(x, c);
+    interleaved.bound(c, 0, channels).unroll(c).vectorize(x, 16);
+
+    Image<uint8_t> result = interleaved.realize(channels, W);
+    for (int x = 0; x < W; x++) {
+        for (int c = 0; c < channels; c++) {
+            if (result(c, x) != (uint8_t)(input(x, c) + 1)) {
+                printf("%d channel interleave: result(%d, %d) = %d instead of %d\n",
+                       channels, c, x, result(c, x), input(x, c) + 1);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (int size = 4; size <= 8; size *= 2) {
+        for (int vectorize_x = 0; vectorize_x < 2; vectorize_x++) {
+            if (!test<uint8_t>(size, vectorize_x) ||
+                !test<uint16_t>(size, vectorize_x) ||
+                !test<uint32_t>(size, vectorize_x)) {
+                return -1;
+            }
+        }
+    }
+
+    for (int channels = 2; channels <= 4; channels++) {
+        if (!test_interleave(channels)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
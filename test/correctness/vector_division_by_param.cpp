@@ -0,0 +1,87 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <limits>
+
+using namespace Halide;
+
+// Halide's division rounds according to the sign of the divisor, so
+// that the remainder is always non-negative.
+template<typename T>
+T correct_div(T a, T b) {
+    int64_t q = (int64_t)a / (int64_t)b;
+    int64_t r = (int64_t)a - q * (int64_t)b;
+    if (r < 0) {
+        q += (b < 0) ? 1 : -1;
+    }
+    return (T)q;
+}
+
+template<typename T>
+T correct_mod(T a, T b) {
+    return (T)((int64_t)a - (int64_t)correct_div(a, b) * (int64_t)b);
+}
+
+template<typename T>
+bool test(int vector_width) {
+    const int W = 256, H = 4;
+    Image<T> input(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            input(x, y) = (T)rand();
+        }
+    }
+    // Include the extremes of the type.
+    input(0, 0) = std::numeric_limits<T>::min();
+    input(1, 0) = std::numeric_limits<T>::max();
+    input(2, 0) = 0;
+
+    Var x("x"), y("y");
+    Param<T> p;
+
+    // The divisor doesn't vary within the loops over x or y, so the
+    // division is done with multiplies and shifts.
+    Func f("f");
+    f(x, y) = Tuple(input(x, y) / p, input(x, y) % p);
+    f.vectorize(x, vector_width);
+
+    T divisors[] = {1, 2, 3, 7, 10, 100, 127, std::numeric_limits<T>::max(), (T)-1, (T)-3, (T)-100};
+    for (T d : divisors) {
+        if (d == (T)-1 && std::numeric_limits<T>::is_signed) {
+            // Skip division of the minimum value by -1, which overflows.
+            continue;
+        }
+        p.set(d);
+        Realization r = f.realize(W, H);
+        Image<T> div = r[0], mod = r[1];
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                T a = input(x, y);
+                if (div(x, y) != correct_div(a, d) ||
+                    mod(x, y) != correct_mod(a, d)) {
+                    printf("%lld / %lld = %lld, %lld %% %lld = %lld instead of %lld, %lld\n",
+                           (long long)a, (long long)d, (long long)div(x, y),
+                           (long long)a, (long long)d, (long long)mod(x, y),
+                           (long long)correct_div(a, d), (long long)correct_mod(a, d));
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!test<uint8_t>(16) ||
+        !test<int8_t>(16) ||
+        !test<uint16_t>(8) ||
+        !test<int16_t>(8) ||
+        !test<uint32_t>(4) ||
+        !test<int32_t>(4) ||
+        !test<int32_t>(8)) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+// Count the vector loads and stores done under a vector condition
+// (i.e. predicated), and the other stores to one func, in a lowered
+// statement.
+class CountPredicated : public Internal::IRVisitor {
+    using Internal::IRVisitor::visit;
+
+    std::string func;
+    bool in_predicate;
+
+    void visit(const Internal::IfThenElse *op) {
+        op->condition.accept(this);
+        bool old_in_predicate = in_predicate;
+        if (op->condition.type().is_vector()) {
+            predicated_ifs++;
+            in_predicate = true;
+        }
+        op->then_case.accept(this);
+        in_predicate = old_in_predicate;
+        if (op->else_case.defined()) {
+            op->else_case.accept(this);
+        }
+    }
+
+    void visit(const Internal::Load *op) {
+        if (in_predicate && op->type.is_vector()) {
+            loads++;
+        }
+        Internal::IRVisitor::visit(op);
+    }
+
+    void visit(const Internal::Store *op) {
+        if (op->name == func) {
+            if (op->value.type().is_scalar()) {
+                scalar_stores++;
+            } else if (in_predicate) {
+                stores++;
+            } else {
+                unpredicated_stores++;
+            }
+        }
+        Internal::IRVisitor::visit(op);
+    }
+
+public:
+    int predicated_ifs, loads, stores, unpredicated_stores, scalar_stores;
+    CountPredicated(const std::string &f) :
+        func(f), in_predicate(false),
+        predicated_ifs(0), loads(0), stores(0), unpredicated_stores(0), scalar_stores(0) {}
+};
+
+// Check that the tail of a func vectorized with
+// TailStrategy::GuardWithIf is still done with vector loads and
+// stores under a vector predicate, rather than being scalarized, and
+// that the steady state was peeled off and isn't predicated. The steps
+// of the func that aren't vectorized make some scalar stores, so those
+// are counted exactly.
+class CheckPredicated : public Internal::IRMutator {
+public:
+    std::string func;
+    bool expect_loads;
+    int expected_scalar_stores;
+    CheckPredicated(const std::string &f, bool l, int s) :
+        func(f), expect_loads(l), expected_scalar_stores(s) {}
+
+    using Internal::IRMutator::mutate;
+
+    Internal::Stmt mutate(Internal::Stmt s) {
+        CountPredicated c(func);
+        s.accept(&c);
+        if (c.predicated_ifs == 0) {
+            printf("Found no ifs on a vector condition for %s\n", func.c_str());
+            exit(-1);
+        }
+        if (c.stores == 0) {
+            printf("Found no predicated vector stores to %s\n", func.c_str());
+            exit(-1);
+        }
+        if (c.unpredicated_stores == 0) {
+            printf("Found no unpredicated vector stores to %s\n", func.c_str());
+            exit(-1);
+        }
+        if (expect_loads && c.loads == 0) {
+            printf("Found no predicated vector loads for %s\n", func.c_str());
+            exit(-1);
+        }
+        if (c.scalar_stores != expected_scalar_stores) {
+            printf("Found %d scalar stores to %s instead of %d\n",
+                   c.scalar_stores, func.c_str(), expected_scalar_stores);
+            exit(-1);
+        }
+        return s;
+    }
+};
+
+int main(int argc, char **argv) {
+    Var x("x"), y("y");
+
+    // Outputs narrower than one vector, and outputs that aren't a
+    // multiple of the vector width. Shifting the last vector inwards
+    // can't handle the former, so the tail must be predicated.
+    for (int w = 1; w < 20; w += 3) {
+        Image<int> input(w, 4);
+        for (int j = 0; j < input.height(); j++) {
+            for (int i = 0; i < input.width(); i++) {
+                input(i, j) = i * 10 + j;
+            }
+        }
+
+        Func f("f");
+        f(x, y) = input(x, y) * 2 + 1;
+        f.vectorize(x, 8, TailStrategy::GuardWithIf);
+
+        CheckPredicated checker("f", true, 0);
+        f.add_custom_lowering_pass(&checker, NULL);
+
+        Image<int> out = f.realize(w, 4);
+        for (int j = 0; j < out.height(); j++) {
+            for (int i = 0; i < out.width(); i++) {
+                int correct = input(i, j) * 2 + 1;
+                if (out(i, j) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", i, j, out(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // An update stage. Rounding up would compute beyond the end of
+    // the output.
+    {
+        Func g("g");
+        g(x) = x;
+        g(x) += 3;
+        g.update().vectorize(x, 8, TailStrategy::GuardWithIf);
+
+        // The pure step isn't vectorized.
+        CheckPredicated checker("g", true, 1);
+        g.add_custom_lowering_pass(&checker, NULL);
+
+        Image<int> out = g.realize(13);
+        for (int i = 0; i < out.width(); i++) {
+            if (out(i) != i + 3) {
+                printf("out(%d) = %d instead of %d\n", i, out(i), i + 3);
+                return -1;
+            }
+        }
+    }
+
+    // A producer computed inside the tail only needs to be computed
+    // over the region actually used.
+    {
+        Func p("p"), c("c");
+        p(x) = x * x;
+        c(x) = p(x) + 1;
+        c.vectorize(x, 8, TailStrategy::GuardWithIf);
+        p.compute_at(c, x);
+
+        CheckPredicated checker("c", true, 0);
+        c.add_custom_lowering_pass(&checker, NULL);
+
+        Image<int> out = c.realize(21);
+        for (int i = 0; i < out.width(); i++) {
+            if (out(i) != i * i + 1) {
+                printf("out(%d) = %d instead of %d\n", i, out(i), i * i + 1);
+                return -1;
+            }
+        }
+    }
+
+    // Splits of RVars don't need to divide the extent when guarded.
+    {
+        Func h("h");
+        RDom r(0, 11);
+        h(x) = 0;
+        h(r) = r * 3;
+        h.update().vectorize(r.x, 4, TailStrategy::GuardWithIf);
+
+        // The update doesn't load anything, and the pure step isn't
+        // vectorized.
+        CheckPredicated checker("h", false, 1);
+        h.add_custom_lowering_pass(&checker, NULL);
+
+        Image<int> out = h.realize(16);
+        for (int i = 0; i < out.width(); i++) {
+            int correct = i < 11 ? i * 3 : 0;
+            if (out(i) != correct) {
+                printf("out(%d) = %d instead of %d\n", i, out(i), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
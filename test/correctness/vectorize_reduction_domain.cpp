@@ -0,0 +1,112 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <algorithm>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Var x("x");
+
+    const int N = 37;
+    Image<int> input(N, 4);
+    Image<uint8_t> bytes(64, 4);
+    Image<int16_t> a(64), b(64, 4);
+    for (int y = 0; y < 4; y++) {
+        for (int i = 0; i < N; i++) {
+            input(i, y) = (rand() % 200) - 100;
+        }
+        for (int i = 0; i < 64; i++) {
+            bytes(i, y) = rand() & 0xff;
+            b(i, y) = (rand() & 0xffff) - 0x8000;
+        }
+    }
+    for (int i = 0; i < 64; i++) {
+        a(i) = (rand() & 0xffff) - 0x8000;
+    }
+
+    // Sum, product, min, and max across a reduction domain that isn't
+    // a multiple of the vector width. Splits of RVars must be exact,
+    // so the tail has to be guarded.
+    {
+        RDom r(0, N);
+        Func s("s"), p("p"), mn("mn"), mx("mx");
+        s(x) = 0;
+        s(x) += input(r, x);
+        p(x) = 1;
+        p(x) *= (input(r, x) & 1) + 1;
+        mn(x) = 1000;
+        mn(x) = min(mn(x), input(r, x));
+        mx(x) = -1000;
+        mx(x) = max(input(r, x), mx(x));
+
+        s.update().vectorize(r.x, 8, TailStrategy::GuardWithIf);
+        p.update().vectorize(r.x, 4, TailStrategy::GuardWithIf);
+        mn.update().vectorize(r.x, 8, TailStrategy::GuardWithIf);
+        mx.update().vectorize(r.x, 16, TailStrategy::GuardWithIf);
+
+        Realization result = Pipeline({s, p, mn, mx}).realize(4);
+        Image<int> s_im = result[0], p_im = result[1], mn_im = result[2], mx_im = result[3];
+
+        for (int y = 0; y < 4; y++) {
+            int correct_s = 0, correct_p = 1, correct_mn = 1000, correct_mx = -1000;
+            for (int i = 0; i < N; i++) {
+                correct_s += input(i, y);
+                correct_p *= (input(i, y) & 1) + 1;
+                correct_mn = std::min(correct_mn, input(i, y));
+                correct_mx = std::max(correct_mx, input(i, y));
+            }
+            if (s_im(y) != correct_s || p_im(y) != correct_p ||
+                mn_im(y) != correct_mn || mx_im(y) != correct_mx) {
+                printf("Reductions of row %d were %d %d %d %d instead of %d %d %d %d\n", y,
+                       s_im(y), p_im(y), mn_im(y), mx_im(y),
+                       correct_s, correct_p, correct_mn, correct_mx);
+                return -1;
+            }
+        }
+    }
+
+    // A sum of widened bytes.
+    {
+        RDom r(0, 64);
+        Func f("f");
+        f(x) = cast<uint16_t>(0);
+        f(x) += cast<uint16_t>(bytes(r, x));
+        f.update().vectorize(r.x, 32);
+
+        Image<uint16_t> result = f.realize(4);
+        for (int y = 0; y < 4; y++) {
+            uint16_t correct = 0;
+            for (int i = 0; i < 64; i++) {
+                correct += bytes(i, y);
+            }
+            if (result(y) != correct) {
+                printf("f(%d) = %d instead of %d\n", y, result(y), correct);
+                return -1;
+            }
+        }
+    }
+
+    // A dot product of 16-bit vectors.
+    {
+        RDom r(0, 64);
+        Func f("f");
+        f(x) = 0;
+        f(x) += cast<int>(a(r)) * b(r, x);
+        f.update().vectorize(r.x, 16);
+
+        Image<int> result = f.realize(4);
+        for (int y = 0; y < 4; y++) {
+            int correct = 0;
+            for (int i = 0; i < 64; i++) {
+                correct += a(i) * b(i, y);
+            }
+            if (result(y) != correct) {
+                printf("f(%d) = %d instead of %d\n", y, result(y), correct);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
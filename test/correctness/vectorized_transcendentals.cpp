@@ -0,0 +1,142 @@
+#include "Halide.h"
+#include <math.h>
+#include <cmath>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+using namespace Halide;
+
+// The distance between two floats in units in the last place.
+int64_t ulps(float a, float b) {
+    int32_t ia, ib;
+    memcpy(&ia, &a, sizeof(a));
+    memcpy(&ib, &b, sizeof(b));
+    if (ia < 0) ia = INT32_MIN - ia;
+    if (ib < 0) ib = INT32_MIN - ib;
+    return ia > ib ? (int64_t)ia - ib : (int64_t)ib - ia;
+}
+
+int64_t ulps(double a, double b) {
+    int64_t ia, ib;
+    memcpy(&ia, &a, sizeof(a));
+    memcpy(&ib, &b, sizeof(b));
+    if (ia < 0) ia = INT64_MIN - ia;
+    if (ib < 0) ib = INT64_MIN - ib;
+    uint64_t d = ia > ib ? (uint64_t)ia - (uint64_t)ib : (uint64_t)ib - (uint64_t)ia;
+    return d > INT64_MAX ? INT64_MAX : (int64_t)d;
+}
+
+// Check a vectorized unary function against the system math
+// library. Results that are within abs_tol of the right answer are
+// accepted regardless of the ulp error, to allow for the loss of
+// relative precision near the roots of sin and cos.
+template<typename T>
+bool check(const char *name, Func f, Image<T> in, T (*ref)(T), int max_ulps, T abs_tol) {
+    Image<T> out = f.realize(in.width());
+    for (int i = 0; i < in.width(); i++) {
+        T correct = ref(in(i));
+        T actual = out(i);
+        if (ulps(actual, correct) > max_ulps && fabs(actual - correct) > abs_tol) {
+            printf("%s(%.17g) = %.17g instead of %.17g (%lld ulps)\n",
+                   name, (double)in(i), (double)actual, (double)correct,
+                   (long long)ulps(actual, correct));
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool test(int vector_width) {
+    const int N = 4096;
+    Image<T> angles(N), slopes(N), positive(N), exponents(N), ys(N), xs(N), bases(N);
+    for (int i = 0; i < N; i++) {
+        T u = (T)rand() / RAND_MAX;
+        angles(i) = (u - 0.5f) * 200;
+        slopes(i) = (u - 0.5f) * 100 * ((i & 1) ? 1 : 0.01f);
+        positive(i) = (T)pow((T)10, (u - 0.5f) * 60);
+        bases(i) = (1 - u) * 10;
+        exponents(i) = (u - 0.5f) * 160;
+        ys(i) = (T)rand() / RAND_MAX - 0.5f;
+        xs(i) = (T)rand() / RAND_MAX - 0.5f;
+    }
+    bool f64 = sizeof(T) == 8;
+    T tiny = f64 ? 1e-15 : 1e-7;
+
+    Var x("x");
+
+    Func f_sin, f_cos, f_atan, f_exp, f_log, f_atan2, f_pow;
+    f_sin(x) = sin(angles(x));
+    f_cos(x) = cos(angles(x));
+    f_atan(x) = atan(slopes(x));
+    f_exp(x) = exp(exponents(x));
+    f_log(x) = log(positive(x));
+    f_atan2(x) = atan2(ys(x), xs(x));
+    f_pow(x) = pow(bases(x), ys(x) * 8);
+
+    Func funcs[] = {f_sin, f_cos, f_atan, f_exp, f_log, f_atan2, f_pow};
+    for (Func f : funcs) {
+        f.vectorize(x, vector_width);
+    }
+
+    if (!check<T>("sin", f_sin, angles, std::sin, 2, tiny) ||
+        !check<T>("cos", f_cos, angles, std::cos, 2, tiny) ||
+        !check<T>("atan", f_atan, slopes, std::atan, 3, 0) ||
+        !check<T>("exp", f_exp, exponents, std::exp, 2, 0) ||
+        !check<T>("log", f_log, positive, std::log, 2, 0)) {
+        return false;
+    }
+
+    Image<T> atan2_result = f_atan2.realize(N);
+    Image<T> pow_result = f_pow.realize(N);
+    for (int i = 0; i < N; i++) {
+        T correct = std::atan2(ys(i), xs(i));
+        if (ulps(atan2_result(i), correct) > 4) {
+            printf("atan2(%.17g, %.17g) = %.17g instead of %.17g\n",
+                   (double)ys(i), (double)xs(i), (double)atan2_result(i), (double)correct);
+            return false;
+        }
+        // The error in pow grows with the magnitude of the log of
+        // the result.
+        correct = std::pow(bases(i), ys(i) * 8);
+        if (ulps(pow_result(i), correct) > 64) {
+            printf("pow(%.17g, %.17g) = %.17g instead of %.17g\n",
+                   (double)bases(i), (double)(ys(i) * 8),
+                   (double)pow_result(i), (double)correct);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!test<float>(8) || !test<double>(4)) {
+        return -1;
+    }
+
+    // The fast variants have a bounded absolute error.
+    const int N = 4096;
+    Image<float> angles(N);
+    for (int i = 0; i < N; i++) {
+        angles(i) = ((float)rand() / RAND_MAX - 0.5f) * 200;
+    }
+    Var x("x");
+    Func f;
+    f(x) = Tuple(fast_sin(angles(x)), fast_cos(angles(x)));
+    f.vectorize(x, 8);
+    Realization r = f.realize(N);
+    Image<float> s = r[0], c = r[1];
+    for (int i = 0; i < N; i++) {
+        if (fabs(s(i) - sinf(angles(i))) > 2e-5f ||
+            fabs(c(i) - cosf(angles(i))) > 2e-5f) {
+            printf("fast_sin/fast_cos(%f) = %f, %f instead of %f, %f\n",
+                   angles(i), s(i), c(i), sinf(angles(i)), cosf(angles(i)));
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) + f(x, 100 - y);
+
+    // The region of f used moves in both directions as y increases,
+    // so its storage can't be folded over the loop over y.
+    f.store_root().compute_at(g, y).fold_storage(y, 2);
+
+    g.realize(100, 100);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
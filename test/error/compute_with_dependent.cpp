@@ -0,0 +1,21 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+
+    f(x, y) = x + y;
+    g(x, y) = f(x, y) * 2;
+
+    // g uses f, so their loop nests can't be fused.
+    f.compute_root();
+    g.compute_with(f, y);
+
+    g.realize(10, 10);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
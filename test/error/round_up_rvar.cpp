@@ -0,0 +1,22 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f");
+    Var x("x");
+    RDom r(0, 10);
+    RVar ro("ro"), ri("ri");
+    f(x) = 0;
+    f(r) += 1;
+
+    // Rounding up the extent of an RVar would add extra iterations of
+    // the update, which changes its meaning.
+    f.update().split(r.x, ro, ri, 4, TailStrategy::RoundUp);
+
+    f.realize(10);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
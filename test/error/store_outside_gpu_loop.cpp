@@ -0,0 +1,25 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f, g;
+    Var x, y;
+
+    g(x, y) = x + y;
+    f(x, y) = g(x, y) + g(x, y + 1);
+
+    // Stores outside parallel loops are only given to each iteration
+    // on the host. The blocks of a gpu kernel would share g.
+    f.gpu_blocks(y);
+    g.store_root().compute_at(f, Var::gpu_blocks());
+
+    Target t = get_host_target().with_feature(Target::CUDA);
+    f.compile_to_lowered_stmt("store_outside_gpu_loop.stmt", {}, Text, t);
+
+    // We shouldn't reach here, because there should have been a compile error.
+    printf("There should have been an error\n");
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f");
+    Var x("x");
+    RDom r(0, 16);
+
+    f(x) = x;
+
+    // Every lane would store to a different site that depends on the
+    // reduction variable, so vectorizing it isn't safe.
+    f(r / 2) = f(r / 2) + r;
+    f.update().vectorize(r.x, 8);
+
+    f.realize(8);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Func f("f");
+    Var x("x");
+    RDom r(0, 16, 0, 4);
+
+    f(x) = x;
+
+    // The update is associative, but its value doesn't depend on the
+    // vectorized reduction variable, so the vectorized loop would only
+    // add it once per vector instead of once per lane.
+    f(x) += r.y;
+    f.update().vectorize(r.x, 8);
+
+    f.realize(8);
+
+    printf("I should not have reached here\n");
+    return 0;
+}
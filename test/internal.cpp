@@ -6,6 +6,7 @@
 #include "Simplify.h"
 #include "Bounds.h"
 #include "IRMatch.h"
+#include "IRRewrite.h"
 #include "Deinterleave.h"
 #include "ModulusRemainder.h"
 #include "OneToOne.h"
@@ -22,6 +23,7 @@ int main(int argc, const char **argv) {
     ir_equality_test();
     bounds_test();
     expr_match_test();
+    rewrite_rules_test();
     deinterleave_vector_test();
     modulus_remainder_test();
     is_one_to_one_test();
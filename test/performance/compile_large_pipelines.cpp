@@ -0,0 +1,129 @@
+#include "Halide.h"
+#include <cstdio>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Synthetic pipelines that are large in different ways, for measuring
+// how long Halide takes to compile things. Run with HL_COMPILE_STATS
+// set to also get the time of each phase, as "make compile_benchmarks"
+// does. The peak memory use in those stats is for the whole process,
+// so pass the name of one pipeline to compile just that one.
+
+Var x("x"), y("y"), xi("xi"), yi("yi");
+
+// A long chain of small stencils, with a mix of schedules.
+Func stencil_chain(ImageParam input, int num_stages) {
+    std::vector<Func> stages;
+    Func first("chain_0");
+    first(x, y) = input(x, y);
+    stages.push_back(first);
+    for (int i = 1; i < num_stages; i++) {
+        Func prev = stages.back();
+        Func f("chain_" + std::to_string(i));
+        f(x, y) = (prev(x - 1, y) + prev(x, y) * 2 + prev(x + 1, y) + prev(x, y - 1) + prev(x, y + 1)) / 6;
+        if (i % 4 == 0) {
+            f.compute_root().tile(x, y, xi, yi, 32, 8).vectorize(xi, 8).parallel(y);
+        }
+        stages.push_back(f);
+    }
+    Func output = stages.back();
+    output.tile(x, y, xi, yi, 64, 16).vectorize(xi, 8).parallel(y);
+    // Compute some of the rest within tiles of the next stage that's
+    // computed at root, and inline the others.
+    for (int i = 1; i < num_stages - 1; i++) {
+        if (i % 4 == 2) {
+            Func consumer = (i + 2 < num_stages - 1) ? stages[i + 2] : output;
+            stages[i].compute_at(consumer, x).vectorize(x, 8);
+        }
+    }
+    return output;
+}
+
+// A wide pipeline, in which each stage combines two of the stages
+// before it, like a pyramid.
+Func wide_dag(ImageParam input, int width, int depth) {
+    std::vector<Func> level;
+    for (int i = 0; i < width; i++) {
+        Func f("wide_0_" + std::to_string(i));
+        f(x, y) = input(x + i, y) * (i + 1);
+        level.push_back(f);
+    }
+    for (int d = 1; d < depth; d++) {
+        std::vector<Func> next;
+        for (size_t i = 0; i < level.size(); i++) {
+            Func f("wide_" + std::to_string(d) + "_" + std::to_string(i));
+            f(x, y) = max(level[i](x, y), level[(i + 1) % level.size()](x, y + 1)) - d;
+            f.compute_root().vectorize(x, 8);
+            next.push_back(f);
+        }
+        level.swap(next);
+    }
+    Func output("wide_output");
+    Expr e = 0.0f;
+    for (size_t i = 0; i < level.size(); i++) {
+        e += level[i](x, y);
+    }
+    output(x, y) = e;
+    output.vectorize(x, 8).parallel(y);
+    return output;
+}
+
+// One stage with a very large expression in it.
+Func large_expression(ImageParam input, int size) {
+    Func f("large_expr_input");
+    f(x, y) = input(x, y);
+    Expr e = f(x, y);
+    for (int i = 0; i < size; i++) {
+        Expr v = f(x + (i % 7) - 3, y + (i % 5) - 2);
+        e = select(v > e, e * 0.5f + v, e - v * (i % 3));
+    }
+    Func output("large_expr");
+    output(x, y) = e;
+    output.vectorize(x, 8).parallel(y);
+    return output;
+}
+
+// A stage with many update definitions.
+Func many_updates(ImageParam input, int num_updates) {
+    Func output("many_updates");
+    output(x, y) = input(x, y);
+    for (int i = 0; i < num_updates; i++) {
+        output(x, y) = output(x, y) * 0.9f + input(x + i % 5, y) * 0.1f;
+        output.update(i).vectorize(x, 8);
+    }
+    output.vectorize(x, 8).parallel(y);
+    return output;
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 2);
+    std::vector<Argument> args;
+    args.push_back(input);
+
+    std::vector<std::pair<std::string, Func>> pipelines;
+    pipelines.push_back(std::make_pair("stencil_chain", stencil_chain(input, 200)));
+    pipelines.push_back(std::make_pair("wide_dag", wide_dag(input, 32, 6)));
+    pipelines.push_back(std::make_pair("large_expression", large_expression(input, 400)));
+    pipelines.push_back(std::make_pair("many_updates", many_updates(input, 100)));
+
+    bool found = false;
+    for (size_t i = 0; i < pipelines.size(); i++) {
+        const std::string &name = pipelines[i].first;
+        if (argc > 1 && name != argv[1]) continue;
+        found = true;
+        Func f = pipelines[i].second;
+        double time = benchmark(1, 1, [&]() {
+            f.compile_to_object(name + ".o", args, name);
+        });
+        printf("Compiling %s took %f s\n", name.c_str(), time);
+    }
+
+    if (!found) {
+        printf("No pipeline named %s\n", argv[1]);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "Halide.h"
+#include <cstdio>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Compile the function with and without avx2, check both agree, and
+// report how long each takes. Gathers aren't faster than scalar loads
+// on every avx2 machine (e.g. Haswell), so only wrong results fail.
+template<typename T>
+bool compare(Func f, const char *name) {
+    Target with_gather = get_jit_target_from_environment();
+    Target without_gather = with_gather.without_feature(Target::AVX2);
+
+    Image<T> out_gather(1024, 1024), out_scalar(1024, 1024);
+
+    f.compile_jit(without_gather);
+    f.realize(out_scalar);
+    double t_scalar = benchmark(3, 10, [&]() { f.realize(out_scalar); });
+
+    f.compile_jit(with_gather);
+    f.realize(out_gather);
+    double t_gather = benchmark(3, 10, [&]() { f.realize(out_gather); });
+
+    for (int y = 0; y < out_gather.height(); y++) {
+        for (int x = 0; x < out_gather.width(); x++) {
+            if (out_gather(x, y) != out_scalar(x, y)) {
+                printf("%s: out(%d, %d) = %f instead of %f\n", name, x, y,
+                       (double)out_gather(x, y), (double)out_scalar(x, y));
+                return false;
+            }
+        }
+    }
+
+    printf("%s: %f ms with gathers, %f ms without (%.2fx)\n", name,
+           t_gather * 1e3, t_scalar * 1e3, t_scalar / t_gather);
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (!target.has_feature(Target::AVX2)) {
+        printf("Not running test because target doesn't have avx2\n");
+        return 0;
+    }
+
+    Var x("x"), y("y");
+
+    // A lookup table indexed by the input.
+    {
+        Image<int> input(1024, 1024);
+        Image<int> table(4096);
+        for (int y = 0; y < input.height(); y++) {
+            for (int x = 0; x < input.width(); x++) {
+                input(x, y) = rand() & 4095;
+            }
+        }
+        for (int i = 0; i < table.width(); i++) {
+            table(i) = rand();
+        }
+
+        Func lut("lut");
+        lut(x, y) = table(input(x, y));
+        lut.vectorize(x, 8);
+
+        if (!compare<int>(lut, "lut")) {
+            return -1;
+        }
+    }
+
+    // A remap of a float image through a coordinate map.
+    {
+        Image<float> input(1024, 1024);
+        Image<int> map_x(1024, 1024), map_y(1024, 1024);
+        for (int y = 0; y < input.height(); y++) {
+            for (int x = 0; x < input.width(); x++) {
+                input(x, y) = (float)rand() / RAND_MAX;
+                map_x(x, y) = rand() & 1023;
+                map_y(x, y) = rand() & 1023;
+            }
+        }
+
+        Func remap("remap");
+        remap(x, y) = input(map_x(x, y), map_y(x, y)) * 2.0f;
+        remap.vectorize(x, 8);
+
+        if (!compare<float>(remap, "remap")) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Compare two files of compile stats, as written by Halide when
+// HL_COMPILE_STATS is set, and fail if any stat of any pipeline got
+// worse by more than a threshold.
+//
+// Usage: compare_compile_stats current.json baseline.json [threshold] [min_seconds]
+//
+// The threshold is a ratio (e.g. 1.2 allows stats to grow by 20%).
+// Times shorter than min_seconds in the baseline are too noisy to
+// compare, so they're only reported. Pipelines compiled more than once
+// have their times and node counts summed.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <stdio.h>
+#include <string>
+
+typedef std::map<std::string, std::map<std::string, double> > Stats;
+
+// Parse the string starting at the quote at pos, and move pos past it.
+std::string parse_string(const std::string &line, size_t &pos) {
+    size_t end = line.find('"', pos + 1);
+    if (end == std::string::npos) end = line.size();
+    std::string result = line.substr(pos + 1, end - pos - 1);
+    pos = end + 1;
+    return result;
+}
+
+bool load(const char *filename, Stats &stats) {
+    std::ifstream f(filename);
+    if (!f.is_open()) {
+        fprintf(stderr, "Could not open %s\n", filename);
+        return false;
+    }
+    std::string line;
+    while (std::getline(f, line)) {
+        std::string pipeline;
+        std::map<std::string, double> record;
+        size_t pos = line.find('"');
+        while (pos != std::string::npos) {
+            std::string key = parse_string(line, pos);
+            pos = line.find_first_not_of(" :", pos);
+            if (pos == std::string::npos) break;
+            if (line[pos] == '"') {
+                std::string value = parse_string(line, pos);
+                if (key == "pipeline") pipeline = value;
+            } else {
+                record[key] = atof(line.c_str() + pos);
+            }
+            pos = line.find('"', pos);
+        }
+        if (pipeline.empty()) continue;
+
+        std::map<std::string, double> &s = stats[pipeline];
+        for (std::map<std::string, double>::iterator iter = record.begin();
+             iter != record.end(); iter++) {
+            if (iter->first == "peak_rss_kb") {
+                s[iter->first] = std::max(s[iter->first], iter->second);
+            } else {
+                s[iter->first] += iter->second;
+            }
+        }
+    }
+    return true;
+}
+
+bool is_time(const std::string &name) {
+    const std::string suffix = "_seconds";
+    return name.size() > suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s current.json baseline.json [threshold] [min_seconds]\n", argv[0]);
+        return 1;
+    }
+    double threshold = argc > 3 ? atof(argv[3]) : 1.2;
+    double min_seconds = argc > 4 ? atof(argv[4]) : 0.05;
+
+    Stats current, baseline;
+    if (!load(argv[1], current) || !load(argv[2], baseline)) {
+        return 1;
+    }
+
+    int regressions = 0;
+    printf("%-32s %-28s %14s %14s %8s\n", "pipeline", "stat", "baseline", "current", "ratio");
+    for (Stats::iterator p = baseline.begin(); p != baseline.end(); p++) {
+        Stats::iterator c = current.find(p->first);
+        if (c == current.end()) {
+            printf("%-32s missing from %s\n", p->first.c_str(), argv[1]);
+            continue;
+        }
+        for (std::map<std::string, double>::iterator s = p->second.begin(); s != p->second.end(); s++) {
+            if (!c->second.count(s->first)) continue;
+            double before = s->second, after = c->second[s->first];
+            double ratio = before > 0 ? after / before : 1;
+            bool noisy = is_time(s->first) && before < min_seconds;
+            bool regressed = !noisy && ratio > threshold;
+            printf("%-32s %-28s %14.4f %14.4f %8.3f%s\n", p->first.c_str(), s->first.c_str(),
+                   before, after, ratio, regressed ? "  REGRESSION" : "");
+            if (regressed) regressions++;
+        }
+    }
+
+    if (regressions) {
+        printf("%d compile stats regressed by more than a factor of %f\n", regressions, threshold);
+        return 1;
+    }
+    printf("No compile stats regressed by more than a factor of %f\n", threshold);
+    return 0;
+}